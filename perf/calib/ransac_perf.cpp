@@ -0,0 +1,180 @@
+// Copyright (c) 2015-2016, Kai Wolf
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include <benchmark/benchmark.h>
+#include <opencv2/core/core.hpp>
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "calibration/ransac.hpp"
+
+using namespace ret::calib;
+
+namespace {
+// same setup as LightDirEstimation: 1000 samples of a contour with a
+// third of them being outliers
+std::vector<contour_point> CreateObservations(const std::size_t num) {
+    const cv::Vec3f light(0.0f, 0.6f, 0.8f);
+    std::mt19937 gen(17);
+    std::normal_distribution<float> normal;
+    std::uniform_int_distribution<int> intensity(0, 255);
+    std::vector<contour_point> observations;
+    while (observations.size() < num) {
+        cv::Vec3f n(normal(gen), normal(gen), normal(gen));
+        n /= cv::norm(n);
+        const auto shading = light.dot(n);
+        if (shading <= 0.0f) {
+            continue;
+        }
+        const auto value = observations.size() % 3 == 0
+                               ? intensity(gen)
+                               : cvRound(255.0f * shading);
+        observations.emplace_back(n, static_cast<unsigned char>(value));
+    }
+    return observations;
+}
+
+// the solver before the rewrite, kept as reference for the timings: the
+// samples and consensus sets are copied, membership is a linear search
+// and the models are fitted with cv::Mat inverses
+class ReferenceRansac {
+  public:
+    ReferenceRansac(const std::vector<contour_point>& observations,
+                    const std::uint32_t seed)
+        : observations_(observations), gen_(seed) {}
+
+    bool getBestModel(const std::size_t iterations, const float threshold,
+                      LightDirectionModel& model) {
+        auto model_found = false;
+        auto best_error  = std::numeric_limits<float>::max();
+        std::vector<contour_point> best_consensus_set;
+        for (std::size_t iteration = 0; iteration < iterations;
+             ++iteration) {
+            std::vector<contour_point> maybe_inliers;
+            std::uniform_int_distribution<std::size_t> draw(
+                0, observations_.size() - 1);
+            for (std::size_t i = 0; i < 3; ++i) {
+                maybe_inliers.push_back(observations_[draw(gen_)]);
+            }
+            auto consensus_set = maybe_inliers;
+            auto candidate     = fit(maybe_inliers, cv::DECOMP_LU);
+            for (const auto& date : observations_) {
+                if (!isMember(date, maybe_inliers) &&
+                    fits(date, candidate, threshold)) {
+                    consensus_set.push_back(date);
+                }
+            }
+
+            candidate = fit(consensus_set, cv::DECOMP_SVD);
+            std::size_t num_fits = 0;
+            for (const auto& date : consensus_set) {
+                num_fits += fits(date, candidate, threshold) ? 1 : 0;
+            }
+            const float error = static_cast<float>(
+                static_cast<std::size_t>(std::numeric_limits<int>::max()) -
+                num_fits);
+            if (error < best_error) {
+                best_consensus_set = consensus_set;
+                model              = candidate;
+                best_error         = error;
+                model_found        = true;
+            }
+        }
+        return model_found;
+    }
+
+  private:
+    static LightDirectionModel fit(const std::vector<contour_point>& points,
+                                   const int method) {
+        cv::Mat I, N;
+        for (const auto& date : points) {
+            I.push_back(static_cast<float>(date.intensity));
+            N.push_back(date.normal);
+        }
+        cv::Mat N1;
+        cv::invert(N.reshape(1, static_cast<int>(points.size())), N1,
+                   method);
+        cv::Mat S = N1 * I;
+        cv::normalize(S, S);
+        return LightDirectionModel(cv::Vec3f(S));
+    }
+
+    static bool isMember(const contour_point& cp,
+                         const std::vector<contour_point>& points) {
+        for (const auto& date : points) {
+            if (cp.normal == date.normal && cp.intensity == date.intensity) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    static bool fits(const contour_point& cp,
+                     const LightDirectionModel& model, const float threshold) {
+        const cv::Vec3f l(model.x, model.y, model.z);
+        return std::abs(l.dot(cp.normal) - cp.intensity / 255.0f) <
+               threshold;
+    }
+
+    const std::vector<contour_point>& observations_;
+    std::mt19937 gen_;
+};
+} // namespace
+
+// sample size, number of iterations
+static void BM_Ransac(benchmark::State& state) {
+    const auto observations =
+        CreateObservations(static_cast<std::size_t>(state.range_x()));
+    const auto iterations = static_cast<std::size_t>(state.range_y());
+    while (state.KeepRunning()) {
+        LightDirectionModel model;
+        Ransac ransac(1);
+        ransac.setObservationSet(observations)
+            .setModel(model)
+            .setIterations(iterations)
+            .setRequiredInliers(3)
+            .setThreshold(0.02f);
+        benchmark::DoNotOptimize(ransac.getBestModel(model));
+    }
+    state.SetItemsProcessed(static_cast<std::size_t>(state.iterations()) *
+                            iterations);
+}
+BENCHMARK(BM_Ransac)->ArgPair(1000, 2000)->ArgPair(10000, 2000);
+
+// same arguments as BM_Ransac, runs the solver before the rewrite
+static void BM_RansacReference(benchmark::State& state) {
+    const auto observations =
+        CreateObservations(static_cast<std::size_t>(state.range_x()));
+    const auto iterations = static_cast<std::size_t>(state.range_y());
+    while (state.KeepRunning()) {
+        LightDirectionModel model;
+        ReferenceRansac ransac(observations, 1);
+        benchmark::DoNotOptimize(ransac.getBestModel(iterations, 0.02f, model));
+    }
+    state.SetItemsProcessed(static_cast<std::size_t>(state.iterations()) *
+                            iterations);
+}
+BENCHMARK(BM_RansacReference)->ArgPair(1000, 2000)->ArgPair(10000, 2000);
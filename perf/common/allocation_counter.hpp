@@ -0,0 +1,37 @@
+// Copyright (c) 2015-2016, Kai Wolf
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#ifndef PERF_COMMON_ALLOCATION_COUNTER_HPP
+#define PERF_COMMON_ALLOCATION_COUNTER_HPP
+
+#include <cstddef>
+
+namespace ret {
+
+namespace perf {
+
+    /** @brief Returns the number of calls to the global operator new since
+      * program start. The perf executable replaces operator new, such that
+      * benchmarks can report the allocations of the measured code */
+    std::size_t GetNumAllocations();
+} // namespace perf
+} // namespace ret
+
+#endif
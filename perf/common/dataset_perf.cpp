@@ -0,0 +1,79 @@
+// Copyright (c) 2015-2016, Kai Wolf
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include <benchmark/benchmark.h>
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include "common/allocation_counter.hpp"
+#include "common/camera.hpp"
+#include "common/dataset.hpp"
+#include "io/assets_path.hpp"
+#include "io/dataset_reader.hpp"
+
+using namespace ret;
+using namespace ret::io;
+
+namespace {
+// access pattern of the former by value getters, which copied the camera
+// vector and a camera per view
+void VisitCopies(const DataSet& ds) {
+    const std::vector<Camera> cameras(ds.getCameras());
+    for (std::size_t idx = 0; idx < cameras.size(); ++idx) {
+        const Camera cam = cameras[idx];
+        benchmark::DoNotOptimize(cam.getImage().data);
+        benchmark::DoNotOptimize(cam.getProjectionMatrix().data);
+    }
+}
+
+void VisitReferences(const DataSet& ds) {
+    for (const auto& cam : ds) {
+        benchmark::DoNotOptimize(cam.getImage().data);
+        benchmark::DoNotOptimize(cam.getProjectionMatrix().data);
+    }
+}
+} // namespace
+
+// 0 copies the cameras as before, 1 accesses them by reference
+static void BM_CameraAccess(benchmark::State& state) {
+    DataSetReader dsr(std::string(ASSETS_PATH) + "/squirrel");
+    const auto ds      = dsr.load(36);
+    const auto by_copy = state.range_x() == 0;
+    const auto num_allocations_before = perf::GetNumAllocations();
+    while (state.KeepRunning()) {
+        if (by_copy) {
+            VisitCopies(*ds);
+        } else {
+            VisitReferences(*ds);
+        }
+    }
+
+    const auto num_allocations =
+        perf::GetNumAllocations() - num_allocations_before;
+    state.SetItemsProcessed(static_cast<std::size_t>(state.iterations()) *
+                            ds->size());
+    state.SetLabel(
+        std::to_string(num_allocations /
+                       static_cast<std::size_t>(state.iterations())) +
+        (by_copy ? " allocations, copy" : " allocations, reference"));
+}
+BENCHMARK(BM_CameraAccess)->Arg(0)->Arg(1);
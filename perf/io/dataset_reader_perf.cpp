@@ -0,0 +1,77 @@
+// Copyright (c) 2015-2016, Kai Wolf
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include <benchmark/benchmark.h>
+
+#include <cstddef>
+#include <string>
+#include <boost/filesystem.hpp>
+
+#include "common/dataset.hpp"
+#include "io/assets_path.hpp"
+#include "io/dataset_container.hpp"
+#include "io/dataset_reader.hpp"
+
+using namespace ret;
+using namespace ret::io;
+
+// number of decoding threads, image loading
+static void LoadArguments(benchmark::internal::Benchmark* b) {
+    for (auto num_threads : {1, 2, 4, 8}) {
+        b->ArgPair(num_threads, static_cast<int>(image_loading::Eager));
+    }
+    b->ArgPair(1, static_cast<int>(image_loading::Lazy));
+}
+
+static void BM_DataSetLoad(benchmark::State& state) {
+    const std::size_t num_imgs = 36;
+    const auto loading         = static_cast<image_loading>(state.range_y());
+    DataSetReader dsr(std::string(ASSETS_PATH) + "/squirrel");
+    dsr.setNumThreads(static_cast<std::size_t>(state.range_x()));
+    dsr.setImageLoading(loading);
+    while (state.KeepRunning()) {
+        auto ds = dsr.load(num_imgs);
+        benchmark::DoNotOptimize(ds->size());
+    }
+
+    state.SetItemsProcessed(static_cast<std::size_t>(state.iterations()) *
+                            num_imgs);
+    state.SetLabel(loading == image_loading::Lazy ? "lazy" : "eager");
+}
+BENCHMARK(BM_DataSetLoad)->Apply(LoadArguments)->UseRealTime();
+
+static void BM_DataSetContainerLoad(benchmark::State& state) {
+    const std::size_t num_imgs = 36;
+    DataSetReader dsr(std::string(ASSETS_PATH) + "/squirrel");
+    const auto path = (boost::filesystem::temp_directory_path() /
+                       boost::filesystem::unique_path()).string();
+    WriteDataSetContainer(*dsr.load(num_imgs), path);
+
+    DataSetContainerReader reader(path);
+    while (state.KeepRunning()) {
+        auto ds = reader.load();
+        benchmark::DoNotOptimize(ds->size());
+    }
+
+    state.SetItemsProcessed(static_cast<std::size_t>(state.iterations()) *
+                            num_imgs);
+    boost::filesystem::remove(path);
+}
+BENCHMARK(BM_DataSetContainerLoad)->UseRealTime();
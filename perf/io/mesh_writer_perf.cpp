@@ -0,0 +1,143 @@
+// Copyright (c) 2015-2016, Kai Wolf
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include <benchmark/benchmark.h>
+#include <vtkPLYWriter.h>
+#include <vtkPolyData.h>
+#include <vtkSmartPointer.h>
+#include <vtkVersion.h>
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <boost/filesystem.hpp>
+
+#include "common/types/vec3f.hpp"
+#include "io/mesh_writer.hpp"
+#include "rendering/surface_extraction.hpp"
+
+using namespace ret;
+using namespace ret::io;
+using namespace ret::rendering;
+
+namespace {
+struct indexed_mesh {
+    std::vector<vec3f> vertices, normals;
+    std::vector<std::uint32_t> indices;
+};
+
+// surface of a sphere filling a voxel grid of the given dimension
+const indexed_mesh& GetSphereMesh(const std::size_t dim) {
+    static std::size_t mesh_dim = 0;
+    static indexed_mesh mesh;
+    if (mesh_dim != dim) {
+        std::vector<float> grid(dim * dim * dim);
+        const auto center = static_cast<float>(dim) / 2.0f;
+        for (std::size_t i = 0; i < dim; ++i) {
+            for (std::size_t j = 0; j < dim; ++j) {
+                for (std::size_t k = 0; k < dim; ++k) {
+                    const auto x = static_cast<float>(k) - center;
+                    const auto y = static_cast<float>(j) - center;
+                    const auto z = static_cast<float>(i) - center;
+                    grid[k + j * dim + i * dim * dim] =
+                        0.4f * dim - std::sqrt(x * x + y * y + z * z);
+                }
+            }
+        }
+        const start_params params = {0.0f, 0.0f, 0.0f, 1.0f, 1.0f, 1.0f};
+        ExtractIndexedSurface(grid.data(), dim, dim, dim, params, 0.0f,
+                              mesh.vertices, mesh.normals, mesh.indices);
+        mesh_dim = dim;
+    }
+    return mesh;
+}
+
+std::string TempPath() {
+    return (boost::filesystem::temp_directory_path() /
+            boost::filesystem::unique_path())
+        .string();
+}
+
+void FinishWriting(benchmark::State& state, const std::string& path) {
+    state.SetBytesProcessed(static_cast<std::size_t>(state.iterations()) *
+                            boost::filesystem::file_size(path));
+    boost::filesystem::remove(path);
+}
+}
+
+// voxel grid dimension of the sphere mesh
+static void BM_MeshWritePLY(benchmark::State& state) {
+    const auto dim   = static_cast<std::size_t>(state.range_x());
+    const auto& mesh = GetSphereMesh(dim);
+    const auto path  = TempPath();
+    while (state.KeepRunning()) {
+        WritePLY(path, mesh.vertices, mesh.normals, mesh.indices);
+    }
+    FinishWriting(state, path);
+}
+BENCHMARK(BM_MeshWritePLY)->Arg(128)->Arg(256);
+
+static void BM_MeshWriteOBJ(benchmark::State& state) {
+    const auto dim   = static_cast<std::size_t>(state.range_x());
+    const auto& mesh = GetSphereMesh(dim);
+    const auto path  = TempPath();
+    while (state.KeepRunning()) {
+        WriteOBJ(path, mesh.vertices, mesh.normals, mesh.indices);
+    }
+    FinishWriting(state, path);
+}
+BENCHMARK(BM_MeshWriteOBJ)->Arg(128)->Arg(256);
+
+static void BM_MeshWritePolyDataPLY(benchmark::State& state) {
+    const auto dim   = static_cast<std::size_t>(state.range_x());
+    const auto& mesh = GetSphereMesh(dim);
+    auto poly_data =
+        CreatePolyData(mesh.vertices, mesh.normals, mesh.indices);
+    const auto path = TempPath();
+    while (state.KeepRunning()) {
+        WritePLY(path, poly_data);
+    }
+    FinishWriting(state, path);
+}
+BENCHMARK(BM_MeshWritePolyDataPLY)->Arg(128)->Arg(256);
+
+// vtk writes the same binary PLY as WritePLY(vtkPolyData*)
+static void BM_MeshWriteVtkPLY(benchmark::State& state) {
+    const auto dim   = static_cast<std::size_t>(state.range_x());
+    const auto& mesh = GetSphereMesh(dim);
+    auto poly_data =
+        CreatePolyData(mesh.vertices, mesh.normals, mesh.indices);
+    const auto path = TempPath();
+    while (state.KeepRunning()) {
+        auto writer = vtkSmartPointer<vtkPLYWriter>::New();
+#if VTK_MAJOR_VERSION < 6
+        writer->SetInput(poly_data);
+#else
+        writer->SetInputData(poly_data);
+#endif
+        writer->SetFileName(path.c_str());
+        writer->SetFileTypeToBinary();
+        writer->Write();
+    }
+    FinishWriting(state, path);
+}
+BENCHMARK(BM_MeshWriteVtkPLY)->Arg(128)->Arg(256);
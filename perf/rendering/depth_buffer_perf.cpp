@@ -0,0 +1,76 @@
+// Copyright (c) 2015-2016, Kai Wolf
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include <benchmark/benchmark.h>
+#include <opencv2/core/core.hpp>
+#include <vtkPolyData.h>
+#include <vtkSmartPointer.h>
+
+#include <memory>
+#include <string>
+
+#include "common/dataset.hpp"
+#include "common/utils.hpp"
+#include "filtering/preprocessing.hpp"
+#include "io/assets_path.hpp"
+#include "io/dataset_reader.hpp"
+#include "rendering/bounding_box.hpp"
+#include "rendering/depth_buffer.hpp"
+#include "rendering/voxel_carving.hpp"
+
+using namespace ret;
+using namespace ret::io;
+using namespace ret::filtering;
+using namespace ret::rendering;
+
+// voxel grid dimension, number of threads
+static void MeshVisibilityArguments(benchmark::internal::Benchmark* b) {
+    for (auto voxel_dim : {128, 256, 512}) {
+        for (auto num_threads : {1, 2, 4, 8}) {
+            b->ArgPair(voxel_dim, num_threads);
+        }
+    }
+}
+
+// renders the visual hull into all 36 views of the data set
+static void BM_MeshVisibility(benchmark::State& state) {
+    const int num_imgs = 36;
+
+    DataSetReader dsr(std::string(ASSETS_PATH) + "/squirrel");
+    auto ds = dsr.load(num_imgs);
+    Preprocess(*ds, cv::Scalar(0, 0, 30), 0, false);
+    BoundingBox bbox =
+        BoundingBox(ds->getCamera(0), ds->getCamera((num_imgs / 4) - 1));
+    auto vc = ret::make_unique<VoxelCarving>(
+        bbox.getBounds(), static_cast<std::size_t>(state.range_x()));
+    vc->carveAll(ds->getCameras());
+    auto mesh = vc->createVisualHull();
+
+    while (state.KeepRunning()) {
+        MeshVisibility visibility(mesh, ds->getCameras(),
+                                  static_cast<std::size_t>(state.range_y()));
+        benchmark::DoNotOptimize(visibility.getNumVisible(0));
+    }
+
+    state.SetItemsProcessed(static_cast<std::size_t>(state.iterations()) *
+                            num_imgs * mesh->GetNumberOfPolys());
+    state.SetLabel(std::to_string(mesh->GetNumberOfPolys()) + " triangles");
+}
+BENCHMARK(BM_MeshVisibility)->Apply(MeshVisibilityArguments)->UseRealTime();
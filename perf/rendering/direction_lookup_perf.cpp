@@ -0,0 +1,91 @@
+// Copyright (c) 2015-2016, Kai Wolf
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include <benchmark/benchmark.h>
+#include <opencv2/core/core.hpp>
+
+#include <cstddef>
+#include <random>
+#include <vector>
+
+#include "rendering/direction_lookup.hpp"
+
+using namespace ret::rendering;
+
+namespace {
+const std::size_t NUM_NORMALS = 100000;
+
+std::vector<cv::Vec3d> RandomDirections(const std::size_t num,
+                                        const unsigned seed) {
+    std::mt19937 gen(seed);
+    std::normal_distribution<double> dist;
+    std::vector<cv::Vec3d> directions(num);
+    for (auto& dir : directions) {
+        dir = cv::Vec3d(dist(gen), dist(gen), dist(gen));
+        dir /= cv::norm(dir);
+    }
+    return directions;
+}
+
+std::vector<cv::Vec3f> CameraDirections(const std::size_t num_cams) {
+    const auto directions = RandomDirections(num_cams, 5);
+    return std::vector<cv::Vec3f>(directions.begin(), directions.end());
+}
+} // namespace
+
+// best camera per normal by scanning all cameras
+static void BM_BestCameraScan(benchmark::State& state) {
+    const auto cams =
+        CameraDirections(static_cast<std::size_t>(state.range_x()));
+    const auto normals = RandomDirections(NUM_NORMALS, 7);
+    while (state.KeepRunning()) {
+        for (const auto& normal : normals) {
+            auto best_dot    = -2.0;
+            std::size_t best = 0;
+            for (std::size_t c = 0; c < cams.size(); ++c) {
+                const auto dot = normal.dot(cv::Vec3d(cams[c]));
+                if (dot > best_dot) {
+                    best_dot = dot;
+                    best     = c;
+                }
+            }
+            benchmark::DoNotOptimize(best);
+        }
+    }
+    state.SetItemsProcessed(static_cast<std::size_t>(state.iterations()) *
+                            NUM_NORMALS);
+}
+BENCHMARK(BM_BestCameraScan)->Arg(36)->Arg(144);
+
+static void BM_BestCameraLookup(benchmark::State& state) {
+    const DirectionLookup lookup(
+        CameraDirections(static_cast<std::size_t>(state.range_x())), 1);
+    const auto normals = RandomDirections(NUM_NORMALS, 7);
+    while (state.KeepRunning()) {
+        for (const auto& normal : normals) {
+            std::size_t best = 0;
+            lookup.findBest(normal, &best, 1);
+            benchmark::DoNotOptimize(best);
+        }
+    }
+    state.SetItemsProcessed(static_cast<std::size_t>(state.iterations()) *
+                            NUM_NORMALS);
+}
+BENCHMARK(BM_BestCameraLookup)->Arg(36)->Arg(144);
@@ -0,0 +1,150 @@
+// Copyright (c) 2015-2016, Kai Wolf
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include <benchmark/benchmark.h>
+#include <opencv2/core/core.hpp>
+#include <vtkPolyData.h>
+#include <vtkSmartPointer.h>
+#include <vtkType.h>
+
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include "common/dataset.hpp"
+#include "common/utils.hpp"
+#include "filtering/preprocessing.hpp"
+#include "io/assets_path.hpp"
+#include "io/dataset_reader.hpp"
+#include "rendering/bounding_box.hpp"
+#include "rendering/mc/marching_cubes.hpp"
+#include "rendering/voxel_carving.hpp"
+
+using namespace ret;
+using namespace ret::io;
+using namespace ret::filtering;
+using namespace ret::rendering;
+
+// voxel grid dimension, number of extraction threads
+static void MarchingCubesArguments(benchmark::internal::Benchmark* b) {
+    for (auto voxel_dim : {128, 256, 512}) {
+        for (auto num_threads : {1, 2, 4, 8}) {
+            b->ArgPair(voxel_dim, num_threads);
+        }
+    }
+}
+
+static void BM_MarchingCubes(benchmark::State& state) {
+    const int num_imgs  = 36;
+    const int voxel_dim = state.range_x();
+
+    DataSetReader dsr(std::string(ASSETS_PATH) + "/squirrel");
+    auto ds = dsr.load(num_imgs);
+    Preprocess(*ds, cv::Scalar(0, 0, 30));
+    BoundingBox bbox =
+        BoundingBox(ds->getCamera(0), ds->getCamera((num_imgs / 4) - 1));
+    auto vc = ret::make_unique<VoxelCarving>(bbox.getBounds(), voxel_dim);
+    vc->carveAll(ds->getCameras());
+
+    mc::MarchingCubes mc(0.0f, 0.0f, 0.0f, 1.0f, 1.0f, 1.0f, 0.0f, voxel_dim,
+                         voxel_dim, voxel_dim);
+    mc.setNumThreads(static_cast<std::size_t>(state.range_y()));
+    while (state.KeepRunning()) {
+        mc.execute(vc->getVoxelGrid());
+    }
+
+    state.SetItemsProcessed(static_cast<std::size_t>(state.iterations()) *
+                            voxel_dim * voxel_dim * voxel_dim);
+    state.SetLabel(std::to_string(mc.getTriangles().size()) + " triangles");
+}
+BENCHMARK(BM_MarchingCubes)->Apply(MarchingCubesArguments)->UseRealTime();
+
+static void BM_MarchingCubesIndexed(benchmark::State& state) {
+    const int num_imgs  = 36;
+    const int voxel_dim = state.range_x();
+
+    DataSetReader dsr(std::string(ASSETS_PATH) + "/squirrel");
+    auto ds = dsr.load(num_imgs);
+    Preprocess(*ds, cv::Scalar(0, 0, 30));
+    BoundingBox bbox =
+        BoundingBox(ds->getCamera(0), ds->getCamera((num_imgs / 4) - 1));
+    auto vc = ret::make_unique<VoxelCarving>(bbox.getBounds(), voxel_dim);
+    vc->carveAll(ds->getCameras());
+
+    mc::MarchingCubes mc(0.0f, 0.0f, 0.0f, 1.0f, 1.0f, 1.0f, 0.0f, voxel_dim,
+                         voxel_dim, voxel_dim);
+    mc.setNumThreads(static_cast<std::size_t>(state.range_y()));
+    while (state.KeepRunning()) {
+        mc.executeIndexed(vc->getVoxelGrid());
+    }
+
+    // memory of the indexed mesh compared to the triangle soup
+    const auto indexed_size = mc.getVertices().size() * 2 * sizeof(vec3f) +
+                              mc.getIndices().size() * sizeof(std::uint32_t);
+    const auto soup_size = mc.getIndices().size() / 3 * sizeof(triangle);
+    state.SetItemsProcessed(static_cast<std::size_t>(state.iterations()) *
+                            voxel_dim * voxel_dim * voxel_dim);
+    state.SetLabel(std::to_string(mc.getVertices().size()) + " vertices, " +
+                   std::to_string(indexed_size >> 10) + " KB vs " +
+                   std::to_string(soup_size >> 10) + " KB");
+}
+BENCHMARK(BM_MarchingCubesIndexed)
+    ->Apply(MarchingCubesArguments)
+    ->UseRealTime();
+
+// voxel grid dimension, surface extraction backend
+static void BackendArguments(benchmark::internal::Benchmark* b) {
+    for (auto voxel_dim : {128, 256, 512}) {
+        for (auto backend : {surface_backend::Vtk, surface_backend::InTree}) {
+            b->ArgPair(voxel_dim, static_cast<int>(backend));
+        }
+    }
+}
+
+static void BM_CreateVisualHull(benchmark::State& state) {
+    const int num_imgs  = 36;
+    const int voxel_dim = state.range_x();
+    const auto backend  = static_cast<surface_backend>(state.range_y());
+
+    DataSetReader dsr(std::string(ASSETS_PATH) + "/squirrel");
+    auto ds = dsr.load(num_imgs);
+    Preprocess(*ds, cv::Scalar(0, 0, 30));
+    BoundingBox bbox =
+        BoundingBox(ds->getCamera(0), ds->getCamera((num_imgs / 4) - 1));
+    auto vc = ret::make_unique<VoxelCarving>(bbox.getBounds(), voxel_dim);
+    vc->carveAll(ds->getCameras());
+    vc->setSurfaceBackend(backend);
+
+    vtkIdType num_polys = 0;
+    while (state.KeepRunning()) {
+        auto mesh = vc->createVisualHull();
+
+        state.PauseTiming();
+        num_polys = mesh->GetNumberOfPolys();
+        state.ResumeTiming();
+    }
+
+    state.SetItemsProcessed(static_cast<std::size_t>(state.iterations()) *
+                            voxel_dim * voxel_dim * voxel_dim);
+    state.SetLabel(std::string(backend == surface_backend::Vtk ? "vtk"
+                                                               : "in-tree") +
+                   ", " + std::to_string(num_polys) + " triangles");
+}
+BENCHMARK(BM_CreateVisualHull)->Apply(BackendArguments)->UseRealTime();
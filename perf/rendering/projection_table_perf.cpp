@@ -0,0 +1,109 @@
+// Copyright (c) 2015-2016, Kai Wolf
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include <benchmark/benchmark.h>
+#include <opencv2/core/core.hpp>
+
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "common/dataset.hpp"
+#include "io/assets_path.hpp"
+#include "io/dataset_reader.hpp"
+#include "rendering/cv_utils.hpp"
+#include "rendering/projection_table.hpp"
+
+using namespace ret;
+using namespace ret::io;
+using namespace ret::rendering;
+
+namespace {
+const std::size_t NUM_POINTS = 4096;
+
+std::shared_ptr<DataSet> LoadCameras(const std::size_t num_imgs) {
+    DataSetReader dsr(std::string(ASSETS_PATH) + "/squirrel");
+    dsr.setImageLoading(image_loading::Lazy);
+    return dsr.load(num_imgs);
+}
+
+std::vector<cv::Point3f> RandomPoints() {
+    std::mt19937 gen(42);
+    std::uniform_real_distribution<float> dist(-20.0f, 20.0f);
+    std::vector<cv::Point3f> points(NUM_POINTS);
+    for (auto& pt : points) {
+        pt = cv::Point3f(dist(gen), dist(gen), dist(gen));
+    }
+    return points;
+}
+} // namespace
+
+// projects every point into every camera through the projection matrix
+static void BM_ProjectMat(benchmark::State& state) {
+    const auto ds     = LoadCameras(static_cast<std::size_t>(state.range_x()));
+    const auto& cams  = ds->getCameras();
+    const auto points = RandomPoints();
+    while (state.KeepRunning()) {
+        for (const auto& pt : points) {
+            for (const auto& cam : cams) {
+                benchmark::DoNotOptimize(
+                    project<cv::Point2f, cv::Point3f>(cam, pt));
+            }
+        }
+    }
+    state.SetItemsProcessed(static_cast<std::size_t>(state.iterations()) *
+                            NUM_POINTS * cams.size());
+}
+BENCHMARK(BM_ProjectMat)->Arg(12)->Arg(36);
+
+static void BM_ProjectTable(benchmark::State& state) {
+    const auto ds     = LoadCameras(static_cast<std::size_t>(state.range_x()));
+    const ProjectionTable table(*ds);
+    const auto points = RandomPoints();
+    while (state.KeepRunning()) {
+        for (const auto& pt : points) {
+            for (std::size_t c = 0; c < table.size(); ++c) {
+                benchmark::DoNotOptimize(
+                    table.project<cv::Point2f, cv::Point3f>(c, pt));
+            }
+        }
+    }
+    state.SetItemsProcessed(static_cast<std::size_t>(state.iterations()) *
+                            NUM_POINTS * table.size());
+}
+BENCHMARK(BM_ProjectTable)->Arg(12)->Arg(36);
+
+static void BM_ProjectTableAll(benchmark::State& state) {
+    const auto ds     = LoadCameras(static_cast<std::size_t>(state.range_x()));
+    const ProjectionTable table(*ds);
+    const auto points = RandomPoints();
+    std::vector<float> x(table.size()), y(table.size());
+    while (state.KeepRunning()) {
+        for (const auto& pt : points) {
+            table.projectAll(pt, x.data(), y.data());
+            benchmark::DoNotOptimize(x.data());
+            benchmark::DoNotOptimize(y.data());
+        }
+    }
+    state.SetItemsProcessed(static_cast<std::size_t>(state.iterations()) *
+                            NUM_POINTS * table.size());
+}
+BENCHMARK(BM_ProjectTableAll)->Arg(12)->Arg(36);
@@ -23,16 +23,25 @@
 
 #include <cmath>
 #include <memory>
+#include <string>
 
+#include "common/allocation_counter.hpp"
 #include "common/dataset.hpp"
 #include "common/utils.hpp"
+#include "filtering/dist_map_cache.hpp"
+#include "filtering/preprocessing.hpp"
 #include "filtering/segmentation.hpp"
 #include "gui/main_window.hpp"
 #include "io/assets_path.hpp"
 #include "io/dataset_reader.hpp"
 #include "rendering/bounding_box.hpp"
+#include "rendering/carving_pipeline.hpp"
 #include "rendering/mesh_coloring.hpp"
+#include "rendering/octree_carving.hpp"
+#include "rendering/sparse_voxel_grid.hpp"
 #include "rendering/voxel_carving.hpp"
+#include "rendering/voxel_carving_kernel.hpp"
+#include "rendering/voxel_type.hpp"
 
 using namespace ret;
 using namespace ret::io;
@@ -55,17 +64,43 @@ static void BM_ImageSegmentation(benchmark::State& state) {
 }
 BENCHMARK(BM_ImageSegmentation);
 
+// number of preprocessing threads, distance maps off/on
+static void PreprocessArguments(benchmark::internal::Benchmark* b) {
+    for (auto dist_maps : {0, 1}) {
+        for (auto num_threads : {1, 2, 4, 8}) {
+            b->ArgPair(num_threads, dist_maps);
+        }
+    }
+}
+
+static void BM_ImageSegmentationParallel(benchmark::State& state) {
+    const int num_imgs          = 36;
+    const auto num_threads      = static_cast<std::size_t>(state.range_x());
+    const bool create_dist_maps = state.range_y() != 0;
+    while (state.KeepRunning()) {
+        state.PauseTiming();
+        DataSetReader dsr(std::string(ASSETS_PATH) + "/squirrel");
+        auto ds = dsr.load(num_imgs);
+
+        state.ResumeTiming();
+        Preprocess(*ds, cv::Scalar(0, 0, 30), num_threads, create_dist_maps);
+    }
+
+    state.SetItemsProcessed(static_cast<std::size_t>(state.iterations()) *
+                            num_imgs);
+    state.SetLabel(create_dist_maps ? "masks, distance maps" : "masks");
+}
+BENCHMARK(BM_ImageSegmentationParallel)
+    ->Apply(PreprocessArguments)
+    ->UseRealTime();
+
 static void BM_BoundingBox(benchmark::State& state) {
     while (state.KeepRunning()) {
         state.PauseTiming();
         const int num_imgs = 36;
         DataSetReader dsr(std::string(ASSETS_PATH) + "/squirrel");
         auto ds = dsr.load(num_imgs);
-
-        for (auto idx = 0; idx < num_imgs; ++idx) {
-            ds->getCamera(idx).setMask(Binarize(
-                ds->getCamera(idx).getImage(), cv::Scalar(0, 0, 30)));
-        }
+        Preprocess(*ds, cv::Scalar(0, 0, 30), 0, false);
         state.ResumeTiming();
         BoundingBox bbox =
             BoundingBox(ds->getCamera(0), ds->getCamera((num_imgs / 4) - 1));
@@ -74,48 +109,273 @@ static void BM_BoundingBox(benchmark::State& state) {
 }
 BENCHMARK(BM_BoundingBox);
 
+// voxel grid dimension, number of carving threads
+static void CarvingArguments(benchmark::internal::Benchmark* b) {
+    for (auto voxel_dim : {128, 256}) {
+        for (auto num_threads : {1, 2, 4, 8}) {
+            b->ArgPair(voxel_dim, num_threads);
+        }
+    }
+}
+
 static void BM_VoxelCarving(benchmark::State& state) {
+    const int num_imgs  = 36;
+    const int voxel_dim = state.range_x();
     while (state.KeepRunning()) {
         state.PauseTiming();
-        const int num_imgs = 36;
         DataSetReader dsr(std::string(ASSETS_PATH) + "/squirrel");
         auto ds = dsr.load(num_imgs);
+        Preprocess(*ds, cv::Scalar(0, 0, 30), 0, false);
+        BoundingBox bbox =
+            BoundingBox(ds->getCamera(0), ds->getCamera((num_imgs / 4) - 1));
+        auto vc = ret::make_unique<VoxelCarving>(bbox.getBounds(), voxel_dim);
+        vc->setNumThreads(static_cast<std::size_t>(state.range_y()));
+        state.ResumeTiming();
+        for (const auto &cam : ds->getCameras()) vc->carve(cam);
+    }
 
-        for (auto idx = 0; idx < num_imgs; ++idx) {
-            ds->getCamera(idx).setMask(Binarize(
-                ds->getCamera(idx).getImage(), cv::Scalar(0, 0, 30)));
+    // number of projected voxels, i.e. voxel_dim^3 for every camera
+    state.SetItemsProcessed(static_cast<std::size_t>(state.iterations()) *
+                            num_imgs * voxel_dim * voxel_dim * voxel_dim);
+    state.SetLabel(GetCarveISAName(GetCarveISA()));
+}
+BENCHMARK(BM_VoxelCarving)->Apply(CarvingArguments)->UseRealTime();
+
+static void BM_VoxelCarvingFused(benchmark::State& state) {
+    const int num_imgs  = 36;
+    const int voxel_dim = state.range_x();
+    while (state.KeepRunning()) {
+        state.PauseTiming();
+        DataSetReader dsr(std::string(ASSETS_PATH) + "/squirrel");
+        auto ds = dsr.load(num_imgs);
+        Preprocess(*ds, cv::Scalar(0, 0, 30), 0, false);
+        BoundingBox bbox =
+            BoundingBox(ds->getCamera(0), ds->getCamera((num_imgs / 4) - 1));
+        auto vc = ret::make_unique<VoxelCarving>(bbox.getBounds(), voxel_dim);
+        vc->setNumThreads(static_cast<std::size_t>(state.range_y()));
+        const auto& cams = ds->getCameras();
+        state.ResumeTiming();
+        vc->carveAll(cams);
+    }
+
+    state.SetItemsProcessed(static_cast<std::size_t>(state.iterations()) *
+                            num_imgs * voxel_dim * voxel_dim * voxel_dim);
+    state.SetLabel(GetCarveISAName(GetCarveISA()));
+}
+BENCHMARK(BM_VoxelCarvingFused)->Apply(CarvingArguments)->UseRealTime();
+
+static void BM_VoxelCarvingNarrowBand(benchmark::State& state) {
+    const int num_imgs  = 36;
+    const int voxel_dim = state.range_x();
+    std::size_t memory_usage = 0;
+    while (state.KeepRunning()) {
+        state.PauseTiming();
+        DataSetReader dsr(std::string(ASSETS_PATH) + "/squirrel");
+        auto ds = dsr.load(num_imgs);
+        Preprocess(*ds, cv::Scalar(0, 0, 30), 0, false);
+        BoundingBox bbox =
+            BoundingBox(ds->getCamera(0), ds->getCamera((num_imgs / 4) - 1));
+        auto vc = ret::make_unique<VoxelCarving>(bbox.getBounds(), voxel_dim,
+                                                 10.0f);
+        vc->setNumThreads(static_cast<std::size_t>(state.range_y()));
+        const auto& cams = ds->getCameras();
+        state.ResumeTiming();
+        vc->carveAll(cams);
+
+        state.PauseTiming();
+        memory_usage = vc->getMemoryUsage();
+        state.ResumeTiming();
+    }
+
+    state.SetItemsProcessed(static_cast<std::size_t>(state.iterations()) *
+                            num_imgs * voxel_dim * voxel_dim * voxel_dim);
+    state.SetLabel(std::to_string(memory_usage >> 20) + " MB");
+}
+BENCHMARK(BM_VoxelCarvingNarrowBand)->Apply(CarvingArguments)->UseRealTime();
+
+// voxel grid dimension, voxel type
+static void QuantizedArguments(benchmark::internal::Benchmark* b) {
+    for (auto voxel_dim : {128, 256}) {
+        for (auto type :
+             {voxel_type::Float, voxel_type::Half, voxel_type::Q15}) {
+            b->ArgPair(voxel_dim, static_cast<int>(type));
         }
+    }
+}
+
+static void BM_VoxelCarvingQuantized(benchmark::State& state) {
+    const int num_imgs  = 36;
+    const int voxel_dim = state.range_x();
+    const auto type     = static_cast<voxel_type>(state.range_y());
+    std::size_t memory_usage = 0;
+    while (state.KeepRunning()) {
+        state.PauseTiming();
+        DataSetReader dsr(std::string(ASSETS_PATH) + "/squirrel");
+        auto ds = dsr.load(num_imgs);
+        Preprocess(*ds, cv::Scalar(0, 0, 30), 0, false);
         BoundingBox bbox =
             BoundingBox(ds->getCamera(0), ds->getCamera((num_imgs / 4) - 1));
-        auto vc = ret::make_unique<VoxelCarving>(bbox.getBounds(), 128);
+        auto vc = ret::make_unique<VoxelCarving>(bbox.getBounds(), voxel_dim,
+                                                 type);
+        const auto& cams = ds->getCameras();
+        state.ResumeTiming();
+        vc->carveAll(cams);
+
+        state.PauseTiming();
+        memory_usage = vc->getMemoryUsage();
         state.ResumeTiming();
-        for (const auto &cam : ds->getCameras()) vc->carve(cam);
     }
+
+    state.SetItemsProcessed(static_cast<std::size_t>(state.iterations()) *
+                            num_imgs * voxel_dim * voxel_dim * voxel_dim);
+    state.SetLabel(std::string(GetVoxelTypeName(type)) + ", " +
+                   std::to_string(memory_usage >> 20) + " MB");
 }
-BENCHMARK(BM_VoxelCarving);
+BENCHMARK(BM_VoxelCarvingQuantized)->Apply(QuantizedArguments)->UseRealTime();
 
-static void BM_ColorMesh(benchmark::State& state) {
+// re-carves the camera set at several resolutions, with and without a
+// shared distance map cache
+static void BM_VoxelCarvingResolutions(benchmark::State& state) {
+    const int num_imgs = 36;
+    const bool cached  = state.range_x() != 0;
+    std::size_t hits = 0, misses = 0;
     while (state.KeepRunning()) {
         state.PauseTiming();
-        const int num_imgs = 36;
         DataSetReader dsr(std::string(ASSETS_PATH) + "/squirrel");
         auto ds = dsr.load(num_imgs);
+        Preprocess(*ds, cv::Scalar(0, 0, 30), 0, false);
+        BoundingBox bbox =
+            BoundingBox(ds->getCamera(0), ds->getCamera((num_imgs / 4) - 1));
+        auto cache = cached ? std::make_shared<DistMapCache>() : nullptr;
+        const auto& cams = ds->getCameras();
+        state.ResumeTiming();
+        for (auto voxel_dim : {32, 64, 128}) {
+            auto vc =
+                ret::make_unique<VoxelCarving>(bbox.getBounds(), voxel_dim);
+            vc->setDistMapCache(cache);
+            vc->carveAll(cams);
+        }
 
-        for (auto idx = 0; idx < num_imgs; ++idx) {
-            ds->getCamera(idx).setMask(Binarize(
-                ds->getCamera(idx).getImage(), cv::Scalar(0, 0, 30)));
+        state.PauseTiming();
+        if (cache) {
+            hits   = cache->getHits();
+            misses = cache->getMisses();
+        }
+        state.ResumeTiming();
+    }
+
+    state.SetLabel(std::to_string(hits) + " hits, " +
+                   std::to_string(misses) + " misses");
+}
+BENCHMARK(BM_VoxelCarvingResolutions)->Arg(0)->Arg(1)->UseRealTime();
+
+// decodes, segments and carves the data set end to end, either one stage
+// after another or streaming, see CarveStreaming
+static void BM_VoxelCarvingEndToEnd(benchmark::State& state) {
+    const std::size_t num_imgs = 36;
+    const int voxel_dim        = state.range_x();
+    const bool streaming       = state.range_y() != 0;
+    const cv::Scalar thresh(0, 0, 30);
+
+    // the bounding box is needed upfront when streaming
+    DataSetReader dsr(std::string(ASSETS_PATH) + "/squirrel");
+    bb_bounds bounds;
+    {
+        auto ds = dsr.load(num_imgs);
+        Preprocess(*ds, thresh, 0, false);
+        bounds = BoundingBox(ds->getCamera(0),
+                             ds->getCamera((num_imgs / 4) - 1))
+                     .getBounds();
+    }
+
+    while (state.KeepRunning()) {
+        auto vc = ret::make_unique<VoxelCarving>(bounds, voxel_dim);
+        if (streaming) {
+            CarveStreaming(dsr, num_imgs, thresh, *vc);
+        } else {
+            auto ds = dsr.load(num_imgs);
+            Preprocess(*ds, thresh, 1);
+            for (const auto &cam : ds->getCameras()) vc->carve(cam);
         }
+    }
+
+    state.SetLabel(streaming ? "streaming" : "sequential");
+}
+BENCHMARK(BM_VoxelCarvingEndToEnd)
+    ->ArgPair(128, 0)
+    ->ArgPair(128, 1)
+    ->ArgPair(256, 0)
+    ->ArgPair(256, 1)
+    ->UseRealTime();
+
+// voxel grid dimension, number of carving threads
+static void OctreeCarvingArguments(benchmark::internal::Benchmark* b) {
+    for (auto voxel_dim : {128, 256, 512, 1024}) {
+        for (auto num_threads : {1, 4}) {
+            b->ArgPair(voxel_dim, num_threads);
+        }
+    }
+}
+
+static void BM_OctreeCarving(benchmark::State& state) {
+    const int num_imgs  = 36;
+    const int voxel_dim = state.range_x();
+    std::size_t num_allocated = 0, num_bricks = 0;
+    while (state.KeepRunning()) {
+        state.PauseTiming();
+        DataSetReader dsr(std::string(ASSETS_PATH) + "/squirrel");
+        auto ds = dsr.load(num_imgs);
+        Preprocess(*ds, cv::Scalar(0, 0, 30), 0, false);
+        BoundingBox bbox =
+            BoundingBox(ds->getCamera(0), ds->getCamera((num_imgs / 4) - 1));
+        auto oc =
+            ret::make_unique<OctreeCarving>(bbox.getBounds(), voxel_dim);
+        oc->setNumThreads(static_cast<std::size_t>(state.range_y()));
+        const auto& cams = ds->getCameras();
+        state.ResumeTiming();
+        oc->carve(cams);
+
+        state.PauseTiming();
+        const auto& grid     = oc->getVoxelGrid();
+        const auto brick_dim = grid.getBrickDim();
+        num_allocated        = grid.getNumAllocated();
+        num_bricks           = brick_dim * brick_dim * brick_dim;
+        state.ResumeTiming();
+    }
+
+    // same unit as BM_VoxelCarving to compare against dense carving
+    state.SetItemsProcessed(static_cast<std::size_t>(state.iterations()) *
+                            num_imgs * voxel_dim * voxel_dim * voxel_dim);
+    state.SetLabel(std::to_string(num_allocated) + "/" +
+                   std::to_string(num_bricks) + " bricks allocated");
+}
+BENCHMARK(BM_OctreeCarving)->Apply(OctreeCarvingArguments)->UseRealTime();
+
+static void BM_ColorMesh(benchmark::State& state) {
+    std::size_t num_allocations = 0;
+    while (state.KeepRunning()) {
+        state.PauseTiming();
+        const int num_imgs = 36;
+        DataSetReader dsr(std::string(ASSETS_PATH) + "/squirrel");
+        auto ds = dsr.load(num_imgs);
+        Preprocess(*ds, cv::Scalar(0, 0, 30), 0, false);
         BoundingBox bbox =
             BoundingBox(ds->getCamera(0), ds->getCamera((num_imgs / 4) - 1));
         auto vc = ret::make_unique<VoxelCarving>(bbox.getBounds(), 128);
-        for (const auto &cam : ds->getCameras()) {
-            vc->carve(cam);
-        }
+        vc->carveAll(ds->getCameras());
         auto visual_hull = vc->createVisualHull();
+        const auto allocations_before = perf::GetNumAllocations();
         state.ResumeTiming();
-        Colorize(visual_hull, ds->getCameras());
+        Colorize(visual_hull, ds->getCameras(),
+                 static_cast<std::size_t>(state.range_x()));
+        num_allocations += perf::GetNumAllocations() - allocations_before;
     }
+
+    state.SetLabel(
+        std::to_string(num_allocations /
+                       static_cast<std::size_t>(state.iterations())) +
+        " allocations");
 }
-BENCHMARK(BM_ColorMesh);
+BENCHMARK(BM_ColorMesh)->Arg(1)->Arg(2)->Arg(4)->Arg(8)->UseRealTime();
 
 BENCHMARK_MAIN();
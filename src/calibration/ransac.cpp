@@ -20,29 +20,100 @@
 
 #include "calibration/ransac.hpp"
 
+#include <algorithm>
 #include <cmath>
-#include <cstdlib>
 #include <ctime>
 #include <limits>
-
-#include <opencv2/core/mat.hpp>
+#include <numeric>
+#include <tuple>
+#include <utility>
 
 namespace ret {
 
 namespace calib {
 
-    Ransac::Ransac()
-        : required_inliers_(0),
+    namespace {
+
+        const std::size_t BITS = 64;
+
+        // solves A * x = b for a row-major 3x3 matrix with Cramer's rule
+        // and normalizes x. A singular matrix yields the zero vector, as
+        // inverting it with cv::DECOMP_LU does
+        LightDirectionModel SolveNormalized(const double A[9],
+                                            const double b[3]) {
+
+            const auto c0 = A[4] * A[8] - A[5] * A[7];
+            const auto c1 = A[5] * A[6] - A[3] * A[8];
+            const auto c2 = A[3] * A[7] - A[4] * A[6];
+            const auto det = A[0] * c0 + A[1] * c1 + A[2] * c2;
+            if (det == 0.0) {
+                return LightDirectionModel();
+            }
+
+            const double x[] = {
+                (b[0] * c0 + A[1] * (A[5] * b[2] - b[1] * A[8]) +
+                 A[2] * (b[1] * A[7] - A[4] * b[2])) /
+                    det,
+                (A[0] * (b[1] * A[8] - A[5] * b[2]) + b[0] * c1 +
+                 A[2] * (A[3] * b[2] - b[1] * A[6])) /
+                    det,
+                (A[0] * (A[4] * b[2] - b[1] * A[7]) +
+                 A[1] * (b[1] * A[6] - A[3] * b[2]) + b[0] * c2) /
+                    det};
+            const auto norm =
+                std::sqrt(x[0] * x[0] + x[1] * x[1] + x[2] * x[2]);
+            if (norm <= std::numeric_limits<double>::epsilon()) {
+                return LightDirectionModel();
+            }
+            return LightDirectionModel(static_cast<float>(x[0] / norm),
+                                       static_cast<float>(x[1] / norm),
+                                       static_cast<float>(x[2] / norm));
+        }
+
+        // accumulates the normal equations N^T * N * s = N^T * I
+        void Accumulate(const contour_point& cp, double A[9], double b[3]) {
+            const double intensity = cp.intensity;
+            for (auto r = 0; r < 3; ++r) {
+                for (auto c = 0; c < 3; ++c) {
+                    A[3 * r + c] += cp.normal[r] * cp.normal[c];
+                }
+                b[r] += cp.normal[r] * intensity;
+            }
+        }
+
+        // a singular system yields the zero vector, see SolveNormalized
+        bool IsDegenerate(const LightDirectionModel& model) {
+            return model.x == 0.0f && model.y == 0.0f && model.z == 0.0f;
+        }
+
+        // calls func(idx) for each set bit in increasing order
+        template <typename Func>
+        void ForEachBit(const std::vector<std::uint64_t>& bits,
+                        const Func& func) {
+            for (std::size_t w = 0; w < bits.size(); ++w) {
+                auto word = bits[w];
+                for (std::size_t bit = 0; word != 0; ++bit, word >>= 1) {
+                    if (word & 1u) {
+                        func(w * BITS + bit);
+                    }
+                }
+            }
+        }
+    } // namespace
+
+    Ransac::Ransac() : Ransac(static_cast<std::uint32_t>(std::time(nullptr))) {}
+
+    Ransac::Ransac(const std::uint32_t seed)
+        : gen_(seed),
+          required_inliers_(0),
           iterations_(0),
-          best_error_(std::numeric_limits<float>::max()),
-          threshold_(0) {
-        // initialize random seed
-        std::srand(static_cast<unsigned int>(std::time(nullptr)));
-    }
+          best_error_(std::numeric_limits<int>::max()),
+          threshold_(0) {}
 
     Ransac& Ransac::setObservationSet(
         std::vector<contour_point> observation_set) {
-        observation_set_ = observation_set;
+        observation_set_ = std::move(observation_set);
+        prepareObservations();
         return *this;
     }
 
@@ -66,35 +137,95 @@ namespace calib {
         return *this;
     }
 
+    void Ransac::prepareObservations() {
+
+        const auto num = observation_set_.size();
+        nx_.resize(num);
+        ny_.resize(num);
+        nz_.resize(num);
+        intensity_.resize(num);
+        for (std::size_t i = 0; i < num; ++i) {
+            const auto& cp = observation_set_[i];
+            nx_[i]         = cp.normal[0];
+            ny_[i]         = cp.normal[1];
+            nz_[i]         = cp.normal[2];
+            intensity_[i]  = cp.intensity / 255.0f;
+        }
+
+        // sorting the indices by value groups equal observations
+        std::vector<std::size_t> order(num);
+        std::iota(order.begin(), order.end(), 0);
+        const auto key = [this](const std::size_t i) {
+            const auto& cp = observation_set_[i];
+            return std::make_tuple(cp.normal[0], cp.normal[1], cp.normal[2],
+                                   cp.intensity, i);
+        };
+        std::sort(order.begin(), order.end(),
+                  [&key](const std::size_t a, const std::size_t b) {
+                      return key(a) < key(b);
+                  });
+        first_equal_.resize(num);
+        for (std::size_t i = 0; i < num; ++i) {
+            const auto& cp   = observation_set_[order[i]];
+            const auto& prev = observation_set_[order[i == 0 ? 0 : i - 1]];
+            const auto equal = i > 0 && cp.normal == prev.normal &&
+                               cp.intensity == prev.intensity;
+            first_equal_[order[i]] =
+                equal ? first_equal_[order[i - 1]] : order[i];
+        }
+
+        consensus_.assign((num + BITS - 1) / BITS, 0);
+        best_consensus_.assign(consensus_.size(), 0);
+    }
+
     bool Ransac::getBestModel(LightDirectionModel& model) {
-        auto model_found       = false;
-        std::size_t iterations = 0;
-
-        while (iterations < iterations_) {
-            auto maybe_inliers = getMaybeInliers();
-            auto consensus_set = maybe_inliers;
-            model =
-                getModel(maybe_inliers[0], maybe_inliers[1], maybe_inliers[2]);
-
-            for (const auto& date : observation_set_) {
-                if (!isMember(date, maybe_inliers) && fitsModel(date, model)) {
-                    consensus_set.push_back(date);
+        auto model_found = false;
+        if (observation_set_.empty()) {
+            model = best_model_;
+            return model_found;
+        }
+
+        const auto num = observation_set_.size();
+        std::size_t maybe_inliers[3];
+        for (std::size_t iteration = 0; iteration < iterations_;
+             ++iteration) {
+            drawMaybeInliers(maybe_inliers);
+            model = getModel(observation_set_[maybe_inliers[0]],
+                             observation_set_[maybe_inliers[1]],
+                             observation_set_[maybe_inliers[2]]);
+            if (IsDegenerate(model)) {
+                continue;
+            }
+
+            // observations equal to a maybe inlier are members already
+            const std::size_t members[] = {first_equal_[maybe_inliers[0]],
+                                           first_equal_[maybe_inliers[1]],
+                                           first_equal_[maybe_inliers[2]]};
+            std::fill(consensus_.begin(), consensus_.end(), 0);
+            std::size_t consensus_size = 3;
+            for (std::size_t i = 0; i < num; ++i) {
+                if (fitsModel(i, model) && first_equal_[i] != members[0] &&
+                    first_equal_[i] != members[1] &&
+                    first_equal_[i] != members[2]) {
+                    consensus_[i / BITS] |= std::uint64_t(1) << (i % BITS);
+                    ++consensus_size;
                 }
             }
 
-            if (consensus_set.size() >= required_inliers_) {
-                model            = getModel(consensus_set);
-                float this_error = getModelError(consensus_set, model);
+            if (consensus_size >= required_inliers_) {
+                const auto consensus_model = getConsensusModel(maybe_inliers);
+                if (!IsDegenerate(consensus_model)) {
+                    model = consensus_model;
+                }
+                const int this_error = getModelError(maybe_inliers, model);
 
                 if (this_error < best_error_) {
-                    best_consensus_set_ = consensus_set;
-                    best_model_         = model;
-                    best_error_         = this_error;
-                    model_found         = true;
+                    best_consensus_.swap(consensus_);
+                    best_model_ = model;
+                    best_error_ = this_error;
+                    model_found = true;
                 }
             }
-
-            iterations += 1;
         }
 
         model = best_model_;
@@ -104,85 +235,67 @@ namespace calib {
     LightDirectionModel Ransac::getModel(const contour_point& cp1,
                                          const contour_point& cp2,
                                          const contour_point& cp3) const {
-        LightDirectionModel model;
-        cv::Mat N;
-        N.push_back(cp1.normal);
-        N.push_back(cp2.normal);
-        N.push_back(cp3.normal);
-        cv::Vec3f I(cp1.intensity, cp2.intensity, cp3.intensity);
-        cv::Mat S = N.reshape(1, 3).inv() * cv::Mat(I);
-        cv::normalize(S, S);
-
-        return LightDirectionModel(cv::Vec3f(S));
+        const double N[] = {cp1.normal[0], cp1.normal[1], cp1.normal[2],
+                            cp2.normal[0], cp2.normal[1], cp2.normal[2],
+                            cp3.normal[0], cp3.normal[1], cp3.normal[2]};
+        const double I[] = {static_cast<double>(cp1.intensity),
+                            static_cast<double>(cp2.intensity),
+                            static_cast<double>(cp3.intensity)};
+        return SolveNormalized(N, I);
     }
 
     LightDirectionModel Ransac::getModel(
         const std::vector<contour_point>& observation) const {
-        // estimate light direction with SVD
-        cv::Mat I, N;
+        // least squares solution of N * s = I
+        double A[9] = {0}, b[3] = {0};
         for (const auto& date : observation) {
-            I.push_back(static_cast<float>(date.intensity));
-            N.push_back(date.normal);
+            Accumulate(date, A, b);
         }
-
-        cv::Mat N1;
-        cv::invert(N.reshape(1, static_cast<int>(observation.size())), N1,
-                   cv::DECOMP_SVD);
-        cv::Mat S = N1 * I;
-        cv::normalize(S, S);
-
-        return LightDirectionModel(cv::Vec3f(S));
+        return SolveNormalized(A, b);
     }
 
-    bool Ransac::isMember(
-        const contour_point& cp,
-        const std::vector<contour_point>& maybe_inliers) const {
-        for (const auto& date : maybe_inliers) {
-            if (cp.normal == date.normal && cp.intensity == date.intensity) {
-                return true;
-            }
+    LightDirectionModel Ransac::getConsensusModel(
+        const std::size_t* maybe_inliers) const {
+        double A[9] = {0}, b[3] = {0};
+        for (std::size_t i = 0; i < 3; ++i) {
+            Accumulate(observation_set_[maybe_inliers[i]], A, b);
         }
-
-        return false;
+        ForEachBit(consensus_, [&](const std::size_t i) {
+            Accumulate(observation_set_[i], A, b);
+        });
+        return SolveNormalized(A, b);
     }
 
-    bool Ransac::fitsModel(const contour_point& cp,
+    bool Ransac::fitsModel(const std::size_t idx,
                            const LightDirectionModel& model) const {
-        return (getDistance(cp, model) < threshold_);
+        // check dicrepancy between observed and predicted intensity
+        const auto predicted =
+            model.x * nx_[idx] + model.y * ny_[idx] + model.z * nz_[idx];
+        return std::abs(predicted - intensity_[idx]) < threshold_;
     }
 
-    std::vector<contour_point> Ransac::getMaybeInliers() const {
-        std::vector<contour_point> maybe_inliers;
+    void Ransac::drawMaybeInliers(std::size_t* maybe_inliers) {
+        std::uniform_int_distribution<std::size_t> draw(
+            0, observation_set_.size() - 1);
         for (std::size_t i = 0; i < 3; ++i) {
-            maybe_inliers.push_back(
-                observation_set_.at(static_cast<std::size_t>(rand()) %
-                                    observation_set_.size()));
+            maybe_inliers[i] = draw(gen_);
         }
-
-        return maybe_inliers;
     }
 
-    int Ransac::getModelError(const std::vector<contour_point>& point_list,
+    int Ransac::getModelError(const std::size_t* maybe_inliers,
                               const LightDirectionModel& model) const {
 
-        auto max_error = std::numeric_limits<int>::max();
-        std::vector<contour_point> consensus_set;
-
-        for (const auto& point : point_list) {
-            if (fitsModel(point, model)) {
-                consensus_set.push_back(point);
-            }
+        // the more of the consensus set fits the model, the smaller the
+        // error
+        std::size_t num_fits = 0;
+        for (std::size_t i = 0; i < 3; ++i) {
+            num_fits += fitsModel(maybe_inliers[i], model) ? 1 : 0;
         }
+        ForEachBit(consensus_, [&](const std::size_t i) {
+            num_fits += fitsModel(i, model) ? 1 : 0;
+        });
 
-        return static_cast<int>(static_cast<std::size_t>(max_error) -
-                                consensus_set.size());
-    }
-
-    float Ransac::getDistance(const contour_point& cp,
-                              const LightDirectionModel& model) const {
-        // check dicrepancy between observed and predicted intensity
-        cv::Vec3f l(model.x, model.y, model.z);
-        return std::abs(l.dot(cp.normal) - (cp.intensity / 255.0f));
+        return std::numeric_limits<int>::max() - static_cast<int>(num_fits);
     }
 
 } // namespace calib
@@ -22,6 +22,8 @@
 #define CALIBRATION_RANSAC_HPP
 
 #include <cstddef>
+#include <cstdint>
+#include <random>
 #include <vector>
 
 #include <opencv2/core/core.hpp>
@@ -49,9 +51,16 @@ namespace calib {
     class Ransac {
       public:
         /** @brief Initializes default parameter for estimating light
-          * direction */
+          * direction. The random generator is seeded with the current
+          * time */
         Ransac();
 
+        /** @brief Initializes default parameter for estimating light
+          * direction with a fixed seed, such that the drawn samples and
+          * hence the best model are reproducible
+          * @param seed seed of the random generator */
+        explicit Ransac(const std::uint32_t seed);
+
         /** @brief Set current obseration set
           * @param observation_set Obseration set */
         Ransac& setObservationSet(std::vector<contour_point> observation_set);
@@ -73,7 +82,10 @@ namespace calib {
           * @param required_inliers Number of required inliers */
         Ransac& setRequiredInliers(const std::size_t required_inliers);
 
-        /** @brief Returns best model, if one was found
+        /** @brief Returns best model, if one was found. Samples, whose
+          * normals are linearly dependent, determine no direction and are
+          * skipped. If the consensus set of a sample determines no
+          * direction, the model of the sample itself is kept
           * @param model Best model for light direction */
         bool getBestModel(LightDirectionModel& model);
 
@@ -92,22 +104,31 @@ namespace calib {
             const std::vector<contour_point>& observation) const;
 
       private:
-        bool isMember(const contour_point& cp,
-                      const std::vector<contour_point>& maybe_inliers) const;
-        bool fitsModel(const contour_point& cp,
+        void prepareObservations();
+        bool fitsModel(const std::size_t idx,
                        const LightDirectionModel& model) const;
-        std::vector<contour_point> getMaybeInliers() const;
-        int getModelError(const std::vector<contour_point>& point_list,
-                          const LightDirectionModel& model) const;
-        float getDistance(const contour_point& cp,
+        void drawMaybeInliers(std::size_t* maybe_inliers);
+        LightDirectionModel getConsensusModel(
+            const std::size_t* maybe_inliers) const;
+        int getModelError(const std::size_t* maybe_inliers,
                           const LightDirectionModel& model) const;
 
         std::vector<contour_point> observation_set_;
-        std::vector<contour_point> best_consensus_set_;
+        /** normals and intensities scaled to [0, 1] of the observations,
+          * stored as separate arrays for the inlier test */
+        std::vector<float> nx_, ny_, nz_, intensity_;
+        /** index of the first observation equal to each observation,
+          * equal observations count as one member of a consensus set */
+        std::vector<std::size_t> first_equal_;
+        /** consensus set without the maybe inliers, one bit per
+          * observation */
+        std::vector<std::uint64_t> consensus_;
+        std::vector<std::uint64_t> best_consensus_;
         LightDirectionModel best_model_;
+        std::mt19937 gen_;
         std::size_t required_inliers_;
         std::size_t iterations_;
-        float best_error_;
+        int best_error_;
         float threshold_;
     };
 }  // namespace calib
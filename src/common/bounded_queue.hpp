@@ -0,0 +1,108 @@
+// Copyright (c) 2015-2016, Kai Wolf
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#ifndef COMMON_BOUNDED_QUEUE_HPP
+#define COMMON_BOUNDED_QUEUE_HPP
+
+#include <cassert>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <mutex>
+#include <utility>
+
+namespace ret {
+
+/** @brief Thread safe FIFO queue holding at most a fixed number of
+  * elements. Producers block while the queue is full and consumers block
+  * while it is empty, hence a chain of queues between pipeline stages
+  * bounds the number of elements in flight. Closing the queue wakes up
+  * all waiting threads: consumers drain the remaining elements, while
+  * producers are told to stop */
+template <typename T>
+class BoundedQueue {
+  public:
+    /** @param capacity maximum number of queued elements, at least one */
+    explicit BoundedQueue(const std::size_t capacity)
+        : capacity_(capacity), closed_(false), mutex_(), not_full_(),
+          not_empty_(), queue_() {
+        assert(capacity > 0);
+    }
+
+    BoundedQueue(BoundedQueue const&)            = delete;
+    BoundedQueue operator&=(BoundedQueue const&) = delete;
+
+    /** @brief Appends an element, waiting while the queue is full
+      * @param value element to append
+      * @return false, if the queue has been closed and the element was
+      * dropped */
+    bool push(T value) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        not_full_.wait(
+            lock, [this]() { return closed_ || queue_.size() < capacity_; });
+        if (closed_) {
+            return false;
+        }
+        queue_.push_back(std::move(value));
+        not_empty_.notify_one();
+        return true;
+    }
+
+    /** @brief Removes the first element, waiting while the queue is empty
+      * @param value receives the element
+      * @return false, if the queue has been closed and is empty */
+    bool pop(T& value) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        not_empty_.wait(lock, [this]() { return closed_ || !queue_.empty(); });
+        if (queue_.empty()) {
+            return false;
+        }
+        value = std::move(queue_.front());
+        queue_.pop_front();
+        not_full_.notify_one();
+        return true;
+    }
+
+    /** @brief Closes the queue. Further pushes fail, while queued
+      * elements can still be popped */
+    void close() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        closed_ = true;
+        not_full_.notify_all();
+        not_empty_.notify_all();
+    }
+
+    std::size_t getCapacity() const { return capacity_; }
+
+    std::size_t size() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return queue_.size();
+    }
+
+  private:
+    const std::size_t capacity_;
+    bool closed_;
+    mutable std::mutex mutex_;
+    std::condition_variable not_full_, not_empty_;
+    std::deque<T> queue_;
+};
+} // namespace ret
+
+#endif
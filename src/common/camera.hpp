@@ -21,10 +21,15 @@
 #ifndef COMMON_CAMERA_HPP
 #define COMMON_CAMERA_HPP
 
+#include <cstdint>
+#include <memory>
+#include <string>
+
 #include <opencv2/core/core.hpp>
 
 #include "common/camera_extrinsics.hpp"
 #include "common/camera_intrinsics.hpp"
+#include "common/lazy_image.hpp"
 
 namespace ret {
 
@@ -35,84 +40,214 @@ class Camera : public CameraIntrinsics, public CameraExtrinsics {
     explicit Camera(const cv::Mat Image)
         : P_(cv::Mat(3, 4, CV_32F)),
           Image_(Image),
-          Mask_(cv::Mat(Image.size(), CV_8U)) {}
+          Mask_(cv::Mat(Image.size(), CV_8U)),
+          DistMap_(),
+          LazyImage_() {
+        updateDirection();
+    }
+
+    /** @brief Creates a camera, whose image is decoded on the first call
+      * of @ref getImage only. Copies of the camera share the decoded
+      * image
+      * @param image_path path of the image file
+      * @param image_size size of the image */
+    Camera(std::string image_path, const cv::Size& image_size)
+        : P_(cv::Mat(3, 4, CV_32F)),
+          Image_(),
+          Mask_(cv::Mat(image_size, CV_8U)),
+          DistMap_(),
+          LazyImage_(std::make_shared<LazyImage>(std::move(image_path),
+                                                 image_size)) {
+        updateDirection();
+    }
 
+    /** @brief Creates a camera, whose image is provided by a shared lazy
+      * image, see @ref LazyImage
+      * @param image lazily decoded image */
+    explicit Camera(std::shared_ptr<LazyImage> image)
+        : P_(cv::Mat(3, 4, CV_32F)),
+          Image_(),
+          Mask_(cv::Mat(image->getSize(), CV_8U)),
+          DistMap_(),
+          LazyImage_(std::move(image)) {
+        updateDirection();
+    }
+
+    /** @brief Sets the projection matrix and computes the camera center
+      * from it */
     template <typename T>
     Camera& setProjectionMatrix(T&& P) {
         assert(P.size() == cv::Size(4, 3) && P.type() == CV_32F);
         this->P_ = std::forward<T>(P);
+        updateCenter();
         return *this;
     }
 
-    cv::Mat getProjectionMatrix() const { return this->P_; }
+    const cv::Mat& getProjectionMatrix() const { return this->P_; }
 
-    cv::Mat getPose() const {
-        cv::Mat Pose(3, 4, CV_32F, cv::Scalar::all(0));
-        R_.copyTo(Pose.colRange(0, 2).rowRange(0, 2));
-        t_.copyTo(Pose.colRange(2, 3).rowRange(0, 2));
-        return Pose;
-    }
+    /** @brief Returns the pose [R|t] of the camera, where t = -R * C is
+      * derived from the camera center C held by the translation vector */
+    const cv::Matx34f& getPose() const { return Pose_; }
 
-    cv::Point3d getCenter() const {
-
-        cv::Mat P_023;
-        for (auto idx : { 0, 2, 3 }) {
-            P_023.push_back(P_.col(idx));
-        }
-        cv::Mat P_013;
-        for (auto idx : { 0, 1, 3 }) {
-            P_013.push_back(P_.col(idx));
-        }
+    /** @brief Returns the camera center, i.e. the right null space of the
+      * projection matrix */
+    cv::Point3d getCenter() const { return Center_; }
 
-        auto x = cv::determinant(P_(cv::Range(0, 3), cv::Range(1, 4)));
-        auto y = -cv::determinant(P_023.reshape(0, 3).t());
-        auto z = cv::determinant(P_013.reshape(0, 3).t());
-        auto t = -cv::determinant(P_(cv::Range(0, 3), cv::Range(0, 3)));
+    /** @brief Returns the normalized direction of the ray through the
+      * image center */
+    const cv::Vec3f& getDirection() const { return Direction_; }
 
-        return cv::Point3d(x / t, y / t, z / t);
+    template <typename T>
+    Camera& setImage(T&& Image) {
+        this->Image_ = std::forward<T>(Image);
+        this->LazyImage_.reset();
+        updateDirection();
+        return *this;
     }
 
-    cv::Mat getDirection() const {
-        if (!Direction_.empty()) {
-            return Direction_;
-        }
+    /** @brief Returns the image, which is decoded first if the camera
+      * has been created lazily */
+    cv::Mat getImage() const {
+        return LazyImage_ ? LazyImage_->get() : Image_;
+    }
 
-        const auto img_size = Image_.size();
-        cv::Mat Center = (cv::Mat_<float>(3, 1) << img_size.width / 2.0f,
-                          img_size.height / 2.0f, 1.0f);
+    /** @brief Returns the size of the image without decoding it */
+    cv::Size getImageSize() const {
+        return LazyImage_ ? LazyImage_->getSize() : Image_.size();
+    }
 
-        cv::Mat X;
-        cv::solve(getCalibrationMatrix(), Center, X, cv::DECOMP_LU);
+    /** @brief Releases the decoded image of a lazily created camera, which
+      * is decoded again on the next call of @ref getImage
+      * @return false, if the image cannot be decoded again */
+    bool evictImage() {
+        if (!LazyImage_) {
+            return false;
+        }
+        LazyImage_->evict();
+        return true;
+    }
 
-        cv::Mat Rt;
-        cv::transpose(getRotationMatrix(), Rt);
-        X          = Rt * (X * (-1));
-        Direction_ = X / cv::norm(X);
-        return Direction_;
+    /** @brief Returns true, if the image is held in memory */
+    bool isImageDecoded() const {
+        return LazyImage_ ? LazyImage_->isDecoded() : !Image_.empty();
     }
 
+    /** @brief Sets the binary mask of the object and discards the
+      * distance map created from the previous mask */
     template <typename T>
-    Camera& setImage(T&& Image) {
-        this->Image_ = std::forward<T>(Image);
+    Camera& setMask(T&& Mask) {
+        this->Mask_ = std::forward<T>(Mask);
+        this->DistMap_.release();
         return *this;
     }
 
-    cv::Mat getImage() const { return Image_; }
+    const cv::Mat& getMask() const { return Mask_; }
 
+    /** @brief Sets the distance map created from the current mask, which
+      * is used for carving instead of computing it again
+      * @param DistMap distance map of type CV_32F
+      * @param MaskHash hash of the mask the map was created from, see
+      * filtering::HashMat. Since the mask may be modified in place, the
+      * map is only used as long as the hash still matches the mask */
     template <typename T>
-    Camera& setMask(T&& Mask) {
-        this->Mask_ = std::forward<T>(Mask);
+    Camera& setDistMap(T&& DistMap, const std::uint64_t MaskHash) {
+        assert(DistMap.size() == Mask_.size() && DistMap.type() == CV_32F);
+        this->DistMap_     = std::forward<T>(DistMap);
+        this->DistMapHash_ = MaskHash;
         return *this;
     }
 
-    cv::Mat getMask() const { return Mask_; }
+    /** @brief Returns the distance map of the mask or an empty matrix, if
+      * it has not been created yet */
+    const cv::Mat& getDistMap() const { return DistMap_; }
+
+    /** @brief Returns the hash of the mask the distance map was created
+      * from */
+    std::uint64_t getDistMapHash() const { return DistMapHash_; }
 
   private:
+    // the setters of the base classes keep the derived values up to date,
+    // even if called through a reference to a base class
+    void calibrationChanged() override { updateDirection(); }
+
+    void extrinsicsChanged() override {
+        updateDirection();
+        updatePose();
+    }
+
+    // converts a matrix of any depth without allocating, a matrix of
+    // another size yields zeros
+    template <int m, int n>
+    static cv::Matx<double, m, n> ToMatx(const cv::Mat& M) {
+        cv::Matx<double, m, n> out;
+        if (M.rows == m && M.cols == n && M.channels() == 1) {
+            cv::Mat dst(m, n, CV_64F, out.val);
+            M.convertTo(dst, CV_64F);
+        }
+        return out;
+    }
+
+    void updateCenter() {
+        const auto P = ToMatx<3, 4>(P_);
+        // determinant of the columns a, b and c of P
+        const auto det = [&P](const int a, const int b, const int c) {
+            return cv::determinant(cv::Matx33d(
+                P(0, a), P(0, b), P(0, c), P(1, a), P(1, b), P(1, c),
+                P(2, a), P(2, b), P(2, c)));
+        };
+
+        const auto x = det(1, 2, 3);
+        const auto y = -det(0, 2, 3);
+        const auto z = det(0, 1, 3);
+        const auto t = -det(0, 1, 2);
+        Center_      = cv::Point3d(x / t, y / t, z / t);
+    }
+
+    void updateDirection() {
+        const auto img_size = getImageSize();
+        const cv::Vec3d Center(img_size.width / 2.0, img_size.height / 2.0,
+                               1.0);
+        cv::Vec3d X;
+        if (!cv::solve(ToMatx<3, 3>(K_), Center, X, cv::DECOMP_LU)) {
+            Direction_ = cv::Vec3f();
+            return;
+        }
+
+        X = ToMatx<3, 3>(R_).t() * (X * (-1));
+        const auto norm = cv::norm(X);
+        Direction_ = norm > 0.0 ? cv::Vec3f(X / norm) : cv::Vec3f();
+    }
+
+    // the translation vector holds the homogeneous camera center, as
+    // returned by cv::decomposeProjectionMatrix
+    void updatePose() {
+        const auto R = ToMatx<3, 3>(R_);
+        const auto C = ToMatx<4, 1>(t_);
+        const auto t = C(3) != 0.0
+                           ? R * cv::Vec3d(C(0), C(1), C(2)) * (-1.0 / C(3))
+                           : cv::Vec3d();
+        for (auto r = 0; r < 3; ++r) {
+            for (auto c = 0; c < 3; ++c) {
+                Pose_(r, c) = static_cast<float>(R(r, c));
+            }
+            Pose_(r, 3) = static_cast<float>(t(r));
+        }
+    }
+
     cv::Mat P_;
     cv::Mat Image_;
     cv::Mat Mask_;
-
-    mutable cv::Mat Direction_;
+    cv::Mat DistMap_;
+    std::uint64_t DistMapHash_ = 0;
+    std::shared_ptr<LazyImage> LazyImage_;
+
+    /** derived from the calibration, rotation, translation and projection
+      * matrix, updated whenever one of them or the image changes. The
+      * setters of the base classes notify the camera through
+      * calibrationChanged and extrinsicsChanged */
+    cv::Point3d Center_;
+    cv::Vec3f Direction_;
+    cv::Matx34f Pose_;
 };
 } // namespace ret
 
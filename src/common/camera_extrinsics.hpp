@@ -61,19 +61,21 @@ class CameraExtrinsics {
     CameraExtrinsics& setRotationMatrix(T&& R) {
         assert(R.size() == cv::Size(3, 3) && R.type() == CV_32F);
         this->R_ = std::forward<T>(R);
+        extrinsicsChanged();
         return *this;
     }
 
-    cv::Mat getRotationMatrix() const { return this->R_; }
+    const cv::Mat& getRotationMatrix() const { return this->R_; }
 
     template <typename T>
     CameraExtrinsics& setTranslationVector(T&& t) {
         assert(t.size() == cv::Size(1, 4) && t.type() == CV_32F);
         this->t_ = std::forward<T>(t);
+        extrinsicsChanged();
         return *this;
     }
 
-    cv::Mat getTranslationVector() const { return this->t_; }
+    const cv::Mat& getTranslationVector() const { return this->t_; }
 
     friend std::ostream& operator<<(std::ostream& os,
                                     const CameraExtrinsics& extr) {
@@ -81,6 +83,11 @@ class CameraExtrinsics {
     }
 
   protected:
+    /** @brief Called after the rotation matrix or the translation vector
+      * has been set, such that derived classes can update values
+      * depending on them */
+    virtual void extrinsicsChanged() {}
+
     cv::Mat R_, t_;
 };
 }  // namespace ret
@@ -60,10 +60,11 @@ class CameraIntrinsics {
     CameraIntrinsics& setCalibrationMatrix(T&& K) {
         assert(K.size() == cv::Size(3, 3) && K.type() == CV_32F);
         this->K_ = std::forward<T>(K);
+        calibrationChanged();
         return *this;
     }
 
-    cv::Mat getCalibrationMatrix() const { return K_; }
+    const cv::Mat& getCalibrationMatrix() const { return K_; }
 
     template <typename T>
     CameraIntrinsics& setDistortionCoeffs(T&& dist) {
@@ -72,7 +73,7 @@ class CameraIntrinsics {
         return *this;
     }
 
-    cv::Mat getDistortionCoeffs() const { return dist_; }
+    const cv::Mat& getDistortionCoeffs() const { return dist_; }
 
     friend std::ostream& operator<<(std::ostream& os,
                                     const CameraIntrinsics& intr) {
@@ -80,6 +81,10 @@ class CameraIntrinsics {
     }
 
   protected:
+    /** @brief Called after the calibration matrix has been set, such that
+      * derived classes can update values depending on it */
+    virtual void calibrationChanged() {}
+
     cv::Mat K_;
     cv::Mat dist_;
 };
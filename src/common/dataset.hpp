@@ -21,6 +21,8 @@
 #ifndef COMMON_DATASET_HPP
 #define COMMON_DATASET_HPP
 
+#include <cassert>
+#include <cstddef>
 #include <vector>
 
 #include <opencv2/core/core.hpp>
@@ -38,7 +40,9 @@ class DataSet {
         this->cameras_ = std::forward<T>(cameras);
     }
 
-    std::vector<Camera> getCameras() const { return cameras_; }
+    /** @brief Returns all cameras without copying them. The reference
+      * stays valid until cameras are added or replaced */
+    const std::vector<Camera>& getCameras() const { return cameras_; }
 
     template <typename T>
     void setCamera(T&& camera, const std::size_t camIdx) {
@@ -51,6 +55,11 @@ class DataSet {
         return cameras_[camIdx];
     }
 
+    const Camera& getCamera(const std::size_t camIdx) const {
+        assert(camIdx < cameras_.size());
+        return cameras_[camIdx];
+    }
+
     template <typename T>
     void addCamera(T&& camera) {
         cameras_.push_back(std::forward<T>(camera));
@@ -58,6 +67,13 @@ class DataSet {
 
     std::size_t size() const { return cameras_.size(); }
 
+    /** @brief Contiguous range of all cameras, such that a data set can be
+      * passed wherever a pointer and a number of cameras is expected and
+      * iterated without copying a single camera */
+    const Camera* data() const { return cameras_.data(); }
+    const Camera* begin() const { return cameras_.data(); }
+    const Camera* end() const { return cameras_.data() + cameras_.size(); }
+
   private:
     std::vector<Camera> cameras_;
 };
@@ -0,0 +1,97 @@
+// Copyright (c) 2015-2016, Kai Wolf
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#ifndef COMMON_LAZY_IMAGE_HPP
+#define COMMON_LAZY_IMAGE_HPP
+
+#include <functional>
+#include <mutex>
+#include <string>
+#include <utility>
+
+#include <opencv2/core/core.hpp>
+#include <opencv2/highgui/highgui.hpp>
+
+namespace ret {
+
+/** @brief Image file, which is decoded on first access only. The decoded
+  * image is kept until it is evicted, afterwards it is decoded again on
+  * the next access. Access is thread safe, such that several copies of a
+  * @ref Camera may share a single LazyImage */
+class LazyImage {
+  public:
+    using Decoder = std::function<cv::Mat()>;
+
+    /** @param path path of the image file
+      * @param size size of the image, known without decoding it */
+    LazyImage(std::string path, const cv::Size& size)
+        : path_(std::move(path)),
+          size_(size),
+          decode_(),
+          mutex_(),
+          Image_() {}
+
+    /** @brief Creates an image, which is read by a custom decoder instead
+      * of from an image file, e.g. from a packed data set container
+      * @param decode returns the image, called once per decoding
+      * @param size size of the image, known without decoding it */
+    LazyImage(Decoder decode, const cv::Size& size)
+        : path_(), size_(size), decode_(std::move(decode)), mutex_(),
+          Image_() {}
+
+    LazyImage(LazyImage const&)            = delete;
+    LazyImage operator&=(LazyImage const&) = delete;
+
+    /** @brief Returns the decoded image, decoding it if necessary */
+    cv::Mat get() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (Image_.empty()) {
+            Image_ = decode_ ? decode_() : cv::imread(path_);
+        }
+        return Image_;
+    }
+
+    /** @brief Releases the decoded image. Copies returned by get before
+      * stay valid, since the image data is reference counted */
+    void evict() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        Image_.release();
+    }
+
+    /** @brief Returns true, if the image is currently decoded */
+    bool isDecoded() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return !Image_.empty();
+    }
+
+    const std::string& getPath() const { return path_; }
+
+    cv::Size getSize() const { return size_; }
+
+  private:
+    const std::string path_;
+    const cv::Size size_;
+    const Decoder decode_;
+    mutable std::mutex mutex_;
+    mutable cv::Mat Image_;
+};
+} // namespace ret
+
+#endif
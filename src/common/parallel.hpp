@@ -0,0 +1,229 @@
+// Copyright (c) 2015-2016, Kai Wolf
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#ifndef COMMON_PARALLEL_HPP
+#define COMMON_PARALLEL_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace ret {
+
+/** @brief Returns the number of concurrent threads supported by the
+  * hardware, but at least one */
+inline std::size_t HardwareConcurrency() {
+    const auto num_threads = std::thread::hardware_concurrency();
+    return num_threads == 0 ? 1 : static_cast<std::size_t>(num_threads);
+}
+
+namespace detail {
+
+    // tasks of a single ThreadPool::run call, claimed one after another by
+    // the workers and the calling thread
+    struct parallel_batch {
+        parallel_batch(const std::size_t n,
+                       const std::function<void(std::size_t)>& func)
+            : num_tasks(n), task(func), next(0), done(0), errors(n) {}
+
+        bool exhausted() const { return next.load() >= num_tasks; }
+
+        void runTasks() {
+            for (auto t = next++; t < num_tasks; t = next++) {
+                try {
+                    task(t);
+                } catch (...) {
+                    errors[t] = std::current_exception();
+                }
+                std::lock_guard<std::mutex> lock(mutex);
+                if (++done == num_tasks) {
+                    finished.notify_all();
+                }
+            }
+        }
+
+        const std::size_t num_tasks;
+        const std::function<void(std::size_t)>& task;
+        std::atomic<std::size_t> next;
+        std::size_t done;
+        std::mutex mutex;
+        std::condition_variable finished;
+        std::vector<std::exception_ptr> errors;
+    };
+} // namespace detail
+
+/** @brief Fixed set of worker threads, which are started once and reused
+  * by every call of @ref ParallelFor instead of spawning and joining
+  * threads each time. The calling thread takes part in running its own
+  * tasks, hence nested calls and calls from several threads at once never
+  * wait for a worker to become available */
+class ThreadPool {
+  public:
+    /** @brief Starts the given number of worker threads
+      * @param num_workers number of workers, 0 runs every task on the
+      * calling thread */
+    explicit ThreadPool(const std::size_t num_workers) : stop_(false) {
+        workers_.reserve(num_workers);
+        for (std::size_t w = 0; w < num_workers; ++w) {
+            workers_.emplace_back([this]() { work(); });
+        }
+    }
+
+    ThreadPool(const ThreadPool&)            = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    ~ThreadPool() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stop_ = true;
+        }
+        wake_.notify_all();
+        for (auto& worker : workers_) {
+            worker.join();
+        }
+    }
+
+    /** @brief Returns the pool shared by the whole process, which has
+      * @ref HardwareConcurrency minus one workers, as the calling thread
+      * always runs tasks as well */
+    static ThreadPool& Instance() {
+        static ThreadPool pool(HardwareConcurrency() - 1);
+        return pool;
+    }
+
+    std::size_t getNumWorkers() const { return workers_.size(); }
+
+    /** @brief Calls task(t) for every t in [0, num_tasks) and returns once
+      * all tasks are finished. The first exception thrown by a task is
+      * rethrown afterwards
+      * @param num_tasks number of tasks
+      * @param task callable with signature void(std::size_t) */
+    void run(const std::size_t num_tasks,
+             const std::function<void(std::size_t)>& task) {
+
+        const auto batch =
+            std::make_shared<detail::parallel_batch>(num_tasks, task);
+        if (num_tasks > 1 && !workers_.empty()) {
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                queue_.push_back(batch);
+            }
+            wake_.notify_all();
+        }
+
+        batch->runTasks();
+        {
+            std::unique_lock<std::mutex> lock(batch->mutex);
+            batch->finished.wait(
+                lock, [&batch]() { return batch->done == batch->num_tasks; });
+        }
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            const auto it = std::find(queue_.begin(), queue_.end(), batch);
+            if (it != queue_.end()) {
+                queue_.erase(it);
+            }
+        }
+
+        for (const auto& error : batch->errors) {
+            if (error) {
+                std::rethrow_exception(error);
+            }
+        }
+    }
+
+  private:
+    void work() {
+        for (;;) {
+            std::shared_ptr<detail::parallel_batch> batch;
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                wake_.wait(lock,
+                           [this]() { return stop_ || !queue_.empty(); });
+                if (stop_) {
+                    return;
+                }
+                // batches whose tasks are all claimed are done for the
+                // workers, the calling thread waits for them to finish
+                batch = queue_.front();
+                if (batch->exhausted()) {
+                    queue_.pop_front();
+                    continue;
+                }
+            }
+            batch->runTasks();
+        }
+    }
+
+    std::vector<std::thread> workers_;
+    std::deque<std::shared_ptr<detail::parallel_batch>> queue_;
+    std::mutex mutex_;
+    std::condition_variable wake_;
+    bool stop_;
+};
+
+/** @brief Splits the half-open range [begin, end) into contiguous chunks of
+  * (nearly) equal size and calls func(chunk_begin, chunk_end) for each of
+  * them on the threads of @ref ThreadPool::Instance. The calling thread
+  * processes chunks as well. Since chunks never overlap, func may write to
+  * data indexed by the range without further synchronization. Exceptions
+  * thrown by func are rethrown after all chunks have been processed.
+  * @param begin first index of the range
+  * @param end one past the last index of the range
+  * @param num_threads number of chunks, 0 uses @ref HardwareConcurrency
+  * @param func callable with signature void(std::size_t, std::size_t) */
+template <typename Func>
+void ParallelFor(const std::size_t begin, const std::size_t end,
+                 std::size_t num_threads, const Func& func) {
+
+    if (end <= begin) {
+        return;
+    }
+
+    if (num_threads == 0) {
+        num_threads = HardwareConcurrency();
+    }
+    num_threads = std::min(num_threads, end - begin);
+    if (num_threads == 1) {
+        func(begin, end);
+        return;
+    }
+
+    const auto chunk = (end - begin) / num_threads;
+    const auto rest  = (end - begin) % num_threads;
+    auto chunk_end   = [&](const std::size_t t) {
+        return begin + t * chunk + std::min(t, rest);
+    };
+
+    ThreadPool::Instance().run(num_threads, [&](const std::size_t t) {
+        func(chunk_end(t), chunk_end(t + 1));
+    });
+}
+} // namespace ret
+
+#endif
@@ -0,0 +1,104 @@
+// Copyright (c) 2015-2016, Kai Wolf
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#ifndef COMMON_TYPES_HALF_HPP
+#define COMMON_TYPES_HALF_HPP
+
+#include <cstdint>
+#include <cstring>
+
+namespace ret {
+
+/// IEEE 754 half precision floating point number (binary16). Only used as
+/// storage type, arithmetic is performed after converting to float
+struct half {
+    std::uint16_t bits;
+};
+
+/// largest finite half precision value
+constexpr float HALF_MAX = 65504.0f;
+
+/// Converts a float to half precision, rounding to nearest even. Values
+/// beyond the range of half precision become infinite
+inline half FloatToHalf(const float value) {
+    std::uint32_t x;
+    std::memcpy(&x, &value, sizeof(x));
+    const auto sign = static_cast<std::uint16_t>((x >> 16) & 0x8000u);
+    x &= 0x7fffffffu;
+
+    if (x >= 0x7f800000u) {
+        // infinity or NaN
+        return {static_cast<std::uint16_t>(
+            sign | (x > 0x7f800000u ? 0x7e00u : 0x7c00u))};
+    }
+    if (x >= 0x47800000u) {
+        return {static_cast<std::uint16_t>(sign | 0x7c00u)};
+    }
+    if (x < 0x38800000u) {
+        // subnormal half, rounded values below 2^-25 are zero
+        if (x < 0x33000000u) {
+            return {sign};
+        }
+        const auto shift    = 126u - (x >> 23);
+        const auto mantissa = (x & 0x7fffffu) | 0x800000u;
+        auto h              = mantissa >> shift;
+        const auto rem      = mantissa & ((1u << shift) - 1u);
+        const auto halfway  = 1u << (shift - 1u);
+        if (rem > halfway || (rem == halfway && (h & 1u))) {
+            ++h;
+        }
+        return {static_cast<std::uint16_t>(sign | h)};
+    }
+
+    // rebias the exponent from 127 to 15, a carry of the mantissa into
+    // the exponent yields the correct result, including infinity
+    auto h         = (x - 0x38000000u) >> 13;
+    const auto rem = x & 0x1fffu;
+    if (rem > 0x1000u || (rem == 0x1000u && (h & 1u))) {
+        ++h;
+    }
+    return {static_cast<std::uint16_t>(sign | h)};
+}
+
+/// Converts a half precision value to float, which is exact
+inline float HalfToFloat(const half value) {
+    const std::uint32_t sign     = (value.bits & 0x8000u) << 16;
+    const std::uint32_t exponent = (value.bits >> 10) & 0x1fu;
+    const std::uint32_t mantissa = value.bits & 0x3ffu;
+
+    if (exponent == 0) {
+        // zero or subnormal, i.e. mantissa * 2^-24
+        const auto magnitude = static_cast<float>(mantissa) * 5.9604645e-8f;
+        return sign ? -magnitude : magnitude;
+    }
+
+    std::uint32_t x;
+    if (exponent == 31) {
+        x = sign | 0x7f800000u | (mantissa << 13);
+    } else {
+        x = sign | ((exponent + 112u) << 23) | (mantissa << 13);
+    }
+    float result;
+    std::memcpy(&result, &x, sizeof(result));
+    return result;
+}
+}  // namespace ret
+
+#endif
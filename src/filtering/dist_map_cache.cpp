@@ -0,0 +1,192 @@
+// Copyright (c) 2015-2016, Kai Wolf
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "filtering/dist_map_cache.hpp"
+
+#include <cassert>
+#include <cstring>
+#include <iterator>
+#include <utility>
+
+#include "filtering/segmentation.hpp"
+
+namespace ret {
+
+namespace filtering {
+
+    namespace {
+        constexpr std::uint64_t FNV_OFFSET = 14695981039346656037ull;
+        constexpr std::uint64_t FNV_PRIME  = 1099511628211ull;
+
+        std::uint64_t HashBytes(const unsigned char *data,
+                                const std::size_t size, std::uint64_t hash) {
+
+            // hashes eight bytes at once, a mask of 1280x960 pixels takes
+            // less than a millisecond compared to the distance transform
+            std::size_t idx = 0;
+            for (; idx + sizeof(std::uint64_t) <= size;
+                 idx += sizeof(std::uint64_t)) {
+                std::uint64_t word;
+                std::memcpy(&word, data + idx, sizeof(word));
+                hash = (hash ^ word) * FNV_PRIME;
+            }
+            for (; idx < size; ++idx) {
+                hash = (hash ^ data[idx]) * FNV_PRIME;
+            }
+            return hash;
+        }
+
+        std::size_t GetSizeInBytes(const cv::Mat &Image) {
+            return Image.total() * Image.elemSize();
+        }
+
+        bool EqualContent(const cv::Mat &A, const cv::Mat &B) {
+
+            if (A.size() != B.size() || A.type() != B.type()) {
+                return false;
+            }
+            const auto row_size = static_cast<std::size_t>(A.cols) *
+                                  A.elemSize();
+            for (auto y = 0; y < A.rows; ++y) {
+                if (std::memcmp(A.ptr(y), B.ptr(y), row_size) != 0) {
+                    return false;
+                }
+            }
+            return true;
+        }
+    } // namespace
+
+    std::uint64_t HashMat(const cv::Mat &Image) {
+
+        const int header[] = {Image.rows, Image.cols, Image.type()};
+        auto hash = HashBytes(reinterpret_cast<const unsigned char *>(header),
+                              sizeof(header), FNV_OFFSET);
+        const auto row_size =
+            static_cast<std::size_t>(Image.cols) * Image.elemSize();
+        for (auto y = 0; y < Image.rows; ++y) {
+            hash = HashBytes(Image.ptr(y), row_size, hash);
+        }
+        return hash;
+    }
+
+    const std::size_t DistMapCache::DEFAULT_CAPACITY;
+
+    DistMapCache::DistMapCache(const std::size_t capacity)
+        : capacity_(capacity),
+          mutex_(),
+          entries_(),
+          index_(),
+          usage_(0),
+          hits_(0),
+          misses_(0) {}
+
+    cv::Mat DistMapCache::get(const cv::Mat &Mask) {
+
+        const auto key = HashMat(Mask);
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (const auto cached = find(key, Mask)) {
+                ++hits_;
+                return cached->DistImage;
+            }
+        }
+
+        // the distance transform runs unlocked, such that several cameras
+        // can be processed in parallel. The mask is copied, since the
+        // caller may modify its own afterwards
+        ++misses_;
+        entry e = {key, Mask.clone(), CreateDistMap(Mask)};
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (const auto cached = find(key, Mask)) {
+            // another thread created the same map in the meantime
+            return cached->DistImage;
+        }
+
+        usage_ += GetSizeInBytes(e.Mask) + GetSizeInBytes(e.DistImage);
+        entries_.push_front(std::move(e));
+        index_.emplace(key, entries_.begin());
+        const auto DistImage = entries_.front().DistImage;
+        evict();
+        return DistImage;
+    }
+
+    const DistMapCache::entry *DistMapCache::find(const std::uint64_t key,
+                                                  const cv::Mat &Mask) {
+
+        const auto range = index_.equal_range(key);
+        for (auto it = range.first; it != range.second; ++it) {
+            if (EqualContent(it->second->Mask, Mask)) {
+                entries_.splice(entries_.begin(), entries_, it->second);
+                return &*it->second;
+            }
+        }
+        return nullptr;
+    }
+
+    void DistMapCache::evict() {
+
+        // the most recently created map is kept in any case, evicted maps
+        // stay valid for callers still holding them
+        while (usage_ > capacity_ && entries_.size() > 1) {
+            const auto last  = std::prev(entries_.end());
+            const auto range = index_.equal_range(last->key);
+            for (auto it = range.first; it != range.second; ++it) {
+                if (it->second == last) {
+                    index_.erase(it);
+                    break;
+                }
+            }
+            usage_ -= GetSizeInBytes(last->Mask) +
+                      GetSizeInBytes(last->DistImage);
+            entries_.erase(last);
+        }
+    }
+
+    void DistMapCache::clear() {
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        entries_.clear();
+        index_.clear();
+        usage_ = 0;
+    }
+
+    std::size_t DistMapCache::getSize() const {
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        return entries_.size();
+    }
+
+    std::size_t DistMapCache::getMemoryUsage() const {
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        return usage_;
+    }
+
+    std::size_t DistMapCache::getCapacity() const { return capacity_; }
+
+    std::size_t DistMapCache::getHits() const { return hits_; }
+
+    std::size_t DistMapCache::getMisses() const { return misses_; }
+
+    cv::Mat CreateDistMap(const cv::Mat &Mask, DistMapCache *cache) {
+        return cache ? cache->get(Mask) : CreateDistMap(Mask);
+    }
+} // namespace filtering
+} // namespace ret
@@ -0,0 +1,125 @@
+// Copyright (c) 2015-2016, Kai Wolf
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#ifndef FILTERING_DIST_MAP_CACHE_HPP
+#define FILTERING_DIST_MAP_CACHE_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <mutex>
+#include <unordered_map>
+
+#include <opencv2/core/core.hpp>
+
+namespace ret {
+
+namespace filtering {
+
+    /** @brief Caches the distance maps created by @ref CreateDistMap. The
+      * maps are keyed by the content of the mask, hence carving the same
+      * camera set several times, e.g. at different voxel grid resolutions
+      * or bounding box margins, computes each distance map only once,
+      * while a changed mask is detected automatically. The memory used by
+      * the cache is bounded, the least recently used maps are evicted
+      * first. The cache may be used by several threads concurrently */
+    class DistMapCache {
+      public:
+        /** @brief Default capacity of 512 MB, which holds the masks and
+          * distance maps of about 80 cameras at 1280x960 pixels */
+        static const std::size_t DEFAULT_CAPACITY = 512u << 20;
+
+        /** @brief Creates an empty cache
+          * @param capacity maximum number of bytes used by the cached
+          * masks and distance maps. A single map larger than the capacity
+          * is still cached until the next one is created */
+        explicit DistMapCache(const std::size_t capacity = DEFAULT_CAPACITY);
+
+        DistMapCache(DistMapCache const&)            = delete;
+        DistMapCache operator&=(DistMapCache const&) = delete;
+
+        /** @brief Returns the distance map of the given mask, which is
+          * created by @ref CreateDistMap on a cache miss. The returned
+          * matrix shares its data with the cache and must not be modified
+          * @param Mask binary mask of the object
+          * @return distance map of type CV_32F */
+        cv::Mat get(const cv::Mat &Mask);
+
+        /** @brief Removes all distance maps from the cache. The hit and
+          * miss counters are kept */
+        void clear();
+
+        /** @brief Returns the number of cached distance maps */
+        std::size_t getSize() const;
+
+        /** @brief Returns the number of bytes used by the cached masks
+          * and distance maps */
+        std::size_t getMemoryUsage() const;
+
+        /** @brief Returns the maximum number of bytes used by the cache */
+        std::size_t getCapacity() const;
+
+        /** @brief Returns the number of lookups served from the cache */
+        std::size_t getHits() const;
+
+        /** @brief Returns the number of lookups which created a new
+          * distance map */
+        std::size_t getMisses() const;
+
+      private:
+        struct entry {
+            std::uint64_t key;
+            cv::Mat Mask, DistImage;
+        };
+        typedef std::list<entry>::iterator entry_iterator;
+
+        /** requires mutex_ to be locked, moves a found entry to the front
+          * of the recently used list */
+        const entry *find(const std::uint64_t key, const cv::Mat &Mask);
+
+        /** requires mutex_ to be locked */
+        void evict();
+
+        const std::size_t capacity_;
+        mutable std::mutex mutex_;
+        /** entries ordered from the most to the least recently used */
+        std::list<entry> entries_;
+        std::unordered_multimap<std::uint64_t, entry_iterator> index_;
+        std::size_t usage_;
+        std::atomic<std::size_t> hits_, misses_;
+    };
+
+    /** @brief Returns the distance map of the given mask from the cache
+      * or creates it directly, if no cache is given
+      * @param Mask binary mask of the object
+      * @param cache distance map cache or nullptr
+      * @return distance map of type CV_32F */
+    cv::Mat CreateDistMap(const cv::Mat &Mask, DistMapCache *cache);
+
+    /** @brief Computes a 64 bit FNV-1a hash of the size, type and content
+      * of a matrix
+      * @param Image matrix, which need not be continuous
+      * @return hash value */
+    std::uint64_t HashMat(const cv::Mat &Image);
+} // namespace filtering
+} // namespace ret
+
+#endif
@@ -0,0 +1,69 @@
+// Copyright (c) 2015-2016, Kai Wolf
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "filtering/preprocessing.hpp"
+
+#include "common/camera.hpp"
+#include "common/dataset.hpp"
+#include "common/parallel.hpp"
+#include "filtering/dist_map_cache.hpp"
+#include "filtering/segmentation.hpp"
+
+namespace ret {
+
+namespace filtering {
+
+    void Preprocess(Camera &cam, const cv::Scalar &thresh,
+                    const bool create_dist_maps, DistMapCache *cache) {
+
+        cam.setMask(Binarize(cam.getImage(), thresh));
+        if (create_dist_maps) {
+            cam.setDistMap(CreateDistMap(cam.getMask(), cache),
+                           HashMat(cam.getMask()));
+        }
+    }
+
+    void Preprocess(DataSet &ds, const cv::Scalar &thresh,
+                    const std::size_t num_threads, const bool create_dist_maps,
+                    DistMapCache *cache) {
+
+        // every camera is owned by exactly one thread and the distance
+        // map cache is thread safe
+        ParallelFor(0, ds.size(), num_threads,
+                    [&](const std::size_t c_begin, const std::size_t c_end) {
+                        for (auto c = c_begin; c < c_end; ++c) {
+                            Preprocess(ds.getCamera(c), thresh,
+                                       create_dist_maps, cache);
+                        }
+                    });
+    }
+
+    cv::Mat GetDistMap(const Camera &cam, DistMapCache *cache) {
+
+        // a mask modified in place no longer matches the stored map
+        const auto& DistMap = cam.getDistMap();
+        const auto& Mask    = cam.getMask();
+        if (DistMap.empty() || cam.getDistMapHash() != HashMat(Mask)) {
+            return CreateDistMap(Mask, cache);
+        }
+        return DistMap;
+    }
+} // namespace filtering
+} // namespace ret
@@ -0,0 +1,75 @@
+// Copyright (c) 2015-2016, Kai Wolf
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#ifndef FILTERING_PREPROCESSING_HPP
+#define FILTERING_PREPROCESSING_HPP
+
+#include <cstddef>
+
+#include <opencv2/core/core.hpp>
+
+namespace ret { class Camera; class DataSet; }
+
+namespace ret {
+
+namespace filtering {
+
+    class DistMapCache;
+
+    /** @brief Segments the image of a single camera using @ref Binarize
+      * and stores the mask and optionally the distance map in the camera
+      * @param cam camera with image
+      * @param thresh lower HSV threshold of the background
+      * @param create_dist_maps if true, the distance map is stored as well
+      * @param cache optional cache used for creating the distance map */
+    void Preprocess(Camera &cam, const cv::Scalar &thresh,
+                    const bool create_dist_maps = true,
+                    DistMapCache *cache = nullptr);
+
+    /** @brief Segments the images of all cameras of a data set using
+      * @ref Binarize and stores the resulting masks in the cameras.
+      * Optionally the silhouettes and distance maps used for carving are
+      * created right away, see @ref CreateDistMap. The cameras are split
+      * into equally sized chunks, which are processed by at most the given
+      * number of threads
+      * @param ds data set, whose cameras are updated
+      * @param thresh lower HSV threshold of the background
+      * @param num_threads maximum number of threads, 0 uses all hardware
+      * threads
+      * @param create_dist_maps if true, the distance maps are stored in the
+      * cameras as well
+      * @param cache optional cache used for creating the distance maps */
+    void Preprocess(DataSet &ds, const cv::Scalar &thresh,
+                    const std::size_t num_threads = 0,
+                    const bool create_dist_maps = true,
+                    DistMapCache *cache = nullptr);
+
+    /** @brief Returns the distance map of a camera mask. A distance map
+      * stored in the camera is returned as it is, if it was created from
+      * the current content of the mask. Otherwise it is taken from the
+      * cache or created
+      * @param cam camera with mask
+      * @param cache distance map cache or nullptr
+      * @return distance map of type CV_32F */
+    cv::Mat GetDistMap(const Camera &cam, DistMapCache *cache = nullptr);
+} // namespace filtering
+} // namespace ret
+
+#endif
@@ -0,0 +1,263 @@
+// Copyright (c) 2015-2016, Kai Wolf
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "io/dataset_container.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <fstream>
+#include <utility>
+#include <vector>
+#include <boost/filesystem.hpp>
+#include <boost/interprocess/exceptions.hpp>
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+#include <opencv2/core/core.hpp>
+
+#include "common/camera.hpp"
+#include "common/dataset.hpp"
+#include "common/lazy_image.hpp"
+
+namespace bip = boost::interprocess;
+namespace fs  = boost::filesystem;
+namespace ret {
+
+namespace io {
+
+    namespace {
+        const char CONTAINER_MAGIC[8]        = {'R', 'E', 'T', 'D',
+                                                'S', 'E', 'T', '\0'};
+        const std::uint32_t CONTAINER_VERSION = 1;
+
+        static_assert(sizeof(ContainerHeader) == 24,
+                      "container header must not contain padding");
+        static_assert(sizeof(ContainerCameraRecord) == 200,
+                      "container camera record must not contain padding");
+
+        template <typename T, std::size_t N>
+        void CopyToArray(const cv::Mat& M, T (&dst)[N]) {
+            assert(M.total() == N && M.elemSize() == sizeof(T));
+            const cv::Mat C = M.isContinuous() ? M : M.clone();
+            std::memcpy(dst, C.data, sizeof(dst));
+        }
+
+        template <typename T, std::size_t N>
+        cv::Mat ArrayToMat(const T (&src)[N], const int rows, const int cols) {
+            assert(static_cast<std::size_t>(rows * cols) == N);
+            return cv::Mat(rows, cols, cv::DataType<T>::type,
+                           const_cast<T*>(src)).clone();
+        }
+
+        std::uint64_t AlignUp(const std::uint64_t offset,
+                              const std::uint64_t alignment) {
+            return (offset + alignment - 1) / alignment * alignment;
+        }
+
+        std::uint64_t ByteSize(const int width, const int height,
+                               const int type) {
+            return static_cast<std::uint64_t>(width) *
+                   static_cast<std::uint64_t>(height) * CV_ELEM_SIZE(type);
+        }
+
+        // images are stored with 8 or 16 bit depth and up to 4 channels,
+        // masks are single channel 8 bit
+        bool IsSupportedImageType(const std::int32_t type) {
+            const auto depth = CV_MAT_DEPTH(type);
+            const auto cn    = CV_MAT_CN(type);
+            return type == CV_MAKETYPE(depth, cn) &&
+                   (depth == CV_8U || depth == CV_16U) && cn >= 1 && cn <= 4;
+        }
+
+        bool FitsInFile(const std::uint64_t offset, const std::uint64_t size,
+                        const std::uint64_t file_size) {
+            return offset <= file_size && size <= file_size - offset;
+        }
+
+        // the types are checked before the sizes are computed from them and
+        // the byte ranges cannot wrap around, since width and height are
+        // bounded by MAX_IMAGE_DIM
+        bool IsValidRecord(const ContainerCameraRecord& rec,
+                           const std::uint64_t file_size) {
+            const std::int32_t MAX_IMAGE_DIM = 1 << 16;
+            if (rec.width <= 0 || rec.height <= 0 ||
+                rec.width > MAX_IMAGE_DIM || rec.height > MAX_IMAGE_DIM ||
+                !IsSupportedImageType(rec.image_type) ||
+                rec.mask_type != CV_8U) {
+                return false;
+            }
+            return FitsInFile(rec.image_offset,
+                              ByteSize(rec.width, rec.height, rec.image_type),
+                              file_size) &&
+                   (rec.mask_offset == 0 ||
+                    FitsInFile(rec.mask_offset,
+                               ByteSize(rec.width, rec.height, rec.mask_type),
+                               file_size));
+        }
+
+        bool WriteImage(std::ofstream& file, const std::uint64_t offset,
+                        const cv::Mat& Image) {
+            file.seekp(static_cast<std::streamoff>(offset));
+            const auto row_bytes = Image.cols * Image.elemSize();
+            for (int row = 0; row < Image.rows; ++row) {
+                file.write(reinterpret_cast<const char*>(Image.ptr(row)),
+                           static_cast<std::streamsize>(row_bytes));
+            }
+            return static_cast<bool>(file);
+        }
+    }
+
+    bool WriteDataSetContainer(const DataSet& ds, const std::string& filename,
+                               const bool with_masks) {
+
+        const std::uint64_t page_size = bip::mapped_region::get_page_size();
+        ContainerHeader header;
+        std::memcpy(header.magic, CONTAINER_MAGIC, sizeof(header.magic));
+        header.version     = CONTAINER_VERSION;
+        header.num_cameras = static_cast<std::uint32_t>(ds.size());
+        header.page_size   = page_size;
+
+        // calibration and layout first, such that the payload offsets are
+        // known before writing any image
+        const auto& cameras = ds.getCameras();
+        std::vector<ContainerCameraRecord> records(cameras.size());
+        std::vector<cv::Mat> images(cameras.size()), masks(cameras.size());
+        std::uint64_t offset = sizeof(ContainerHeader) +
+                               records.size() * sizeof(ContainerCameraRecord);
+        for (std::size_t c = 0; c < cameras.size(); ++c) {
+            const auto& cam = cameras[c];
+            auto& rec       = records[c];
+            CopyToArray(cam.getDistortionCoeffs(), rec.dist);
+            CopyToArray(cam.getCalibrationMatrix(), rec.K);
+            CopyToArray(cam.getProjectionMatrix(), rec.P);
+            CopyToArray(cam.getRotationMatrix(), rec.R);
+            CopyToArray(cam.getTranslationVector(), rec.t);
+
+            images[c] = cam.getImage();
+            if (!IsSupportedImageType(images[c].type())) {
+                return false;
+            }
+            rec.width      = images[c].cols;
+            rec.height     = images[c].rows;
+            rec.image_type = images[c].type();
+            offset           = AlignUp(offset, page_size);
+            rec.image_offset = offset;
+            offset += ByteSize(rec.width, rec.height, rec.image_type);
+
+            rec.mask_type   = CV_8U;
+            rec.mask_offset = 0;
+            const auto Mask = cam.getMask();
+            if (with_masks && Mask.size() == images[c].size() &&
+                Mask.type() == CV_8U) {
+                masks[c]        = Mask;
+                offset          = AlignUp(offset, page_size);
+                rec.mask_offset = offset;
+                offset += ByteSize(rec.width, rec.height, rec.mask_type);
+            }
+        }
+
+        std::ofstream file(filename, std::ios::binary | std::ios::trunc);
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        file.write(reinterpret_cast<const char*>(records.data()),
+                   static_cast<std::streamsize>(
+                       records.size() * sizeof(ContainerCameraRecord)));
+        for (std::size_t c = 0; c < records.size() && file; ++c) {
+            WriteImage(file, records[c].image_offset, images[c]);
+            if (records[c].mask_offset != 0) {
+                WriteImage(file, records[c].mask_offset, masks[c]);
+            }
+        }
+
+        return static_cast<bool>(file);
+    }
+
+    DataSetContainerReader::DataSetContainerReader(std::string filename)
+        : filename_(std::move(filename)) {}
+
+    std::shared_ptr<DataSet> DataSetContainerReader::load() const {
+
+        boost::system::error_code ec;
+        const auto file_size = fs::file_size(filename_, ec);
+        if (ec || file_size < sizeof(ContainerHeader)) {
+            return nullptr;
+        }
+
+        // the region is shared by all lazy images and unmapped, once the
+        // last camera referencing it is gone
+        std::shared_ptr<bip::mapped_region> region;
+        try {
+            bip::file_mapping mapping(filename_.c_str(), bip::read_only);
+            region = std::make_shared<bip::mapped_region>(mapping,
+                                                          bip::read_only);
+        } catch (const bip::interprocess_exception&) {
+            return nullptr;
+        }
+        const auto base =
+            static_cast<const unsigned char*>(region->get_address());
+
+        ContainerHeader header;
+        std::memcpy(&header, base, sizeof(header));
+        const auto records_end =
+            sizeof(ContainerHeader) +
+            static_cast<std::uint64_t>(header.num_cameras) *
+                sizeof(ContainerCameraRecord);
+        if (!std::equal(CONTAINER_MAGIC, CONTAINER_MAGIC + 8, header.magic) ||
+            header.version != CONTAINER_VERSION || records_end > file_size) {
+            return nullptr;
+        }
+
+        std::vector<ContainerCameraRecord> records(header.num_cameras);
+        std::memcpy(records.data(), base + sizeof(ContainerHeader),
+                    records.size() * sizeof(ContainerCameraRecord));
+
+        std::vector<Camera> cameras;
+        cameras.reserve(records.size());
+        for (const auto& rec : records) {
+            if (!IsValidRecord(rec, file_size)) {
+                return nullptr;
+            }
+
+            const cv::Size size(rec.width, rec.height);
+            const auto type   = rec.image_type;
+            const auto offset = rec.image_offset;
+            auto decode       = [region, size, type, offset]() {
+                auto data = static_cast<unsigned char*>(region->get_address());
+                return cv::Mat(size, type, data + offset).clone();
+            };
+            Camera cam(std::make_shared<LazyImage>(decode, size));
+            cam.setCalibrationMatrix(ArrayToMat(rec.K, 3, 3));
+            cam.setDistortionCoeffs(ArrayToMat(rec.dist, 1, 4));
+            cam.setProjectionMatrix(ArrayToMat(rec.P, 3, 4));
+            cam.setRotationMatrix(ArrayToMat(rec.R, 3, 3));
+            cam.setTranslationVector(ArrayToMat(rec.t, 4, 1));
+            if (rec.mask_offset != 0) {
+                cam.setMask(cv::Mat(size, rec.mask_type,
+                                    const_cast<unsigned char*>(base) +
+                                        rec.mask_offset).clone());
+            }
+            cameras.push_back(std::move(cam));
+        }
+
+        auto ds = std::make_shared<DataSet>();
+        ds->setCameras(std::move(cameras));
+        return ds;
+    }
+} // namespace io
+} // namespace ret
@@ -0,0 +1,91 @@
+// Copyright (c) 2015-2016, Kai Wolf
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#ifndef IO_DATASET_CONTAINER_HPP
+#define IO_DATASET_CONTAINER_HPP
+
+#include <cstdint>
+#include <memory>
+#include <string>
+
+namespace ret { class DataSet; }
+
+namespace ret {
+
+namespace io {
+
+    /** @brief Header of a packed data set container. The header is followed
+      * by one @ref ContainerCameraRecord per camera and by the raw image
+      * and mask data. Each image starts at a page boundary, such that it
+      * can be mapped into memory and paged in on access */
+    struct ContainerHeader {
+        char magic[8];
+        std::uint32_t version;
+        std::uint32_t num_cameras;
+        std::uint64_t page_size;
+    };
+
+    /** @brief Calibration of a single camera and location of its image and
+      * mask relative to the start of the container. Offsets of missing
+      * masks are 0 */
+    struct ContainerCameraRecord {
+        double dist[4];
+        float K[9];
+        float P[12];
+        float R[9];
+        float t[4];
+        std::int32_t width;
+        std::int32_t height;
+        std::int32_t image_type;
+        std::int32_t mask_type;
+        std::uint64_t image_offset;
+        std::uint64_t mask_offset;
+    };
+
+    /** @brief Writes a data set into a single binary container, which is
+      * reloaded by @ref DataSetContainerReader without parsing XML or
+      * decoding PNGs. Images and masks are stored uncompressed
+      * @param ds data set to pack, lazily loaded images are decoded
+      * @param filename path of the container file
+      * @param with_masks stores the masks of the cameras as well
+      * @return false, if the file could not be written or an image is not
+      * of 8 or 16 bit depth with 1 to 4 channels */
+    bool WriteDataSetContainer(const DataSet& ds, const std::string& filename,
+                               const bool with_masks = true);
+
+    class DataSetContainerReader {
+      public:
+        explicit DataSetContainerReader(std::string filename);
+
+        /** @brief Maps the container into memory and creates its cameras.
+          * Only the header and the calibration are read here, each image
+          * is copied out of the mapping on the first call of
+          * @ref Camera::getImage. Stored masks are set right away
+          * @return data set or nullptr, if the file is missing or no
+          * valid container */
+        std::shared_ptr<DataSet> load() const;
+
+      private:
+        std::string filename_;
+    };
+}  // namespace io
+}  // namespace ret
+
+#endif
@@ -22,16 +22,21 @@
 
 #include <algorithm>
 #include <cassert>
+#include <cstdint>
+#include <fstream>
 #include <iterator>
 #include <ostream>
 #include <type_traits>
+#include <utility>
 #include <boost/filesystem.hpp>
 #include <boost/format.hpp>
 #include <opencv2/calib3d/calib3d.hpp>
 #include <opencv2/highgui/highgui.hpp>
 
+#include "common/bounded_queue.hpp"
 #include "common/camera.hpp"
 #include "common/dataset.hpp"
+#include "common/parallel.hpp"
 
 namespace fs = boost::filesystem;
 namespace ret {
@@ -39,23 +44,73 @@ namespace ret {
 namespace io {
 
     DataSetReader::DataSetReader(std::string directory)
-        : directory_(std::move(directory)) {}
+        : directory_(std::move(directory)),
+          num_threads_(1),
+          loading_(image_loading::Eager) {}
 
     std::shared_ptr<DataSet> DataSetReader::load(
         const std::size_t numImages) const {
 
-        cv::Mat K, dist;
-        if (fs::exists(directory_ + "/K.xml")) {
-            K = loadMatrixFromFile("/K.xml", "K_matrix");
+        auto ds = std::make_shared<DataSet>();
+        if (num_threads_ == 1) {
+            read(numImages, [&ds](Camera&& cam) {
+                ds->addCamera(std::move(cam));
+                return true;
+            });
+        } else {
+            cv::Mat K, dist;
+            std::vector<cv::Mat> projMats;
+            loadCalibration(numImages, K, dist, projMats);
+            const auto image_paths = listImages(numImages);
+
+            // every camera is decoded by exactly one thread
+            std::vector<Camera> cameras(image_paths.size());
+            ParallelFor(
+                0, cameras.size(), num_threads_,
+                [&](const std::size_t c_begin, const std::size_t c_end) {
+                    for (auto c = c_begin; c < c_end; ++c) {
+                        cameras[c] = createCamera(image_paths[c], projMats[c],
+                                                  K, dist);
+                    }
+                });
+            ds->setCameras(std::move(cameras));
         }
 
-        if (fs::exists(directory_ + "/dist.xml")) {
-            dist = loadMatrixFromFile("/dist.xml", "dist_coeff");
+        assert(ds->size() == numImages);
+        return ds;
+    }
+
+    void DataSetReader::read(
+        const std::size_t numImages,
+        const std::function<bool(Camera&&)>& consumer) const {
+
+        cv::Mat K, dist;
+        std::vector<cv::Mat> projMats;
+        loadCalibration(numImages, K, dist, projMats);
+        const auto image_paths = listImages(numImages);
+        for (std::size_t camIdx = 0; camIdx < image_paths.size(); ++camIdx) {
+            if (!consumer(createCamera(image_paths[camIdx], projMats[camIdx],
+                                       K, dist))) {
+                return;
+            }
         }
-        auto projMats = loadProjectionMatrices(numImages, "/viff.xml");
+    }
+
+    void DataSetReader::setNumThreads(const std::size_t num_threads) {
+
+        num_threads_ = num_threads == 0 ? HardwareConcurrency() : num_threads;
+    }
 
+    void DataSetReader::setImageLoading(const image_loading loading) {
+
+        loading_ = loading;
+    }
+
+    std::vector<std::string> DataSetReader::listImages(
+        const std::size_t numImages) const {
+
+        std::vector<std::string> image_paths;
         fs::path dir(directory_);
-        auto ds = std::make_shared<DataSet>();
         if (fs::exists(dir) && fs::is_directory(dir)) {
             // sorting paths, since directory listing is not sorted under Linux
             using paths = std::vector<fs::path>;
@@ -64,30 +119,67 @@ namespace io {
                       std::back_inserter(stored_paths));
             std::sort(stored_paths.begin(), stored_paths.end());
 
-            std::size_t camIdx = 0;
             for (paths::const_iterator iter(stored_paths.begin());
-                 iter != stored_paths.end(); ++iter) {
+                 iter != stored_paths.end() && image_paths.size() < numImages;
+                 ++iter) {
                 if (fs::is_regular_file(*iter) && iter->extension() == ".png") {
-                    cv::Mat P = projMats[camIdx++];
-                    cv::Mat R, K2, t;
-                    cv::decomposeProjectionMatrix(P, K2, R, t);
-
-                    Camera cam(cv::imread(iter->string()));
-                    cam.setCalibrationMatrix(K.empty() ? K2 : K);
-                    if (!dist.empty()) {
-                        cam.setDistortionCoeffs(dist);
-                    }
-                    cam.setProjectionMatrix(P);
-                    cam.setRotationMatrix(R);
-                    cam.setTranslationVector(t);
-
-                    ds->addCamera(cam);
+                    image_paths.push_back(iter->string());
                 }
             }
         }
 
-        assert(ds->size() == numImages);
-        return ds;
+        return image_paths;
+    }
+
+    void DataSetReader::loadCalibration(const std::size_t numImages,
+                                        cv::Mat& K, cv::Mat& dist,
+                                        std::vector<cv::Mat>& projMats) const {
+
+        if (fs::exists(directory_ + "/K.xml")) {
+            K = loadMatrixFromFile("/K.xml", "K_matrix");
+        }
+
+        if (fs::exists(directory_ + "/dist.xml")) {
+            dist = loadMatrixFromFile("/dist.xml", "dist_coeff");
+        }
+        projMats = loadProjectionMatrices(numImages, "/viff.xml");
+    }
+
+    Camera DataSetReader::createCamera(const std::string& image_path,
+                                       const cv::Mat& P, const cv::Mat& K,
+                                       const cv::Mat& dist) const {
+
+        cv::Mat R, K2, t;
+        cv::decomposeProjectionMatrix(P, K2, R, t);
+
+        const auto image_size = loading_ == image_loading::Lazy
+                                    ? ReadImageSize(image_path)
+                                    : cv::Size();
+        Camera cam = image_size.area() > 0 ? Camera(image_path, image_size)
+                                           : Camera(cv::imread(image_path));
+        cam.setCalibrationMatrix(K.empty() ? K2 : K);
+        if (!dist.empty()) {
+            cam.setDistortionCoeffs(dist);
+        }
+        cam.setProjectionMatrix(P);
+        cam.setRotationMatrix(R);
+        cam.setTranslationVector(t);
+
+        return cam;
+    }
+
+    void DataSetReader::stream(const std::size_t numImages,
+                               BoundedQueue<Camera>& queue) const {
+
+        try {
+            read(numImages, [&queue](Camera&& cam) {
+                return queue.push(std::move(cam));
+            });
+        } catch (...) {
+            queue.close();
+            throw;
+        }
+        queue.close();
     }
 
     cv::Mat DataSetReader::loadMatrixFromFile(
@@ -113,5 +205,28 @@ namespace io {
         return projMats;
     }
 
+    cv::Size ReadImageSize(const std::string& filename) {
+
+        // 8 byte signature followed by the IHDR chunk, which stores width
+        // and height as big endian 32 bit integers
+        static const unsigned char signature[] = {0x89, 'P',  'N',  'G',
+                                                  '\r', '\n', 0x1a, '\n'};
+        unsigned char header[24];
+        std::ifstream file(filename, std::ios::binary);
+        if (!file.read(reinterpret_cast<char*>(header), sizeof(header)) ||
+            !std::equal(signature, signature + 8, header) ||
+            !std::equal(header + 12, header + 16, "IHDR")) {
+            return cv::Size();
+        }
+
+        auto read_u32 = [&header](const std::size_t offset) {
+            return static_cast<int>(
+                (static_cast<std::uint32_t>(header[offset]) << 24) |
+                (static_cast<std::uint32_t>(header[offset + 1]) << 16) |
+                (static_cast<std::uint32_t>(header[offset + 2]) << 8) |
+                static_cast<std::uint32_t>(header[offset + 3]));
+        };
+        return cv::Size(read_u32(16), read_u32(20));
+    }
 } // namespace io
 } // namespace ret
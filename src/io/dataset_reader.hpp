@@ -22,30 +22,80 @@
 #define IO_DATASET_READER_HPP
 
 #include <cstddef>
+#include <functional>
 #include <iosfwd>
 #include <memory>
 #include <opencv2/core/core.hpp>
 #include <string>
 #include <vector>
 
-namespace ret { class DataSet; }
+namespace ret { class Camera; class DataSet; }
+namespace ret { template <typename T> class BoundedQueue; }
 
 namespace ret {
 
 namespace io {
 
+    /** @brief Image handling of @ref DataSetReader. Eager decodes every
+      * image while loading, Lazy only reads the image size and decodes
+      * each image on first access, see @ref Camera::getImage */
+    enum class image_loading { Eager, Lazy };
+
     class DataSetReader {
       public:
         explicit DataSetReader(std::string directory);
         std::shared_ptr<DataSet> load(const std::size_t numImages) const;
 
+        /** @brief Sets the number of threads decoding images in
+          * @ref load. Defaults to 1
+          * @param num_threads number of threads, 0 uses all hardware
+          * threads */
+        void setNumThreads(const std::size_t num_threads);
+
+        /** @brief Selects whether images are decoded while loading or on
+          * first access. Defaults to image_loading::Eager
+          * @param loading image handling */
+        void setImageLoading(const image_loading loading);
+
+        /** @brief Decodes the cameras in the same order as @ref load, but
+          * passes each camera to the consumer right after decoding it
+          * instead of collecting the whole data set
+          * @param numImages number of images to decode
+          * @param consumer called for each camera, returns false to stop
+          * decoding */
+        void read(const std::size_t numImages,
+                  const std::function<bool(Camera&&)>& consumer) const;
+
+        /** @brief Decodes the cameras into a bounded queue, such that at
+          * most its capacity of decoded images is held at once. The queue
+          * is closed after the last camera, if decoding fails or if the
+          * consumer closes the queue early. Meant to run on its own thread
+          * @param numImages number of images to decode
+          * @param queue receives the decoded cameras */
+        void stream(const std::size_t numImages,
+                    BoundedQueue<Camera>& queue) const;
+
       private:
+        std::vector<std::string> listImages(const std::size_t numImages) const;
+        void loadCalibration(const std::size_t numImages, cv::Mat& K,
+                             cv::Mat& dist,
+                             std::vector<cv::Mat>& projMats) const;
+        Camera createCamera(const std::string& image_path, const cv::Mat& P,
+                            const cv::Mat& K, const cv::Mat& dist) const;
         cv::Mat loadMatrixFromFile(const std::string& filename,
                                    const std::string& matname) const;
         std::vector<cv::Mat> loadProjectionMatrices(
             const std::size_t numMatrices, const std::string& filename) const;
         std::string directory_;
+        std::size_t num_threads_;
+        image_loading loading_;
     };
+
+    /** @brief Reads the size of a PNG image from its header without
+      * decoding the image
+      * @param filename path of the image file
+      * @return image size or an empty size, if the file is no PNG */
+    cv::Size ReadImageSize(const std::string& filename);
 }  // namespace io
 }  // namespace ret
 
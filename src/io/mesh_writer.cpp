@@ -0,0 +1,535 @@
+// Copyright (c) 2015-2016, Kai Wolf
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "io/mesh_writer.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <unordered_map>
+
+#include <vtkCellArray.h>
+#include <vtkDataArray.h>
+#include <vtkIdList.h>
+#include <vtkPointData.h>
+#include <vtkPoints.h>
+#include <vtkPolyData.h>
+#include <vtkSmartPointer.h>
+#include <vtkUnsignedCharArray.h>
+
+namespace ret {
+
+namespace io {
+
+    namespace {
+
+        const std::size_t BUFFER_SIZE = 1 << 20;
+
+        /// upper bound of the bytes written per vertex or face
+        const std::size_t MAX_RECORD_SIZE = 256;
+
+        // file output through a fixed size buffer, into which records are
+        // formatted directly
+        class OutputBuffer {
+          public:
+            explicit OutputBuffer(const std::string& filename)
+                : file_(std::fopen(filename.c_str(), "wb")),
+                  buffer_(BUFFER_SIZE),
+                  size_(0),
+                  failed_(file_ == nullptr) {}
+
+            ~OutputBuffer() { close(); }
+
+            OutputBuffer(OutputBuffer const&)            = delete;
+            OutputBuffer operator&=(OutputBuffer const&) = delete;
+
+            // returns space for at least MAX_RECORD_SIZE bytes, which is
+            // handed back by commit
+            char* reserve() {
+                if (size_ + MAX_RECORD_SIZE > buffer_.size()) {
+                    flush();
+                }
+                return buffer_.data() + size_;
+            }
+
+            void commit(const char* end) {
+                size_ = static_cast<std::size_t>(end - buffer_.data());
+                assert(size_ <= buffer_.size());
+            }
+
+            void write(const void* data, const std::size_t num_bytes) {
+                if (size_ + num_bytes > buffer_.size()) {
+                    flush();
+                }
+                if (num_bytes > buffer_.size()) {
+                    failed_ = failed_ || file_ == nullptr ||
+                              std::fwrite(data, 1, num_bytes, file_) !=
+                                  num_bytes;
+                    return;
+                }
+                std::memcpy(buffer_.data() + size_, data, num_bytes);
+                size_ += num_bytes;
+            }
+
+            bool close() {
+                flush();
+                if (file_ != nullptr) {
+                    failed_ = std::fclose(file_) != 0 || failed_;
+                    file_   = nullptr;
+                }
+                return !failed_;
+            }
+
+          private:
+            void flush() {
+                if (file_ != nullptr && size_ > 0) {
+                    failed_ = std::fwrite(buffer_.data(), 1, size_, file_) !=
+                                  size_ ||
+                              failed_;
+                }
+                size_ = 0;
+            }
+
+            std::FILE* file_;
+            std::vector<char> buffer_;
+            std::size_t size_;
+            bool failed_;
+        };
+
+        void WriteText(OutputBuffer& out, const char* text) {
+            out.write(text, std::strlen(text));
+        }
+
+        char* FormatUInt(std::uint64_t value, char* out) {
+            char digits[20];
+            auto num_digits = 0;
+            do {
+                digits[num_digits++] = static_cast<char>('0' + value % 10);
+                value /= 10;
+            } while (value != 0);
+            while (num_digits > 0) {
+                *out++ = digits[--num_digits];
+            }
+            return out;
+        }
+
+        // six decimal places without trailing zeros, which is exact enough
+        // for world coordinates and avoids the locale aware stream output
+        char* FormatFloat(const float value, char* out) {
+            if (!std::isfinite(value) || std::fabs(value) >= 1e9f) {
+                return out + std::sprintf(out, "%g", value);
+            }
+
+            const auto scaled = static_cast<std::uint64_t>(
+                std::llround(std::fabs(static_cast<double>(value)) * 1e6));
+            if (scaled != 0 && value < 0.0f) {
+                *out++ = '-';
+            }
+            out       = FormatUInt(scaled / 1000000, out);
+            auto frac = static_cast<std::uint32_t>(scaled % 1000000);
+            if (frac != 0) {
+                *out++          = '.';
+                auto num_digits = 6;
+                for (; frac % 10 == 0; frac /= 10) {
+                    --num_digits;
+                }
+                for (auto d = num_digits - 1; d >= 0; --d, frac /= 10) {
+                    out[d] = static_cast<char>('0' + frac % 10);
+                }
+                out += num_digits;
+            }
+            return out;
+        }
+
+        char* FormatVec3(const char* prefix, const vec3f& v, char* out) {
+            while (*prefix != '\0') {
+                *out++ = *prefix++;
+            }
+            out    = FormatFloat(v.x, out);
+            *out++ = ' ';
+            out    = FormatFloat(v.y, out);
+            *out++ = ' ';
+            out    = FormatFloat(v.z, out);
+            *out++ = '\n';
+            return out;
+        }
+
+        bool IsLittleEndian() {
+            const std::uint16_t probe = 1;
+            unsigned char first_byte;
+            std::memcpy(&first_byte, &probe, 1);
+            return first_byte == 1;
+        }
+
+        // Each mesh source provides numVertices, vertex, hasVertexNormals,
+        // numNormals, normal, hasColors, color, numFaces and forEachFace,
+        // which passes the vertex and normal indices of each triangle
+
+        class IndexedSource {
+          public:
+            IndexedSource(const std::vector<vec3f>& vertices,
+                          const std::vector<vec3f>& normals,
+                          const std::vector<std::uint32_t>& indices)
+                : vertices_(vertices), normals_(normals), indices_(indices) {
+                assert(normals.empty() || normals.size() == vertices.size());
+                assert(indices.size() % 3 == 0);
+            }
+
+            std::size_t numVertices() const { return vertices_.size(); }
+            vec3f vertex(const std::size_t idx) const {
+                return vertices_[idx];
+            }
+            bool hasVertexNormals() const { return !normals_.empty(); }
+            std::size_t numNormals() const { return normals_.size(); }
+            vec3f normal(const std::size_t idx) const {
+                return normals_[idx];
+            }
+            bool hasColors() const { return false; }
+            void color(const std::size_t, unsigned char*) const {}
+            std::size_t numFaces() const { return indices_.size() / 3; }
+
+            template <typename Func>
+            void forEachFace(Func func) const {
+                for (std::size_t idx = 0; idx + 2 < indices_.size();
+                     idx += 3) {
+                    const auto v = &indices_[idx];
+                    func(v, v);
+                }
+            }
+
+          private:
+            const std::vector<vec3f>& vertices_;
+            const std::vector<vec3f>& normals_;
+            const std::vector<std::uint32_t>& indices_;
+        };
+
+        struct vec3f_hash {
+            std::size_t operator()(const vec3f& v) const {
+                std::uint32_t bits[3];
+                std::memcpy(bits, &v, sizeof(bits));
+                return (bits[0] * 73856093u) ^ (bits[1] * 19349663u) ^
+                       (bits[2] * 83492791u);
+            }
+        };
+
+        // welds vertices at exactly the same position, normals are given
+        // per triangle
+        class SoupSource {
+          public:
+            SoupSource(const std::vector<triangle>& triangles,
+                       const std::vector<vec3f>& face_normals)
+                : vertices_(), indices_(), face_normals_(face_normals) {
+                assert(face_normals.empty() ||
+                       face_normals.size() == triangles.size());
+
+                std::unordered_map<vec3f, std::uint32_t, vec3f_hash> welded;
+                welded.reserve(triangles.size() * 2);
+                indices_.reserve(triangles.size() * 3);
+                for (const auto& tri : triangles) {
+                    for (const auto& v : {tri.comp.v1, tri.comp.v2,
+                                          tri.comp.v3}) {
+                        // +0.0f maps -0 onto 0, which compare equal
+                        const vec3f key(v.x + 0.0f, v.y + 0.0f, v.z + 0.0f);
+                        const auto next =
+                            static_cast<std::uint32_t>(vertices_.size());
+                        const auto it = welded.emplace(key, next);
+                        if (it.second) {
+                            vertices_.push_back(v);
+                        }
+                        indices_.push_back(it.first->second);
+                    }
+                }
+            }
+
+            std::size_t numVertices() const { return vertices_.size(); }
+            vec3f vertex(const std::size_t idx) const {
+                return vertices_[idx];
+            }
+            bool hasVertexNormals() const { return false; }
+            std::size_t numNormals() const { return face_normals_.size(); }
+            vec3f normal(const std::size_t idx) const {
+                return face_normals_[idx];
+            }
+            bool hasColors() const { return false; }
+            void color(const std::size_t, unsigned char*) const {}
+            std::size_t numFaces() const { return indices_.size() / 3; }
+
+            template <typename Func>
+            void forEachFace(Func func) const {
+                for (std::size_t f = 0; f < numFaces(); ++f) {
+                    const auto n = static_cast<std::uint32_t>(f);
+                    const std::uint32_t normals[] = {n, n, n};
+                    func(&indices_[3 * f], normals);
+                }
+            }
+
+          private:
+            std::vector<vec3f> vertices_;
+            std::vector<std::uint32_t> indices_;
+            const std::vector<vec3f>& face_normals_;
+        };
+
+        class PolyDataSource {
+          public:
+            explicit PolyDataSource(vtkPolyData* mesh)
+                : mesh_(mesh),
+                  normals_(mesh->GetPointData()->GetNormals()),
+                  colors_(vtkUnsignedCharArray::SafeDownCast(
+                      mesh->GetPointData()->GetArray("Colors"))),
+                  num_faces_(0) {
+
+                if (normals_ != nullptr &&
+                    (normals_->GetNumberOfComponents() != 3 ||
+                     normals_->GetNumberOfTuples() !=
+                         mesh->GetNumberOfPoints())) {
+                    normals_ = nullptr;
+                }
+                if (colors_ != nullptr &&
+                    (colors_->GetNumberOfComponents() < 3 ||
+                     colors_->GetNumberOfTuples() !=
+                         mesh->GetNumberOfPoints())) {
+                    colors_ = nullptr;
+                }
+                forEachPolygon([this](vtkIdList* ids) {
+                    num_faces_ += static_cast<std::size_t>(
+                        ids->GetNumberOfIds() - 2);
+                });
+            }
+
+            std::size_t numVertices() const {
+                return static_cast<std::size_t>(mesh_->GetNumberOfPoints());
+            }
+            vec3f vertex(const std::size_t idx) const {
+                double v[3];
+                mesh_->GetPoint(static_cast<vtkIdType>(idx), v);
+                return vec3f(static_cast<float>(v[0]),
+                             static_cast<float>(v[1]),
+                             static_cast<float>(v[2]));
+            }
+            bool hasVertexNormals() const { return normals_ != nullptr; }
+            std::size_t numNormals() const {
+                return normals_ != nullptr ? numVertices() : 0;
+            }
+            vec3f normal(const std::size_t idx) const {
+                double n[3];
+                normals_->GetTuple(static_cast<vtkIdType>(idx), n);
+                return vec3f(static_cast<float>(n[0]),
+                             static_cast<float>(n[1]),
+                             static_cast<float>(n[2]));
+            }
+            bool hasColors() const { return colors_ != nullptr; }
+            void color(const std::size_t idx, unsigned char* rgb) const {
+                const auto num_comps = colors_->GetNumberOfComponents();
+                std::copy_n(colors_->GetPointer(0) +
+                                static_cast<vtkIdType>(idx) * num_comps,
+                            3, rgb);
+            }
+            std::size_t numFaces() const { return num_faces_; }
+
+            template <typename Func>
+            void forEachFace(Func func) const {
+                forEachPolygon([&func](vtkIdList* ids) {
+                    const auto first =
+                        static_cast<std::uint32_t>(ids->GetId(0));
+                    for (vtkIdType idx = 1; idx + 1 < ids->GetNumberOfIds();
+                         ++idx) {
+                        const std::uint32_t v[] = {
+                            first, static_cast<std::uint32_t>(ids->GetId(idx)),
+                            static_cast<std::uint32_t>(ids->GetId(idx + 1))};
+                        func(v, v);
+                    }
+                });
+            }
+
+          private:
+            // visits all polygons with at least three points
+            void forEachPolygon(
+                const std::function<void(vtkIdList*)>& func) const {
+                auto polys = mesh_->GetPolys();
+                if (polys == nullptr) {
+                    return;
+                }
+                auto ids = vtkSmartPointer<vtkIdList>::New();
+                polys->InitTraversal();
+                while (polys->GetNextCell(ids) != 0) {
+                    if (ids->GetNumberOfIds() >= 3) {
+                        func(ids);
+                    }
+                }
+            }
+
+            vtkPolyData* mesh_;
+            vtkDataArray* normals_;
+            vtkUnsignedCharArray* colors_;
+            std::size_t num_faces_;
+        };
+
+        template <typename Source>
+        bool WritePLYSource(const std::string& filename,
+                            const Source& source) {
+
+            OutputBuffer out(filename);
+            WriteText(out, IsLittleEndian()
+                               ? "ply\nformat binary_little_endian 1.0\n"
+                               : "ply\nformat binary_big_endian 1.0\n");
+            WriteText(out, "element vertex ");
+            out.commit(FormatUInt(source.numVertices(), out.reserve()));
+            WriteText(out, "\nproperty float x\nproperty float y"
+                           "\nproperty float z\n");
+            if (source.hasVertexNormals()) {
+                WriteText(out, "property float nx\nproperty float ny"
+                               "\nproperty float nz\n");
+            }
+            if (source.hasColors()) {
+                WriteText(out, "property uchar red\nproperty uchar green"
+                               "\nproperty uchar blue\n");
+            }
+            WriteText(out, "element face ");
+            out.commit(FormatUInt(source.numFaces(), out.reserve()));
+            WriteText(out, "\nproperty list uchar int vertex_indices"
+                           "\nend_header\n");
+
+            // vertex records are packed without padding
+            char record[6 * sizeof(float) + 3];
+            for (std::size_t idx = 0; idx < source.numVertices(); ++idx) {
+                const auto v = source.vertex(idx);
+                std::memcpy(record, &v.x, sizeof(float));
+                std::memcpy(record + 4, &v.y, sizeof(float));
+                std::memcpy(record + 8, &v.z, sizeof(float));
+                std::size_t len = 12;
+                if (source.hasVertexNormals()) {
+                    const auto n = source.normal(idx);
+                    std::memcpy(record + len, &n.x, sizeof(float));
+                    std::memcpy(record + len + 4, &n.y, sizeof(float));
+                    std::memcpy(record + len + 8, &n.z, sizeof(float));
+                    len += 12;
+                }
+                if (source.hasColors()) {
+                    source.color(idx,
+                                 reinterpret_cast<unsigned char*>(record) +
+                                     len);
+                    len += 3;
+                }
+                out.write(record, len);
+            }
+
+            source.forEachFace(
+                [&out](const std::uint32_t* v, const std::uint32_t*) {
+                    char face[1 + 3 * sizeof(std::int32_t)];
+                    face[0] = 3;
+                    std::memcpy(face + 1, v, 3 * sizeof(std::int32_t));
+                    out.write(face, sizeof(face));
+                });
+
+            return out.close();
+        }
+
+        template <typename Source>
+        bool WriteOBJSource(const std::string& filename, const Source& source,
+                            const bool reverse_winding) {
+
+            OutputBuffer out(filename);
+            for (std::size_t idx = 0; idx < source.numVertices(); ++idx) {
+                out.commit(FormatVec3("v ", source.vertex(idx),
+                                      out.reserve()));
+            }
+            for (std::size_t idx = 0; idx < source.numNormals(); ++idx) {
+                out.commit(FormatVec3("vn ", source.normal(idx),
+                                      out.reserve()));
+            }
+
+            // obj indices are one-based, reversed faces are written from
+            // the last to the first corner
+            const auto with_normals = source.numNormals() > 0;
+            const int corners[2][3] = {{0, 1, 2}, {2, 1, 0}};
+            const auto order = corners[reverse_winding ? 1 : 0];
+            source.forEachFace([&out, with_normals, order](
+                const std::uint32_t* v, const std::uint32_t* n) {
+                char* p = out.reserve();
+                *p++    = 'f';
+                for (const auto c : {order[0], order[1], order[2]}) {
+                    *p++ = ' ';
+                    p    = FormatUInt(v[c] + 1u, p);
+                    if (with_normals) {
+                        *p++ = '/';
+                        *p++ = '/';
+                        p    = FormatUInt(n[c] + 1u, p);
+                    }
+                }
+                *p++ = '\n';
+                out.commit(p);
+            });
+
+            return out.close();
+        }
+    } // namespace
+
+    bool WritePLY(const std::string& filename,
+                  const std::vector<vec3f>& vertices,
+                  const std::vector<vec3f>& normals,
+                  const std::vector<std::uint32_t>& indices) {
+
+        return WritePLYSource(filename,
+                              IndexedSource(vertices, normals, indices));
+    }
+
+    bool WritePLY(const std::string& filename,
+                  const std::vector<triangle>& triangles) {
+
+        const std::vector<vec3f> no_normals;
+        return WritePLYSource(filename, SoupSource(triangles, no_normals));
+    }
+
+    bool WritePLY(const std::string& filename, vtkPolyData* mesh) {
+
+        assert(mesh != nullptr);
+        return WritePLYSource(filename, PolyDataSource(mesh));
+    }
+
+    bool WriteOBJ(const std::string& filename,
+                  const std::vector<vec3f>& vertices,
+                  const std::vector<vec3f>& normals,
+                  const std::vector<std::uint32_t>& indices,
+                  const bool reverse_winding) {
+
+        return WriteOBJSource(filename,
+                              IndexedSource(vertices, normals, indices),
+                              reverse_winding);
+    }
+
+    bool WriteOBJ(const std::string& filename,
+                  const std::vector<triangle>& triangles,
+                  const std::vector<vec3f>& face_normals,
+                  const bool reverse_winding) {
+
+        return WriteOBJSource(filename, SoupSource(triangles, face_normals),
+                              reverse_winding);
+    }
+
+    bool WriteOBJ(const std::string& filename, vtkPolyData* mesh) {
+
+        assert(mesh != nullptr);
+        return WriteOBJSource(filename, PolyDataSource(mesh), false);
+    }
+} // namespace io
+} // namespace ret
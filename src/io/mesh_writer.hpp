@@ -0,0 +1,108 @@
+// Copyright (c) 2015-2016, Kai Wolf
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#ifndef IO_MESH_WRITER_HPP
+#define IO_MESH_WRITER_HPP
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "common/types/triangle.hpp"
+#include "common/types/vec3f.hpp"
+
+class vtkPolyData;
+
+namespace ret {
+
+namespace io {
+
+    /** @brief Writes an indexed mesh as binary PLY file. Vertices and
+      * faces are streamed through a fixed size buffer, hence no
+      * intermediate copy of the mesh is created
+      * @param filename path of the PLY file
+      * @param vertices vertex positions
+      * @param normals one normal per vertex or empty
+      * @param indices three vertex indices per triangle
+      * @return false, if the file could not be written */
+    bool WritePLY(const std::string& filename,
+                  const std::vector<vec3f>& vertices,
+                  const std::vector<vec3f>& normals,
+                  const std::vector<std::uint32_t>& indices);
+
+    /** @brief Writes a triangle soup as indexed binary PLY file. Vertices
+      * at exactly the same position are written only once
+      * @param filename path of the PLY file
+      * @param triangles triangles as returned by
+      * @ref rendering::mc::MarchingCubes::getTriangles
+      * @return false, if the file could not be written */
+    bool WritePLY(const std::string& filename,
+                  const std::vector<triangle>& triangles);
+
+    /** @brief Writes the triangles of a vtk mesh as binary PLY file,
+      * including its point normals and the colors created by
+      * @ref rendering::Colorize, if present. Polygons with more than three
+      * points are triangulated as fan
+      * @param filename path of the PLY file
+      * @param mesh triangle mesh
+      * @return false, if the file could not be written */
+    bool WritePLY(const std::string& filename, vtkPolyData* mesh);
+
+    /** @brief Writes an indexed mesh as ASCII OBJ file. Numbers are
+      * formatted directly into the output buffer, coordinates with six
+      * decimal places
+      * @param filename path of the OBJ file
+      * @param vertices vertex positions
+      * @param normals one normal per vertex or empty
+      * @param indices three vertex indices per triangle
+      * @param reverse_winding writes the corners of each triangle in
+      * reverse order
+      * @return false, if the file could not be written */
+    bool WriteOBJ(const std::string& filename,
+                  const std::vector<vec3f>& vertices,
+                  const std::vector<vec3f>& normals,
+                  const std::vector<std::uint32_t>& indices,
+                  const bool reverse_winding = false);
+
+    /** @brief Writes a triangle soup as indexed ASCII OBJ file. Vertices
+      * at exactly the same position are written only once
+      * @param filename path of the OBJ file
+      * @param triangles triangles as returned by
+      * @ref rendering::mc::MarchingCubes::getTriangles
+      * @param face_normals one normal per triangle or empty
+      * @param reverse_winding writes the corners of each triangle in
+      * reverse order
+      * @return false, if the file could not be written */
+    bool WriteOBJ(const std::string& filename,
+                  const std::vector<triangle>& triangles,
+                  const std::vector<vec3f>& face_normals =
+                      std::vector<vec3f>(),
+                  const bool reverse_winding = false);
+
+    /** @brief Writes the triangles and point normals of a vtk mesh as
+      * ASCII OBJ file, see @ref WritePLY
+      * @param filename path of the OBJ file
+      * @param mesh triangle mesh
+      * @return false, if the file could not be written */
+    bool WriteOBJ(const std::string& filename, vtkPolyData* mesh);
+}  // namespace io
+}  // namespace ret
+
+#endif
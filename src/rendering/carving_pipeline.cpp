@@ -0,0 +1,95 @@
+// Copyright (c) 2015-2016, Kai Wolf
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "rendering/carving_pipeline.hpp"
+
+#include <exception>
+#include <thread>
+#include <utility>
+
+#include "common/bounded_queue.hpp"
+#include "common/camera.hpp"
+#include "filtering/preprocessing.hpp"
+#include "io/dataset_reader.hpp"
+#include "rendering/voxel_carving.hpp"
+
+namespace ret {
+
+namespace rendering {
+
+    std::size_t CarveStreaming(const io::DataSetReader& reader,
+                               const std::size_t num_images,
+                               const cv::Scalar& thresh, VoxelCarving& vc,
+                               const std::size_t capacity) {
+
+        BoundedQueue<Camera> decoded(capacity), segmented(capacity);
+        std::exception_ptr decode_error, segment_error;
+
+        std::thread decoder([&]() {
+            try {
+                reader.stream(num_images, decoded);
+            } catch (...) {
+                decode_error = std::current_exception();
+            }
+        });
+
+        // closing both queues also stops the decoder, if segmentation or
+        // carving fails
+        std::thread segmenter([&]() {
+            try {
+                Camera cam;
+                while (decoded.pop(cam)) {
+                    filtering::Preprocess(cam, thresh);
+                    if (!segmented.push(std::move(cam))) {
+                        break;
+                    }
+                }
+            } catch (...) {
+                segment_error = std::current_exception();
+            }
+            decoded.close();
+            segmented.close();
+        });
+
+        std::size_t num_carved = 0;
+        std::exception_ptr carve_error;
+        try {
+            Camera cam;
+            while (segmented.pop(cam)) {
+                vc.carve(cam);
+                ++num_carved;
+            }
+        } catch (...) {
+            carve_error = std::current_exception();
+            decoded.close();
+            segmented.close();
+        }
+
+        decoder.join();
+        segmenter.join();
+        for (const auto& error : {decode_error, segment_error, carve_error}) {
+            if (error) {
+                std::rethrow_exception(error);
+            }
+        }
+        return num_carved;
+    }
+} // namespace rendering
+} // namespace ret
@@ -0,0 +1,62 @@
+// Copyright (c) 2015-2016, Kai Wolf
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#ifndef RENDERING_CARVING_PIPELINE_HPP
+#define RENDERING_CARVING_PIPELINE_HPP
+
+#include <cstddef>
+
+#include <opencv2/core/core.hpp>
+
+namespace ret { namespace io { class DataSetReader; } }
+
+namespace ret {
+
+namespace rendering {
+
+    class VoxelCarving;
+
+    /** @brief Carves a data set while it is still being decoded. Decoding,
+      * segmentation and carving run as three stages on their own threads,
+      * connected by bounded queues. Each camera is carved as soon as its
+      * mask and distance map are available and dropped afterwards, hence
+      * at most 2 * capacity + 3 decoded images are held at once and the
+      * total runtime approaches the one of the slowest stage instead of
+      * the sum of all stages. The cameras are carved in the order of
+      * @ref io::DataSetReader::load, thus the result is identical to
+      * calling @ref VoxelCarving::carve for each camera. Since the cameras
+      * are not kept, the bounding box of the voxel grid has to be known
+      * in advance. Exceptions of any stage are rethrown after all stages
+      * have stopped
+      * @param reader data set to decode
+      * @param num_images number of images to decode
+      * @param thresh lower HSV threshold of the background, see
+      * @ref filtering::Binarize
+      * @param vc voxel carving, which is carved on the calling thread
+      * @param capacity number of cameras buffered between two stages
+      * @return number of carved cameras */
+    std::size_t CarveStreaming(const io::DataSetReader& reader,
+                               const std::size_t num_images,
+                               const cv::Scalar& thresh, VoxelCarving& vc,
+                               const std::size_t capacity = 2);
+} // namespace rendering
+} // namespace ret
+
+#endif
@@ -28,13 +28,11 @@
 namespace ret {
 
 template <typename coord, typename point>
-coord project(const Camera& cam, const point& v) {
+coord project(const cv::Mat& P, const point& v) {
 
     coord im;
 
     // project voxel into camera image coords
-    auto P = cam.getProjectionMatrix();
-
     auto z = P.at<float>(2, 0) * v.x + P.at<float>(2, 1) * v.y +
              P.at<float>(2, 2) * v.z + P.at<float>(2, 3);
 
@@ -48,6 +46,12 @@ coord project(const Camera& cam, const point& v) {
 
     return im;
 }
+
+template <typename coord, typename point>
+coord project(const Camera& cam, const point& v) {
+
+    return project<coord, point>(cam.getProjectionMatrix(), v);
+}
 }  // namespace ret
 
 #endif
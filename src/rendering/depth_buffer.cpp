@@ -0,0 +1,345 @@
+// Copyright (c) 2015-2016, Kai Wolf
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "rendering/depth_buffer.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <memory>
+
+#include <vtkCellArray.h>
+#include <vtkIdList.h>
+#include <vtkPolyData.h>
+
+#include "common/camera.hpp"
+#include "common/parallel.hpp"
+#include "rendering/projection_table.hpp"
+
+namespace ret {
+
+namespace rendering {
+
+    namespace {
+
+        // twice the signed area of (a, b, p), positive if p is left of a->b
+        inline float Edge(const screen_vertex& a, const screen_vertex& b,
+                          const float px, const float py) {
+            return (b.x - a.x) * (py - a.y) - (b.y - a.y) * (px - a.x);
+        }
+
+        // vertices behind the camera project to non-finite coordinates
+        inline bool IsFinite(const screen_vertex& v) {
+            return std::isfinite(v.x) && std::isfinite(v.y) &&
+                   std::isfinite(v.inv_depth);
+        }
+
+        // floors a coordinate clamped to [lo, hi], which keeps the cast in
+        // the range of int
+        inline int ClampFloor(const float v, const float lo, const float hi) {
+            return static_cast<int>(std::floor(std::min(std::max(v, lo), hi)));
+        }
+
+        std::size_t ResolveThreads(const std::size_t num_threads) {
+            return num_threads == 0 ? HardwareConcurrency() : num_threads;
+        }
+
+        // splits all polygons of the mesh into triangle fans
+        std::vector<std::uint32_t> Triangulate(vtkPolyData* mesh) {
+
+            std::vector<std::uint32_t> indices;
+            auto polys = mesh->GetPolys();
+            if (polys == nullptr) {
+                return indices;
+            }
+            indices.reserve(3 * static_cast<std::size_t>(
+                                    polys->GetNumberOfCells()));
+            auto ids = vtkSmartPointer<vtkIdList>::New();
+            polys->InitTraversal();
+            while (polys->GetNextCell(ids) != 0) {
+                for (vtkIdType idx = 1; idx + 1 < ids->GetNumberOfIds();
+                     ++idx) {
+                    indices.push_back(
+                        static_cast<std::uint32_t>(ids->GetId(0)));
+                    indices.push_back(
+                        static_cast<std::uint32_t>(ids->GetId(idx)));
+                    indices.push_back(
+                        static_cast<std::uint32_t>(ids->GetId(idx + 1)));
+                }
+            }
+            return indices;
+        }
+
+        // projects the vertices in double precision, such that the image
+        // coordinates equal the ones of ProjectionTable::project
+        void ProjectVertices(const std::vector<cv::Point3d>& points,
+                             const ProjectionTable& table,
+                             const std::size_t cam_idx,
+                             const std::size_t num_threads,
+                             std::vector<screen_vertex>& vertices) {
+
+            const auto s = table.getStride();
+            const auto P = table.getRow(ProjectionTable::P00) + cam_idx;
+            vertices.resize(points.size());
+            ParallelFor(
+                0, points.size(), num_threads,
+                [&](const std::size_t begin, const std::size_t end) {
+                    for (auto i = begin; i < end; ++i) {
+                        const auto& v = points[i];
+                        const auto im =
+                            table.project<cv::Point2f, cv::Point3d>(cam_idx,
+                                                                    v);
+                        const double z = P[8 * s] * v.x + P[9 * s] * v.y +
+                                         P[10 * s] * v.z + P[11 * s];
+                        vertices[i] = {im.x, im.y,
+                                       z > 0.0 ? static_cast<float>(1.0 / z)
+                                               : 0.0f};
+                    }
+                });
+        }
+    } // namespace
+
+    DepthBuffer::DepthBuffer(const cv::Size& size)
+        : InvDepth_(size, CV_32F, cv::Scalar::all(0)),
+          tiles_x_((size.width + TILE_SIZE - 1) / TILE_SIZE),
+          tiles_y_((size.height + TILE_SIZE - 1) / TILE_SIZE),
+          num_chunks_(0),
+          bins_() {}
+
+    void DepthBuffer::clear() { InvDepth_.setTo(cv::Scalar::all(0)); }
+
+    void DepthBuffer::render(const std::vector<screen_vertex>& vertices,
+                             const std::vector<std::uint32_t>& indices,
+                             const std::size_t num_threads) {
+
+        assert(indices.size() % 3 == 0);
+        const auto num_tris  = indices.size() / 3;
+        const auto num_tiles = static_cast<std::size_t>(tiles_x_ * tiles_y_);
+        if (num_tris == 0 || num_tiles == 0) {
+            return;
+        }
+
+        // bin the triangles of each chunk separately, the bins keep their
+        // capacity for the next camera
+        num_chunks_ = std::min(ResolveThreads(num_threads), num_tris);
+        bins_.resize(std::max(bins_.size(), num_chunks_ * num_tiles));
+        for (auto& bin : bins_) {
+            bin.clear();
+        }
+        const auto width  = static_cast<float>(InvDepth_.cols);
+        const auto height = static_cast<float>(InvDepth_.rows);
+        ParallelFor(0, num_chunks_, num_chunks_, [&](const std::size_t c0,
+                                                     const std::size_t c1) {
+            for (auto c = c0; c < c1; ++c) {
+                const auto t0 = num_tris * c / num_chunks_;
+                const auto t1 = num_tris * (c + 1) / num_chunks_;
+                auto bins     = bins_.begin() + c * num_tiles;
+                for (auto t = t0; t < t1; ++t) {
+                    const auto& a = vertices[indices[3 * t]];
+                    const auto& b = vertices[indices[3 * t + 1]];
+                    const auto& d = vertices[indices[3 * t + 2]];
+                    if (!IsFinite(a) || !IsFinite(b) || !IsFinite(d) ||
+                        a.inv_depth <= 0.0f || b.inv_depth <= 0.0f ||
+                        d.inv_depth <= 0.0f) {
+                        continue;
+                    }
+                    const auto min_x = std::min({a.x, b.x, d.x});
+                    const auto max_x = std::max({a.x, b.x, d.x});
+                    const auto min_y = std::min({a.y, b.y, d.y});
+                    const auto max_y = std::max({a.y, b.y, d.y});
+                    if (max_x < 0.0f || max_y < 0.0f || min_x >= width ||
+                        min_y >= height) {
+                        continue;
+                    }
+                    const auto tx0 =
+                        ClampFloor(min_x, 0.0f, width) / TILE_SIZE;
+                    const auto ty0 =
+                        ClampFloor(min_y, 0.0f, height) / TILE_SIZE;
+                    const auto tx1 = std::min(
+                        ClampFloor(max_x, 0.0f, width) / TILE_SIZE,
+                        tiles_x_ - 1);
+                    const auto ty1 = std::min(
+                        ClampFloor(max_y, 0.0f, height) / TILE_SIZE,
+                        tiles_y_ - 1);
+                    for (auto ty = ty0; ty <= ty1; ++ty) {
+                        for (auto tx = tx0; tx <= tx1; ++tx) {
+                            bins[ty * tiles_x_ + tx].push_back(
+                                static_cast<std::uint32_t>(t));
+                        }
+                    }
+                }
+            }
+        });
+
+        ParallelFor(0, num_tiles, num_threads,
+                    [&](const std::size_t begin, const std::size_t end) {
+                        for (auto tile = begin; tile < end; ++tile) {
+                            rasterize(tile, vertices, indices);
+                        }
+                    });
+    }
+
+    void DepthBuffer::rasterize(const std::size_t tile,
+                                const std::vector<screen_vertex>& vertices,
+                                const std::vector<std::uint32_t>& indices) {
+
+        const auto num_tiles = static_cast<std::size_t>(tiles_x_ * tiles_y_);
+        const int x0 = static_cast<int>(tile % tiles_x_) * TILE_SIZE;
+        const int y0 = static_cast<int>(tile / tiles_x_) * TILE_SIZE;
+        const int x1 = std::min(x0 + TILE_SIZE, InvDepth_.cols);
+        const int y1 = std::min(y0 + TILE_SIZE, InvDepth_.rows);
+
+        for (std::size_t c = 0; c < num_chunks_; ++c) {
+            for (const auto t : bins_[c * num_tiles + tile]) {
+                const auto& a = vertices[indices[3 * t]];
+                const auto& b = vertices[indices[3 * t + 1]];
+                const auto& d = vertices[indices[3 * t + 2]];
+                const auto area = Edge(a, b, d.x, d.y);
+                if (std::abs(area) < 1e-12f) {
+                    continue;
+                }
+
+                // pixel (x, y) is covered if its center lies inside the
+                // triangle, both windings are rendered
+                const auto px0 =
+                    ClampFloor(std::min({a.x, b.x, d.x}) - 0.5f,
+                               static_cast<float>(x0), static_cast<float>(x1));
+                const auto py0 =
+                    ClampFloor(std::min({a.y, b.y, d.y}) - 0.5f,
+                               static_cast<float>(y0), static_cast<float>(y1));
+                const auto px1 = std::min(
+                    x1 - 1, ClampFloor(std::max({a.x, b.x, d.x}) - 0.5f,
+                                       static_cast<float>(x0 - 1),
+                                       static_cast<float>(x1)) + 1);
+                const auto py1 = std::min(
+                    y1 - 1, ClampFloor(std::max({a.y, b.y, d.y}) - 0.5f,
+                                       static_cast<float>(y0 - 1),
+                                       static_cast<float>(y1)) + 1);
+
+                const auto inv_area = 1.0f / area;
+                for (auto y = py0; y <= py1; ++y) {
+                    const auto cy = y + 0.5f;
+                    auto row      = InvDepth_.ptr<float>(y);
+                    for (auto x = px0; x <= px1; ++x) {
+                        const auto cx = x + 0.5f;
+                        const auto w0 = Edge(b, d, cx, cy) * inv_area;
+                        const auto w1 = Edge(d, a, cx, cy) * inv_area;
+                        const auto w2 = 1.0f - w0 - w1;
+                        if (w0 < 0.0f || w1 < 0.0f || w2 < 0.0f) {
+                            continue;
+                        }
+                        const auto inv_depth = w0 * a.inv_depth +
+                                               w1 * b.inv_depth +
+                                               w2 * d.inv_depth;
+                        row[x] = std::max(row[x], inv_depth);
+                    }
+                }
+            }
+        }
+    }
+
+    bool DepthBuffer::isVisible(const screen_vertex& v,
+                                const float tolerance) const {
+
+        if (!IsFinite(v) || v.inv_depth <= 0.0f || v.x < 0.0f || v.y < 0.0f ||
+            v.x >= InvDepth_.cols || v.y >= InvDepth_.rows) {
+            return false;
+        }
+        const auto nearest = InvDepth_.at<float>(static_cast<int>(v.y),
+                                                 static_cast<int>(v.x));
+        return v.inv_depth * (1.0f + tolerance) >= nearest;
+    }
+
+    const cv::Mat& DepthBuffer::getInvDepthMap() const { return InvDepth_; }
+
+    cv::Size DepthBuffer::getSize() const { return InvDepth_.size(); }
+
+    const float MeshVisibility::DEFAULT_TOLERANCE = 0.01f;
+
+    MeshVisibility::MeshVisibility(vtkSmartPointer<vtkPolyData> mesh,
+                                   const Camera* cams,
+                                   const std::size_t num_cams,
+                                   const std::size_t num_threads,
+                                   const float tolerance)
+        : num_cams_(num_cams),
+          num_vertices_(static_cast<std::size_t>(mesh->GetNumberOfPoints())),
+          visible_(num_cams * num_vertices_, 0) {
+
+        const ProjectionTable table(cams, num_cams);
+        const auto indices = Triangulate(mesh);
+        std::vector<cv::Point3d> points(num_vertices_);
+        for (std::size_t i = 0; i < num_vertices_; ++i) {
+            double v[3];
+            mesh->GetPoint(static_cast<vtkIdType>(i), v);
+            points[i] = cv::Point3d(v[0], v[1], v[2]);
+        }
+
+        // a single depth buffer is reused as long as the image size stays
+        std::unique_ptr<DepthBuffer> buffer;
+        std::vector<screen_vertex> vertices;
+        for (std::size_t c = 0; c < num_cams_; ++c) {
+            const auto size = cams[c].getImageSize();
+            if (buffer == nullptr || buffer->getSize() != size) {
+                buffer.reset(new DepthBuffer(size));
+            } else {
+                buffer->clear();
+            }
+            ProjectVertices(points, table, c, num_threads, vertices);
+            buffer->render(vertices, indices, num_threads);
+
+            auto visible = visible_.begin() + c * num_vertices_;
+            ParallelFor(0, num_vertices_, num_threads,
+                        [&](const std::size_t begin, const std::size_t end) {
+                            for (auto i = begin; i < end; ++i) {
+                                visible[i] =
+                                    buffer->isVisible(vertices[i], tolerance);
+                            }
+                        });
+        }
+    }
+
+    MeshVisibility::MeshVisibility(vtkSmartPointer<vtkPolyData> mesh,
+                                   const std::vector<Camera>& cams,
+                                   const std::size_t num_threads,
+                                   const float tolerance)
+        : MeshVisibility(mesh, cams.data(), cams.size(), num_threads,
+                         tolerance) {}
+
+    bool MeshVisibility::isVisible(const std::size_t cam_idx,
+                                   const std::size_t vertex_idx) const {
+        assert(cam_idx < num_cams_ && vertex_idx < num_vertices_);
+        return visible_[cam_idx * num_vertices_ + vertex_idx] != 0;
+    }
+
+    std::size_t MeshVisibility::getNumVisible(
+        const std::size_t cam_idx) const {
+        assert(cam_idx < num_cams_);
+        const auto first = visible_.begin() + cam_idx * num_vertices_;
+        return static_cast<std::size_t>(
+            std::count(first, first + num_vertices_, 1));
+    }
+
+    std::size_t MeshVisibility::getNumCameras() const { return num_cams_; }
+
+    std::size_t MeshVisibility::getNumVertices() const {
+        return num_vertices_;
+    }
+} // namespace rendering
+} // namespace ret
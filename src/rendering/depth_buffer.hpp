@@ -0,0 +1,143 @@
+// Copyright (c) 2015-2016, Kai Wolf
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#ifndef RENDERING_DEPTH_BUFFER_HPP
+#define RENDERING_DEPTH_BUFFER_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <vtkSmartPointer.h>
+#include <opencv2/core/core.hpp>
+
+class vtkPolyData;
+namespace ret { class Camera; }
+
+namespace ret {
+
+namespace rendering {
+
+    /** @brief Vertex projected into an image, the depth is stored
+      * inversely since it is interpolated linearly in image space */
+    struct screen_vertex {
+        float x, y, inv_depth;
+    };
+
+    /** @brief Software z-buffer of a single camera image. The image is
+      * split into square tiles, triangles are binned into the tiles they
+      * overlap and each thread rasterizes its own tiles, hence no pixel is
+      * written concurrently and the result does not depend on the number
+      * of threads */
+    class DepthBuffer {
+      public:
+        static const int TILE_SIZE = 32;
+
+        /** @param size size of the camera image */
+        explicit DepthBuffer(const cv::Size& size);
+
+        DepthBuffer(DepthBuffer const&)            = delete;
+        DepthBuffer operator&=(DepthBuffer const&) = delete;
+
+        /** @brief Resets every pixel to empty */
+        void clear();
+
+        /** @brief Rasterizes a triangle mesh into the depth buffer and
+          * keeps the nearest depth per pixel. Triangles partially behind
+          * the camera or with non-finite coordinates are skipped
+          * @param vertices projected vertices of the mesh
+          * @param indices three vertex indices per triangle
+          * @param num_threads number of threads, 0 uses all hardware
+          * threads and 1 rasterizes serially */
+        void render(const std::vector<screen_vertex>& vertices,
+                    const std::vector<std::uint32_t>& indices,
+                    const std::size_t num_threads = 0);
+
+        /** @brief Tests whether a vertex is the nearest surface at its
+          * pixel
+          * @param v projected vertex
+          * @param tolerance relative depth by which the vertex may lie
+          * behind the rendered surface, absorbing the depth difference
+          * between the vertex and the center of its pixel
+          * @return false, if the vertex is outside of the image, behind
+          * the camera or occluded */
+        bool isVisible(const screen_vertex& v, const float tolerance) const;
+
+        /** @brief Returns the inverse depth per pixel as CV_32F, 0 marks
+          * pixels not covered by any triangle */
+        const cv::Mat& getInvDepthMap() const;
+
+        cv::Size getSize() const;
+
+      private:
+        void rasterize(const std::size_t tile,
+                       const std::vector<screen_vertex>& vertices,
+                       const std::vector<std::uint32_t>& indices);
+
+        cv::Mat InvDepth_;
+        int tiles_x_, tiles_y_;
+        std::size_t num_chunks_;
+        /** triangle indices of chunk c overlapping tile t, stored at
+          * c * num_tiles + t */
+        std::vector<std::vector<std::uint32_t>> bins_;
+    };
+
+    /** @brief Visibility of every mesh vertex in every camera of a set.
+      * The mesh is rendered once into a @ref DepthBuffer per camera,
+      * afterwards each query is a single lookup */
+    class MeshVisibility {
+      public:
+        static const float DEFAULT_TOLERANCE;
+
+        /** @param mesh triangle mesh, polygons with more than three points
+          * are split into triangle fans
+          * @param cams first camera of a contiguous range
+          * @param num_cams number of cameras
+          * @param num_threads number of threads, 0 uses all hardware
+          * threads and 1 renders serially
+          * @param tolerance see @ref DepthBuffer::isVisible */
+        MeshVisibility(vtkSmartPointer<vtkPolyData> mesh, const Camera* cams,
+                       const std::size_t num_cams,
+                       const std::size_t num_threads = 0,
+                       const float tolerance = DEFAULT_TOLERANCE);
+
+        MeshVisibility(vtkSmartPointer<vtkPolyData> mesh,
+                       const std::vector<Camera>& cams,
+                       const std::size_t num_threads = 0,
+                       const float tolerance = DEFAULT_TOLERANCE);
+
+        bool isVisible(const std::size_t cam_idx,
+                       const std::size_t vertex_idx) const;
+
+        /** @brief Returns the number of vertices visible in a camera */
+        std::size_t getNumVisible(const std::size_t cam_idx) const;
+
+        std::size_t getNumCameras() const;
+        std::size_t getNumVertices() const;
+
+      private:
+        std::size_t num_cams_, num_vertices_;
+        /** one flag per vertex, camera after camera */
+        std::vector<unsigned char> visible_;
+    };
+} // namespace rendering
+} // namespace ret
+
+#endif
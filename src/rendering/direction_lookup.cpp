@@ -0,0 +1,221 @@
+// Copyright (c) 2015-2016, Kai Wolf
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "rendering/direction_lookup.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <functional>
+#include <utility>
+
+#include "rendering/projection_table.hpp"
+
+namespace ret {
+
+namespace rendering {
+
+    namespace {
+
+        // covers rounding of the float camera directions
+        const double ANGLE_EPS = 1e-6;
+
+        std::vector<cv::Vec3f> GetDirections(const ProjectionTable& table) {
+            std::vector<cv::Vec3f> directions(table.size());
+            for (std::size_t c = 0; c < table.size(); ++c) {
+                directions[c] = table.getDirection(c);
+            }
+            return directions;
+        }
+
+        // point on face f of the cube at face coordinates u, v in [-1, 1].
+        // Face f = 2 * axis + (1 if the axis points negative)
+        cv::Vec3d FacePoint(const std::size_t face, const double u,
+                            const double v) {
+            const auto axis = face / 2;
+            const auto sign = face % 2 == 0 ? 1.0 : -1.0;
+            cv::Vec3d p;
+            p[axis]           = sign;
+            p[(axis + 1) % 3] = u;
+            p[(axis + 2) % 3] = v;
+            return p / cv::norm(p);
+        }
+
+        double Angle(const cv::Vec3d& a, const cv::Vec3d& b) {
+            return std::acos(std::max(-1.0, std::min(1.0, a.dot(b))));
+        }
+    } // namespace
+
+    DirectionLookup::DirectionLookup(const std::vector<cv::Vec3f>& directions,
+                                     const std::size_t k,
+                                     const double min_dot,
+                                     const std::size_t face_bins)
+        : directions_(directions),
+          k_(std::max<std::size_t>(1, k)),
+          face_bins_(std::max<std::size_t>(1, face_bins)),
+          offsets_(1, 0),
+          cams_() {
+
+        const auto num_cams = directions_.size();
+        const auto step     = 2.0 / static_cast<double>(face_bins_);
+        std::vector<double> upper(num_cams), lower(num_cams);
+        std::vector<std::pair<double, std::uint32_t>> ranked;
+        offsets_.reserve(getNumBins() + 1);
+
+        for (std::size_t face = 0; face < 6; ++face) {
+            for (std::size_t bu = 0; bu < face_bins_; ++bu) {
+                for (std::size_t bv = 0; bv < face_bins_; ++bv) {
+                    const auto u0 = -1.0 + bu * step;
+                    const auto v0 = -1.0 + bv * step;
+                    const auto center =
+                        FacePoint(face, u0 + 0.5 * step, v0 + 0.5 * step);
+
+                    // the normal farthest from the center of a bin is one
+                    // of its corners
+                    auto radius = 0.0;
+                    for (auto corner : {std::make_pair(u0, v0),
+                                        std::make_pair(u0 + step, v0),
+                                        std::make_pair(u0, v0 + step),
+                                        std::make_pair(u0 + step, v0 + step)}) {
+                        radius = std::max(
+                            radius, Angle(center, FacePoint(face, corner.first,
+                                                            corner.second)));
+                    }
+                    radius += ANGLE_EPS;
+
+                    // bounds of the dot product of each camera with any
+                    // normal within the bin
+                    for (std::size_t c = 0; c < num_cams; ++c) {
+                        const auto angle =
+                            Angle(center, cv::Vec3d(directions_[c]));
+                        upper[c] = std::cos(std::max(0.0, angle - radius));
+                        lower[c] = std::cos(std::min(CV_PI, angle + radius));
+                    }
+
+                    // a camera is a candidate, unless k cameras are better
+                    // for every normal within the bin
+                    auto kth_lower = -2.0;
+                    if (k_ <= num_cams) {
+                        std::vector<double> sorted(lower);
+                        std::nth_element(sorted.begin(),
+                                         sorted.begin() + (k_ - 1),
+                                         sorted.end(),
+                                         std::greater<double>());
+                        kth_lower = sorted[k_ - 1];
+                    }
+
+                    ranked.clear();
+                    for (std::size_t c = 0; c < num_cams; ++c) {
+                        if (upper[c] >= kth_lower && upper[c] >= min_dot) {
+                            ranked.emplace_back(
+                                -center.dot(cv::Vec3d(directions_[c])),
+                                static_cast<std::uint32_t>(c));
+                        }
+                    }
+                    std::sort(ranked.begin(), ranked.end());
+                    for (const auto& cam : ranked) {
+                        cams_.push_back(cam.second);
+                    }
+                    offsets_.push_back(
+                        static_cast<std::uint32_t>(cams_.size()));
+                }
+            }
+        }
+    }
+
+    DirectionLookup::DirectionLookup(const ProjectionTable& table,
+                                     const std::size_t k,
+                                     const double min_dot,
+                                     const std::size_t face_bins)
+        : DirectionLookup(GetDirections(table), k, min_dot, face_bins) {}
+
+    std::size_t DirectionLookup::getBin(const cv::Vec3d& normal) const {
+
+        // the major axis selects the face, the other two components
+        // projected onto the face select the bin
+        std::size_t axis = 0;
+        for (std::size_t i = 1; i < 3; ++i) {
+            if (std::abs(normal[i]) > std::abs(normal[axis])) {
+                axis = i;
+            }
+        }
+        const auto major = std::abs(normal[axis]);
+        if (major == 0.0) {
+            return 0;
+        }
+        const auto face = 2 * axis + (normal[axis] < 0.0 ? 1 : 0);
+        const auto to_bin = [this, major](const double x) {
+            const auto bin = static_cast<std::ptrdiff_t>(
+                std::floor((x / major + 1.0) * 0.5 * face_bins_));
+            return static_cast<std::size_t>(std::max<std::ptrdiff_t>(
+                0, std::min<std::ptrdiff_t>(bin, face_bins_ - 1)));
+        };
+        const auto bu = to_bin(normal[(axis + 1) % 3]);
+        const auto bv = to_bin(normal[(axis + 2) % 3]);
+        return (face * face_bins_ + bu) * face_bins_ + bv;
+    }
+
+    DirectionLookup::candidates DirectionLookup::getCandidates(
+        const cv::Vec3d& normal) const {
+
+        const auto bin = getBin(normal);
+        return {cams_.data() + offsets_[bin], cams_.data() + offsets_[bin + 1]};
+    }
+
+    std::size_t DirectionLookup::findBest(const cv::Vec3d& normal,
+                                          std::size_t* cams,
+                                          const std::size_t k) const {
+
+        assert(k <= k_);
+        // insertion into the k best found so far, which are kept sorted
+        const auto better = [this, &normal](const std::size_t a,
+                                            const double dot_a,
+                                            const std::size_t b) {
+            const auto dot_b = normal.dot(cv::Vec3d(directions_[b]));
+            return dot_a > dot_b || (dot_a == dot_b && a < b);
+        };
+        std::size_t num_best = 0;
+        for (const auto c : getCandidates(normal)) {
+            const auto dot = normal.dot(cv::Vec3d(directions_[c]));
+            auto pos       = num_best;
+            while (pos > 0 && better(c, dot, cams[pos - 1])) {
+                --pos;
+            }
+            if (pos >= k) {
+                continue;
+            }
+            for (auto i = std::min(num_best, k - 1); i > pos; --i) {
+                cams[i] = cams[i - 1];
+            }
+            cams[pos] = c;
+            num_best  = std::min(num_best + 1, k);
+        }
+        return num_best;
+    }
+
+    std::size_t DirectionLookup::getNumBins() const {
+        return 6 * face_bins_ * face_bins_;
+    }
+
+    std::size_t DirectionLookup::getNumCameras() const {
+        return directions_.size();
+    }
+} // namespace rendering
+} // namespace ret
@@ -0,0 +1,108 @@
+// Copyright (c) 2015-2016, Kai Wolf
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#ifndef RENDERING_DIRECTION_LOOKUP_HPP
+#define RENDERING_DIRECTION_LOOKUP_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <opencv2/core/core.hpp>
+
+namespace ret {
+
+namespace rendering {
+
+    class ProjectionTable;
+
+    /** @brief Cube map over the unit sphere, which maps a surface normal
+      * to the cameras that may view it best. Each face of the cube is
+      * split into bins, every bin lists all cameras that are among the k
+      * best ones for at least one normal within the bin, sorted by their
+      * dot product with the bin center. Hence selecting the best cameras
+      * for a normal scans a few candidates instead of the whole camera
+      * set and still yields the exact result */
+    class DirectionLookup {
+      public:
+        static const std::size_t DEFAULT_FACE_BINS = 16;
+
+        /** @brief Range of camera indices */
+        struct candidates {
+            const std::uint32_t* first;
+            const std::uint32_t* last;
+
+            const std::uint32_t* begin() const { return first; }
+            const std::uint32_t* end() const { return last; }
+            std::size_t size() const {
+                return static_cast<std::size_t>(last - first);
+            }
+        };
+
+        /** @param directions normalized viewing direction per camera
+          * @param k number of best cameras, which must be found among the
+          * candidates of a bin
+          * @param min_dot cameras whose dot product with every normal of
+          * a bin is below min_dot are no candidates of the bin. Only
+          * valid for normals of unit length
+          * @param face_bins number of bins along each edge of a cube
+          * face */
+        DirectionLookup(const std::vector<cv::Vec3f>& directions,
+                        const std::size_t k, const double min_dot = -1.0,
+                        const std::size_t face_bins = DEFAULT_FACE_BINS);
+
+        /** @brief Creates the lookup for the directions of a camera set,
+          * see @ref ProjectionTable::getDirection */
+        DirectionLookup(const ProjectionTable& table, const std::size_t k,
+                        const double min_dot        = -1.0,
+                        const std::size_t face_bins = DEFAULT_FACE_BINS);
+
+        /** @brief Returns the candidate cameras of the bin containing the
+          * normal, sorted by decreasing dot product with the bin center */
+        candidates getCandidates(const cv::Vec3d& normal) const;
+
+        /** @brief Finds the cameras with the largest dot product between
+          * their viewing direction and the normal. Equal dot products are
+          * ordered by camera index
+          * @param normal surface normal
+          * @param cams receives at most k camera indices, best first
+          * @param k number of cameras to find, at most the k given on
+          * construction
+          * @return number of cameras written to cams */
+        std::size_t findBest(const cv::Vec3d& normal, std::size_t* cams,
+                             const std::size_t k) const;
+
+        /** @brief Returns the index of the bin containing the normal */
+        std::size_t getBin(const cv::Vec3d& normal) const;
+
+        std::size_t getNumBins() const;
+        std::size_t getNumCameras() const;
+
+      private:
+        std::vector<cv::Vec3f> directions_;
+        std::size_t k_, face_bins_;
+        /** candidates of bin b are stored in [offsets_[b], offsets_[b+1]) */
+        std::vector<std::uint32_t> offsets_;
+        std::vector<std::uint32_t> cams_;
+    };
+} // namespace rendering
+} // namespace ret
+
+#endif
@@ -38,7 +38,8 @@
 #include "calibration/light_direction_model.hpp"
 #include "common/camera.hpp"
 #include "common/dataset.hpp"
-#include "rendering/cv_utils.hpp"
+#include "rendering/depth_buffer.hpp"
+#include "rendering/projection_table.hpp"
 #include "rendering/vtk_utils.hpp"
 
 namespace ret {
@@ -56,21 +57,25 @@ namespace rendering {
     }
 
     cv::Vec3f LightDirEstimation::execute(
-        Camera& cam, vtkSmartPointer<vtkPolyData> visual_hull) {
+        const Camera& cam, vtkSmartPointer<vtkPolyData> visual_hull) {
 
         assert(cam.getImage().channels() == 3);
         contour_points_.clear();
 
         cv::Mat Grayscale;
         cv::cvtColor(cam.getImage(), Grayscale, CV_BGR2GRAY);
+        const ProjectionTable table(&cam, 1);
+        const auto cam_normal = table.getDirection(0);
+        const MeshVisibility visibility(visual_hull, &cam, 1);
         // get points on visual hull and corresponding surface normals
         for (vtkIdType idx = 0; idx < visual_hull->GetNumberOfPoints(); ++idx) {
             auto pt_vishull = GetVertex(visual_hull, idx);
             auto normal = GetNormal(visual_hull, idx);
-            auto cam_normal = cam.getDirection();
             auto angle      = normal.dot(cam_normal);
-            if (angle >= vis_angle_thresh_) {
-                auto coord = project<cv::Point2f, cv::Point3d>(cam, pt_vishull);
+            if (angle >= vis_angle_thresh_ &&
+                visibility.isVisible(0, static_cast<std::size_t>(idx))) {
+                auto coord =
+                    table.project<cv::Point2f, cv::Point3d>(0, pt_vishull);
                 contour_points_.emplace_back(
                     calib::contour_point(normal, Grayscale.at<uchar>(coord)));
             }
@@ -84,7 +89,7 @@ namespace rendering {
 
         assert(ds.size() > 0);
         std::vector<cv::Vec3f> light_directions;
-        for (auto& cam : ds.getCameras()) {
+        for (const auto& cam : ds) {
             light_directions.emplace_back(execute(cam, visual_hull));
         }
     }
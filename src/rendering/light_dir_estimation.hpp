@@ -48,7 +48,7 @@ namespace rendering {
         explicit LightDirEstimation(const double vis_angle_thresh    = 0.5,
                                     const std::size_t sample_size    = 1000,
                                     const std::size_t num_iterations = 2000);
-        cv::Vec3f execute(Camera& cam,
+        cv::Vec3f execute(const Camera& cam,
                           vtkSmartPointer<vtkPolyData> visual_hull);
         void execute(DataSet& ds, vtkSmartPointer<vtkPolyData> visual_hull);
         cv::Mat displayLightDirections(const Camera& cam,
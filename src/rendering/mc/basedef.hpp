@@ -20,9 +20,7 @@
 #define COMPUTE_INDEX(dim_x, dim_xz, x, z, y) \
     ((x) + ((z) * (dim_x) + ((y) * (dim_xz))))
 
-#define MC_VALUE(raw) raw
-
-#define MC_WEIGHT(raw) raw.vals.weight
+#define MC_VALUE(raw) ::ret::rendering::VoxelToFloat(raw)
 
 #define MC_ISOLEVEL_CHECK(raw, isolevel) ((MC_VALUE(raw)) < (isolevel))
 
@@ -30,19 +28,18 @@
 #define MAX(a, b) (((a) > (b)) ? (a) : (b))
 #endif
 
+#include "rendering/voxel_type.hpp"
+
 namespace ret {
 
 namespace rendering {
 
     namespace mc {
 
-        /// The typename grid_cell defines the base type of the grid cells.
-        /// To access the value and the weight of a grid cell, use the
-        /// marcos MC_VALUE and MC_WEIGHT. To change the way of accessing
-        /// value and weight, you only need to modify these marcos.
-        /// Note: The current implemenation uses the data structure
-        /// grid_entry_t and the function convQ15ToFloat from
-        /// "VoxelGridAccessTemp.h".
+        /// The typename grid_cell defines the default base type of the grid
+        /// cells. Grids of half precision and Q15 cells are supported as
+        /// well, see @ref voxel_type. To access the value of a grid cell,
+        /// use the macro MC_VALUE, which converts any cell to float.
         typedef float grid_cell;
 
         typedef int int_type;
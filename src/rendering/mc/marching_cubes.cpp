@@ -12,15 +12,18 @@
 
 #include "rendering/mc/marching_cubes.hpp"
 
+#include <algorithm>
 #include <cassert>
 #include <cmath>
 #include <cstdint>
 #include <cstring>
-#include <fstream>
-#include <iostream>
+#include <initializer_list>
+#include <utility>
 
+#include "common/parallel.hpp"
 #include "common/types/triangle.hpp"
 #include "common/types/vec3f.hpp"
+#include "io/mesh_writer.hpp"
 #include "rendering/mc/basedef.hpp"
 #include "rendering/mc/lookup.hpp"
 
@@ -56,7 +59,7 @@ namespace rendering {
                 base_type c3, c4, c5;
                 base_type c6, c7, c8;
             } idx;
-            grid_cell data[9];
+            base_type data[9];
         };
 
         /// This struct represents 4 cubes in a grid of float values. The
@@ -96,9 +99,7 @@ namespace rendering {
             base_type data[18];
         };
 
-        typedef cube4<grid_cell> cube4c;
         typedef cube4<ret::vec3f> cube4vec3f;
-        typedef cube4<int16_t> cube4s;
 
         /// Just a single cube. Here the order of the incidices are given as
         /// common.
@@ -187,7 +188,11 @@ namespace rendering {
               grid_dim_x_(0),
               grid_dim_y_(0),
               grid_dim_z_(0),
-              triangle_vector_() {}
+              num_threads_(1),
+              triangle_vector_(),
+              vertices_(),
+              normals_(),
+              indices_() {}
 
         MarchingCubes::MarchingCubes(
             const float offset_x, const float offset_y, const float offset_z,
@@ -205,7 +210,11 @@ namespace rendering {
               grid_dim_x_(grid_dim_x),
               grid_dim_y_(grid_dim_y),
               grid_dim_z_(grid_dim_z),
-              triangle_vector_() {}
+              num_threads_(1),
+              triangle_vector_(),
+              vertices_(),
+              normals_(),
+              indices_() {}
 
         MarchingCubes::~MarchingCubes() { triangle_vector_.clear(); }
 
@@ -232,101 +241,210 @@ namespace rendering {
                                       const triangle_vector_type& triangles,
                                       const std::vector<vec3f>& normals) const {
 
-            std::ofstream output(name, std::ofstream::binary);
-
-            int_type face     = 1;
-            std::size_t n_idx = 0;
-
-            for (const auto& it : triangles) {
-
-                // using "\n" instead of std::endl to avoid permanent flushing.
-                output.write("v ", 2);
-                output << it.comp.v1.x;
-                output.write(" ", 1);
-                output << it.comp.v1.y;
-                output.write(" ", 1);
-                output << it.comp.v1.z;
-
-                output.write("\nv ", 3);
-                output << it.comp.v2.x;
-                output.write(" ", 1);
-                output << it.comp.v2.y;
-                output.write(" ", 1);
-                output << it.comp.v2.z;
-
-                output.write("\nv ", 3);
-                output << it.comp.v3.x;
-                output.write(" ", 1);
-                output << it.comp.v3.y;
-                output.write(" ", 1);
-                output << it.comp.v3.z;
-
-                for (int i = 0; i < 3; ++i) {
-                    output.write("\nvn ", 4);
-                    output << normals[n_idx].x;
-                    output.write(" ", 1);
-                    output << normals[n_idx].y;
-                    output.write(" ", 1);
-                    output << normals[n_idx].z;
-                }
-
-#if MC_REVERSE_TRIANGLES
-
-                output.write("\nf ", 3);
-                output << face;
-                output.write("//", 2);
-                output << face;
-                output.write(" ", 1);
-
-                output << (face + 1);
-                output.write("//", 2);
-                output << (face + 1);
-                output.write(" ", 1);
-
-                output << (face + 2);
-                output.write("//", 2);
-                output << (face + 2);
-                output.write(" ", 1);
-#else
-
-                output.write("\nf ", 3);
-                output << face + 2;
-                output.write("//", 2);
-                output << face + 2;
-                output.write(" ", 1);
-
-                output << (face + 1);
-                output.write("//", 2);
-                output << (face + 1);
-                output.write(" ", 1);
-
-                output << (face);
-                output.write("//", 2);
-                output << (face);
-                output.write(" ", 1);
-#endif
+            // the winding is flipped while writing, not in a copy
+            io::WriteOBJ(name, triangles, normals, !MC_REVERSE_TRIANGLES);
+        }
 
-                output.write("\n", 1);
+        void MarchingCubes::saveASOBJ(const char* name,
+                                      const vertex_vector_type& vertices,
+                                      const vertex_vector_type& normals,
+                                      const index_vector_type& indices) const {
 
-                face += 3;
-                n_idx += 1;
-            }
-            output.close();
+            assert(vertices.size() == normals.size());
+            io::WriteOBJ(name, vertices, normals, indices,
+                         !MC_REVERSE_TRIANGLES);
         }
 
 /// @brief Macro for index computation
 #define MC_COMPUTE_INDEX(dim_x, dim_xz, x, z, y) \
     ((x) + ((z) * (dim_x) + ((y) * (dim_xz))))
 
+        /// Output of triangulate, which stores every triangle with its own
+        /// copy of the three vertices.
+        class triangle_output {
+
+          public:
+            typedef ret::vec3f vertex_type;
+
+            explicit triangle_output(
+                MarchingCubes::triangle_vector_type& triangles)
+                : triangles_(triangles) {}
+
+            void beginSlices(const int_type) {}
+
+            void setCube(const int_type, const int_type, const int_type) {}
+
+            template <typename cell_type>
+            vertex_type vertex(const int_type, const ret::vec3f& p1,
+                               const ret::vec3f& p2, const cell_type& valp1,
+                               const cell_type& valp2, const float isolevel) {
+
+                vertex_type result;
+                interpolate(result, p1, p2, valp1, valp2, isolevel);
+                return result;
+            }
+
+            void addTriangle(const vertex_type& v1, const vertex_type& v2,
+                             const vertex_type& v3) {
+
+                ret::triangle tri;
+                tri.comp.v1 = v1;
+                tri.comp.v2 = v2;
+                tri.comp.v3 = v3;
+                triangles_.push_back(tri);
+            }
+
+          private:
+            MarchingCubes::triangle_vector_type& triangles_;
+        };
+
+        /// Grid offset (x, z, y) of the first corner of each cube edge and
+        /// the axis the edge runs along (0: x, 1: y, 2: z).
+        const int_type edge_offsets[12][4] = {
+            {0, 0, 0, 0}, {1, 0, 0, 1}, {0, 0, 1, 0}, {0, 0, 0, 1},
+            {0, 1, 0, 0}, {1, 1, 0, 1}, {0, 1, 1, 0}, {0, 1, 0, 1},
+            {0, 0, 0, 2}, {1, 0, 0, 2}, {1, 0, 1, 2}, {0, 0, 1, 2}};
+
+        /// Output of triangulate, which creates a single vertex per
+        /// intersected grid edge and stores triangles as vertex indices.
+        /// Since the cube4 sweep covers two y-slices at once, only the edges
+        /// starting on the three current y-slices are cached. The cache is
+        /// rolled over whenever the sweep advances. The cache of the first
+        /// y-slice is kept, such that the vertices shared with a preceding
+        /// slab can be identified afterwards.
+        class indexed_output {
+
+          public:
+            typedef std::uint32_t vertex_type;
+            typedef std::vector<vertex_type> slice_type;
+
+            static const vertex_type NO_VERTEX = 0xffffffff;
+
+            indexed_output(const int_type dim_x, const int_type dim_z)
+                : dim_x_(dim_x),
+                  slice_size_(3 * static_cast<std::size_t>(dim_x * dim_z)),
+                  first_y_(-1),
+                  base_y_(-1),
+                  cube_x_(0),
+                  cube_z_(0),
+                  cube_y_(0) {}
+
+            void beginSlices(const int_type y) {
+
+                if (base_y_ < 0) {
+                    for (auto slice = 0; slice < 3; ++slice) {
+                        clearSlice(slice);
+                    }
+                    first_y_ = y;
+                    base_y_  = y;
+                    return;
+                }
+
+                // the last slice of the previous cube4 row is the first
+                // slice of the next one
+                assert(y == base_y_ + 2);
+                if (base_y_ == first_y_) {
+                    first_slice_.swap(slices_[0]);
+                    cached_[0].clear();
+                }
+                slices_[0].swap(slices_[2]);
+                cached_[0].swap(cached_[2]);
+                clearSlice(1);
+                clearSlice(2);
+                base_y_ = y;
+            }
+
+            void setCube(const int_type x, const int_type z, const int_type y) {
+
+                cube_x_ = x;
+                cube_z_ = z;
+                cube_y_ = y;
+            }
+
+            template <typename cell_type>
+            vertex_type vertex(const int_type edge, const ret::vec3f& p1,
+                               const ret::vec3f& p2, const cell_type& valp1,
+                               const cell_type& valp2, const float isolevel) {
+
+                const int_type* offset = edge_offsets[edge];
+                const auto slice       = cube_y_ + offset[2] - base_y_;
+                const auto x           = cube_x_ + offset[0];
+                const auto z           = cube_z_ + offset[1];
+                const auto slot =
+                    static_cast<std::size_t>(3 * (x + z * dim_x_) + offset[3]);
+                auto& cached = slices_[slice][slot];
+                if (cached == NO_VERTEX) {
+                    cached = static_cast<vertex_type>(vertices_.size());
+                    cached_[slice].push_back(slot);
+                    vertices_.emplace_back();
+                    interpolate(vertices_.back(), p1, p2, valp1, valp2,
+                                isolevel);
+                }
+                return cached;
+            }
+
+            void addTriangle(const vertex_type v1, const vertex_type v2,
+                             const vertex_type v3) {
+
+                indices_.push_back(v1);
+                indices_.push_back(v2);
+                indices_.push_back(v3);
+            }
+
+            const MarchingCubes::vertex_vector_type& getVertices() const {
+                return vertices_;
+            }
+
+            const MarchingCubes::index_vector_type& getIndices() const {
+                return indices_;
+            }
+
+            /// Returns the cached edges of the first y-slice.
+            const slice_type& getFirstSlice() const {
+                return base_y_ == first_y_ ? slices_[0] : first_slice_;
+            }
+
+            /// Returns the cached edges of the last y-slice of the last
+            /// cube4 row.
+            const slice_type& getLastSlice() const { return slices_[2]; }
+
+          private:
+            /// Resets the given slice. Only the cached edges are reset,
+            /// which is much cheaper than refilling the whole slice.
+            void clearSlice(const int slice) {
+
+                if (slices_[slice].empty()) {
+                    slices_[slice].assign(slice_size_, NO_VERTEX);
+                }
+                for (const auto slot : cached_[slice]) {
+                    slices_[slice][slot] = NO_VERTEX;
+                }
+                cached_[slice].clear();
+            }
+
+            int_type dim_x_;
+            std::size_t slice_size_;
+            int_type first_y_, base_y_;
+            int_type cube_x_, cube_z_, cube_y_;
+            slice_type slices_[3];
+            std::vector<std::size_t> cached_[3];
+            slice_type first_slice_;
+            MarchingCubes::vertex_vector_type vertices_;
+            MarchingCubes::index_vector_type indices_;
+        };
+
+        const indexed_output::vertex_type indexed_output::NO_VERTEX;
+
         /// Once instantiated with a cube-number (0,..,3) this function-template
         /// generates a triangulation function specialized for the corresponding
-        /// cube.
-        template <unsigned int cube>
-        void triangulate(const cube4c& values, const cubevec3f& points,
-                         MarchingCubes::triangle_vector_type& triangles,
+        /// cube. The output decides how the vertex on an intersected edge is
+        /// represented (see triangle_output and indexed_output).
+        template <unsigned int cube, typename cell_type, typename output_type>
+        void triangulate(const cube4<cell_type>& values,
+                         const cubevec3f& points, output_type& output,
                          const float isolevel) {
 
-            ret::vec3f vertlist[12];
+            typename output_type::vertex_type vertlist[12];
 
             // Determine the index in the edge table, which tells us which
             // vertices are inside of the surface.
@@ -359,67 +477,77 @@ namespace rendering {
 
             // count bits.
             if (edge & 1) {
-                interpolate(vertlist[0], points.data[0], points.data[1],
-                            values.data[cubeidx<cube>::i0],
-                            values.data[cubeidx<cube>::i1], isolevel);
+                vertlist[0] = output.vertex(0, points.data[0], points.data[1],
+                                            values.data[cubeidx<cube>::i0],
+                                            values.data[cubeidx<cube>::i1],
+                                            isolevel);
             }
             if (edge & 2) {
-                interpolate(vertlist[1], points.data[1], points.data[2],
-                            values.data[cubeidx<cube>::i1],
-                            values.data[cubeidx<cube>::i2], isolevel);
+                vertlist[1] = output.vertex(1, points.data[1], points.data[2],
+                                            values.data[cubeidx<cube>::i1],
+                                            values.data[cubeidx<cube>::i2],
+                                            isolevel);
             }
             if (edge & 4) {
-                interpolate(vertlist[2], points.data[2], points.data[3],
-                            values.data[cubeidx<cube>::i2],
-                            values.data[cubeidx<cube>::i3], isolevel);
+                vertlist[2] = output.vertex(2, points.data[2], points.data[3],
+                                            values.data[cubeidx<cube>::i2],
+                                            values.data[cubeidx<cube>::i3],
+                                            isolevel);
             }
             if (edge & 8) {
-                interpolate(vertlist[3], points.data[3], points.data[0],
-                            values.data[cubeidx<cube>::i3],
-                            values.data[cubeidx<cube>::i0], isolevel);
+                vertlist[3] = output.vertex(3, points.data[3], points.data[0],
+                                            values.data[cubeidx<cube>::i3],
+                                            values.data[cubeidx<cube>::i0],
+                                            isolevel);
             }
             if (edge & 16) {
-                interpolate(vertlist[4], points.data[4], points.data[5],
-                            values.data[cubeidx<cube>::i4],
-                            values.data[cubeidx<cube>::i5], isolevel);
+                vertlist[4] = output.vertex(4, points.data[4], points.data[5],
+                                            values.data[cubeidx<cube>::i4],
+                                            values.data[cubeidx<cube>::i5],
+                                            isolevel);
             }
             if (edge & 32) {
-                interpolate(vertlist[5], points.data[5], points.data[6],
-                            values.data[cubeidx<cube>::i5],
-                            values.data[cubeidx<cube>::i6], isolevel);
+                vertlist[5] = output.vertex(5, points.data[5], points.data[6],
+                                            values.data[cubeidx<cube>::i5],
+                                            values.data[cubeidx<cube>::i6],
+                                            isolevel);
             }
             if (edge & 64) {
-                interpolate(vertlist[6], points.data[6], points.data[7],
-                            values.data[cubeidx<cube>::i6],
-                            values.data[cubeidx<cube>::i7], isolevel);
+                vertlist[6] = output.vertex(6, points.data[6], points.data[7],
+                                            values.data[cubeidx<cube>::i6],
+                                            values.data[cubeidx<cube>::i7],
+                                            isolevel);
             }
             if (edge & 128) {
-                interpolate(vertlist[7], points.data[7], points.data[4],
-                            values.data[cubeidx<cube>::i7],
-                            values.data[cubeidx<cube>::i4], isolevel);
+                vertlist[7] = output.vertex(7, points.data[7], points.data[4],
+                                            values.data[cubeidx<cube>::i7],
+                                            values.data[cubeidx<cube>::i4],
+                                            isolevel);
             }
             if (edge & 256) {
-                interpolate(vertlist[8], points.data[0], points.data[4],
-                            values.data[cubeidx<cube>::i0],
-                            values.data[cubeidx<cube>::i4], isolevel);
+                vertlist[8] = output.vertex(8, points.data[0], points.data[4],
+                                            values.data[cubeidx<cube>::i0],
+                                            values.data[cubeidx<cube>::i4],
+                                            isolevel);
             }
             if (edge & 512) {
-                interpolate(vertlist[9], points.data[1], points.data[5],
-                            values.data[cubeidx<cube>::i1],
-                            values.data[cubeidx<cube>::i5], isolevel);
+                vertlist[9] = output.vertex(9, points.data[1], points.data[5],
+                                            values.data[cubeidx<cube>::i1],
+                                            values.data[cubeidx<cube>::i5],
+                                            isolevel);
             }
             if (edge & 1024) {
-                interpolate(vertlist[10], points.data[2], points.data[6],
-                            values.data[cubeidx<cube>::i2],
-                            values.data[cubeidx<cube>::i6], isolevel);
+                vertlist[10] = output.vertex(10, points.data[2], points.data[6],
+                                             values.data[cubeidx<cube>::i2],
+                                             values.data[cubeidx<cube>::i6],
+                                             isolevel);
             }
             if (edge & 2048) {
-                interpolate(vertlist[11], points.data[3], points.data[7],
-                            values.data[cubeidx<cube>::i3],
-                            values.data[cubeidx<cube>::i7], isolevel);
+                vertlist[11] = output.vertex(11, points.data[3], points.data[7],
+                                             values.data[cubeidx<cube>::i3],
+                                             values.data[cubeidx<cube>::i7],
+                                             isolevel);
             }
-            ret::triangle tri;
-
             // grab components.
             const lookup::lut_type sheets =
                 lookup::alt_triangle_table[cubecase][0];
@@ -430,7 +558,7 @@ namespace rendering {
                 lookup::lut_type vertices_num =
                     lookup::alt_triangle_table[cubecase][s];
 
-                tri.comp.v1 = vertlist[idxptr[0]];
+                const auto& v1 = vertlist[idxptr[0]];
 
                 // this small switch block is faster than lookups + for-loops!
                 // DO NOT CHANGE CASE-ORDER OR ADD BREAKs: the order and that
@@ -439,60 +567,131 @@ namespace rendering {
                 // runtime speed of the algorithm.
                 switch (vertices_num) {
                     case (7):
-                        tri.comp.v3 = vertlist[idxptr[5]];
-                        tri.comp.v2 = vertlist[idxptr[6]];
-                        triangles.push_back(tri);
+                        output.addTriangle(v1, vertlist[idxptr[6]],
+                                           vertlist[idxptr[5]]);
                     case (6):
-                        tri.comp.v3 = vertlist[idxptr[4]];
-                        tri.comp.v2 = vertlist[idxptr[5]];
-                        triangles.push_back(tri);
+                        output.addTriangle(v1, vertlist[idxptr[5]],
+                                           vertlist[idxptr[4]]);
                     case (5):
-                        tri.comp.v3 = vertlist[idxptr[3]];
-                        tri.comp.v2 = vertlist[idxptr[4]];
-                        triangles.push_back(tri);
+                        output.addTriangle(v1, vertlist[idxptr[4]],
+                                           vertlist[idxptr[3]]);
                     case (4):
-                        tri.comp.v3 = vertlist[idxptr[2]];
-                        tri.comp.v2 = vertlist[idxptr[3]];
-                        triangles.push_back(tri);
+                        output.addTriangle(v1, vertlist[idxptr[3]],
+                                           vertlist[idxptr[2]]);
                     default:
                     case (3):
-                        tri.comp.v3 = vertlist[idxptr[1]];
-                        tri.comp.v2 = vertlist[idxptr[2]];
-                        triangles.push_back(tri);
+                        output.addTriangle(v1, vertlist[idxptr[2]],
+                                           vertlist[idxptr[1]]);
                 };
 
                 idxptr += vertices_num;
             }
         }
 
-        void perform_slices(const float* fgrid, const int_type dim_x,
+        /// Triangulates the single cube with its first corner at (x, z, y).
+        template <typename cell_type, typename output_type>
+        void triangulate_cube(const cell_type* grid, const int_type dim_x,
+                              const int_type dim_xz, const int_type x,
+                              const int_type z, const int_type y,
+                              const float offset_x, const float offset_z,
+                              const float offset_y, const float voxel_width,
+                              const float voxel_depth,
+                              const float voxel_height, const float isolevel,
+                              output_type& output) {
+
+            cube4<cell_type> values;
+            cubevec3f points;
+
+            const int_type xx = x + 1;
+            const int_type zz = z + 1;
+            const int_type yy = y + 1;
+
+            values.data[cubeidx<0>::i0] =
+                grid[MC_COMPUTE_INDEX(dim_x, dim_xz, x, z, y)];
+            values.data[cubeidx<0>::i1] =
+                grid[MC_COMPUTE_INDEX(dim_x, dim_xz, xx, z, y)];
+            values.data[cubeidx<0>::i2] =
+                grid[MC_COMPUTE_INDEX(dim_x, dim_xz, xx, z, yy)];
+            values.data[cubeidx<0>::i3] =
+                grid[MC_COMPUTE_INDEX(dim_x, dim_xz, x, z, yy)];
+            values.data[cubeidx<0>::i4] =
+                grid[MC_COMPUTE_INDEX(dim_x, dim_xz, x, zz, y)];
+            values.data[cubeidx<0>::i5] =
+                grid[MC_COMPUTE_INDEX(dim_x, dim_xz, xx, zz, y)];
+            values.data[cubeidx<0>::i6] =
+                grid[MC_COMPUTE_INDEX(dim_x, dim_xz, xx, zz, yy)];
+            values.data[cubeidx<0>::i7] =
+                grid[MC_COMPUTE_INDEX(dim_x, dim_xz, x, zz, yy)];
+
+            const float off_x1 = offset_x + static_cast<float>(x) * voxel_width;
+            const float off_x2 = off_x1 + voxel_width;
+            const float off_z1 = offset_z + static_cast<float>(z) * voxel_depth;
+            const float off_z2 = off_z1 + voxel_depth;
+            const float off_y1 =
+                offset_y + static_cast<float>(y) * voxel_height;
+            const float off_y2 = off_y1 + voxel_height;
+
+            points.idx.c0.x = off_x1;
+            points.idx.c1.x = off_x2;
+            points.idx.c2.x = off_x2;
+            points.idx.c3.x = off_x1;
+            points.idx.c4.x = off_x1;
+            points.idx.c5.x = off_x2;
+            points.idx.c6.x = off_x2;
+            points.idx.c7.x = off_x1;
+
+            points.idx.c0.z = off_z1;
+            points.idx.c0.y = off_y1;
+            points.idx.c1.z = off_z1;
+            points.idx.c1.y = off_y1;
+            points.idx.c2.z = off_z1;
+            points.idx.c2.y = off_y2;
+            points.idx.c3.z = off_z1;
+            points.idx.c3.y = off_y2;
+
+            points.idx.c4.z = off_z2;
+            points.idx.c4.y = off_y1;
+            points.idx.c5.z = off_z2;
+            points.idx.c5.y = off_y1;
+            points.idx.c6.z = off_z2;
+            points.idx.c6.y = off_y2;
+            points.idx.c7.z = off_z2;
+            points.idx.c7.y = off_y2;
+
+            // triangulate.
+            output.setCube(x, z, y);
+            triangulate<0>(values, points, output, isolevel);
+        }
+
+        /// Triangulates the pairs of y-slices starting at the even y
+        /// positions within [y_begin, y_end). The remaining z-slice of an
+        /// even sized grid is triangulated along with each pair, the
+        /// remaining y-slice after the last pair of the grid.
+        template <typename cell_type, typename output_type>
+        void perform_slices(const cell_type* grid, const int_type dim_x,
                             const int_type dim_z, const int_type dim_y,
                             const float offset_x, const float offset_z,
                             const float offset_y, const float voxel_width,
                             const float voxel_depth, const float voxel_height,
-                            const float isolevel,
-                            MarchingCubes::triangle_vector_type& triangles) {
-
-            const grid_cell* grid = static_cast<const grid_cell*>(fgrid);
+                            const float isolevel, const int_type y_begin,
+                            const int_type y_end, output_type& output) {
 
             int_type pre1, pre2;
 
             const int_type dim_xz = dim_x * dim_z;
 
-            cube4c values;
+            cube4<cell_type> values;
             cubevec3f points;
 
             const int_type lbd_x = 0;
             const int_type ubd_x = dim_x - 1;
             const int_type lbd_z = 0;
             const int_type ubd_z = dim_z - 2;
-            const int_type lbd_y = 0;
-            const int_type ubd_y = dim_y - 2;
-
-            float off_y1 = offset_y + (lbd_y * voxel_height);
-            float off_y2 = off_y1 + voxel_height;
-            float off_y3 = off_y2 + voxel_height;
+            const int_type lbd_y = y_begin;
+            const int_type ubd_y = std::min(y_end, dim_y - 2);
+            assert(lbd_y % 2 == 0);
 
+            float off_y1, off_y2, off_y3;
             float off_z1, off_z2, off_z3;
             float off_x1, off_x2;
 
@@ -517,6 +716,13 @@ namespace rendering {
 
             for (y = lbd_y; y < ubd_y; y += 2) {
 
+                // computed from y rather than accumulated, such that the
+                // positions do not depend on where a slab starts.
+                off_y1 = offset_y + static_cast<float>(y) * voxel_height;
+                off_y2 = off_y1 + voxel_height;
+                off_y3 = off_y2 + voxel_height;
+                output.beginSlices(y);
+
                 off_z1 = offset_z + (lbd_z * voxel_depth);
                 off_z2 = off_z1 + voxel_depth;
                 off_z3 = off_z2 + voxel_depth;
@@ -565,7 +771,7 @@ namespace rendering {
                             MC_ISOLEVEL_CHECK(values.hc.hc1.data[7], isolevel) +
                             MC_ISOLEVEL_CHECK(values.hc.hc1.data[8], isolevel));
 
-                    for (x = lbd_x + 1; x < ubd_x; x++) {
+                    for (x = lbd_x + 1; x <= ubd_x; x++) {
 
                         // copy second half cube to first half cube.
                         pre1          = pre2;
@@ -644,7 +850,8 @@ namespace rendering {
                             points.idx.c7.y = off_y2;
 
                             // triangulate.
-                            triangulate<0>(values, points, triangles, isolevel);
+                            output.setCube(x - 1, z, y);
+                            triangulate<0>(values, points, output, isolevel);
 
                             // cube 1
                             points.idx.c0.z = off_z1;
@@ -666,7 +873,8 @@ namespace rendering {
                             points.idx.c7.y = off_y3;
 
                             // triangulate.
-                            triangulate<1>(values, points, triangles, isolevel);
+                            output.setCube(x - 1, z, yy);
+                            triangulate<1>(values, points, output, isolevel);
 
                             // cube 2
                             points.idx.c0.z = off_z2;
@@ -688,7 +896,8 @@ namespace rendering {
                             points.idx.c7.y = off_y2;
 
                             // triangulate.
-                            triangulate<2>(values, points, triangles, isolevel);
+                            output.setCube(x - 1, zz, y);
+                            triangulate<2>(values, points, output, isolevel);
 
                             // cube 3
                             points.idx.c0.z = off_z2;
@@ -710,7 +919,8 @@ namespace rendering {
                             points.idx.c7.y = off_y3;
 
                             // triangulate.
-                            triangulate<3>(values, points, triangles, isolevel);
+                            output.setCube(x - 1, zz, yy);
+                            triangulate<3>(values, points, output, isolevel);
                         }
 
                         // update x positions.
@@ -724,150 +934,217 @@ namespace rendering {
                     off_z3 = off_z2 + voxel_depth;
                 }
 
-                // update y positions.
-                off_y1 = off_y3;
-                off_y2 = off_y1 + voxel_height;
-                off_y3 = off_y2 + voxel_height;
+                // is there a remaining z-slice?
+                if ((dim_z % 2) == 0) {
+                    for (const auto row : {y, yy}) {
+                        for (x = lbd_x; x < ubd_x; x++) {
+                            triangulate_cube(grid, dim_x, dim_xz, x, ubd_z,
+                                             row, offset_x, offset_z, offset_y,
+                                             voxel_width, voxel_depth,
+                                             voxel_height, isolevel, output);
+                        }
+                    }
+                }
             }
 
             // is there a remaining y-slice?
-            if ((dim_y % 2) == 0) {
+            if ((dim_y % 2) == 0 && ubd_y == dim_y - 2) {
+                output.beginSlices(ubd_y);
+                for (z = lbd_z; z <= ubd_z; z++) {
+                    for (x = lbd_x; x < ubd_x; x++) {
+                        triangulate_cube(grid, dim_x, dim_xz, x, z, ubd_y,
+                                         offset_x, offset_z, offset_y,
+                                         voxel_width, voxel_depth,
+                                         voxel_height, isolevel, output);
+                    }
+                }
+            }
+        }
 
-                // perform last y-slice.
-                y                 = ubd_y;
-                const int_type yy = y + 1;
-                off_y1 = offset_y + static_cast<float>(y) * voxel_height;
-                off_y2 = off_y1 + voxel_height;
+        /// The cube4 sweep advances two y-slices at once, thus the grid is
+        /// split into slabs at even y positions. Returns the first y-slice
+        /// of each of at most num_threads slabs, followed by the end of the
+        /// last slab.
+        std::vector<int_type> split_slabs(const int_type dim_y,
+                                          const std::size_t num_threads) {
 
-                off_z1 = offset_z + (lbd_z * voxel_depth);
-                off_z2 = off_z1 + voxel_depth;
+            const int_type ubd_y = dim_y - 2;
+            const std::size_t pairs =
+                ubd_y > 0 ? static_cast<std::size_t>(ubd_y + 1) / 2 : 0;
+            const std::size_t slabs =
+                std::max<std::size_t>(1, std::min(pairs, num_threads));
+
+            std::vector<int_type> bounds(slabs + 1);
+            for (std::size_t slab = 0; slab <= slabs; ++slab) {
+                bounds[slab] =
+                    static_cast<int_type>(2 * (slab * pairs / slabs));
+            }
+            return bounds;
+        }
 
-                for (z = lbd_z; z <= ubd_z; z += 1) {
+        void MarchingCubes::execute(const float* grid) { executeGrid(grid); }
 
-                    const int_type zz = z + 1;
-                    for (x = lbd_x; x < ubd_x; x++) {
+        void MarchingCubes::execute(const half* grid) { executeGrid(grid); }
 
-                        const int_type xx = x + 1;
+        void MarchingCubes::execute(const q15* grid) { executeGrid(grid); }
 
-                        values.data[cubeidx<0>::i0] =
-                            grid[MC_COMPUTE_INDEX(dim_x, dim_xz, x, z, y)];
-                        values.data[cubeidx<0>::i1] =
-                            grid[MC_COMPUTE_INDEX(dim_x, dim_xz, xx, z, y)];
-                        values.data[cubeidx<0>::i2] =
-                            grid[MC_COMPUTE_INDEX(dim_x, dim_xz, xx, z, yy)];
-                        values.data[cubeidx<0>::i3] =
-                            grid[MC_COMPUTE_INDEX(dim_x, dim_xz, x, z, yy)];
-                        values.data[cubeidx<0>::i4] =
-                            grid[MC_COMPUTE_INDEX(dim_x, dim_xz, x, zz, y)];
-                        values.data[cubeidx<0>::i5] =
-                            grid[MC_COMPUTE_INDEX(dim_x, dim_xz, xx, zz, y)];
-                        values.data[cubeidx<0>::i6] =
-                            grid[MC_COMPUTE_INDEX(dim_x, dim_xz, xx, zz, yy)];
-                        values.data[cubeidx<0>::i7] =
-                            grid[MC_COMPUTE_INDEX(dim_x, dim_xz, x, zz, yy)];
+        void MarchingCubes::executeIndexed(const float* grid) {
+            executeIndexedGrid(grid);
+        }
 
-                        points.idx.c0.z = off_z1;
-                        points.idx.c0.y = off_y1;
-                        points.idx.c1.z = off_z1;
-                        points.idx.c1.y = off_y1;
-                        points.idx.c2.z = off_z1;
-                        points.idx.c2.y = off_y2;
-                        points.idx.c3.z = off_z1;
-                        points.idx.c3.y = off_y2;
-
-                        points.idx.c4.z = off_z2;
-                        points.idx.c4.y = off_y1;
-                        points.idx.c5.z = off_z2;
-                        points.idx.c5.y = off_y1;
-                        points.idx.c6.z = off_z2;
-                        points.idx.c6.y = off_y2;
-                        points.idx.c7.z = off_z2;
-                        points.idx.c7.y = off_y2;
-
-                        // triangulate.
-                        triangulate<0>(values, points, triangles, isolevel);
-                    }
-                }
-            }
+        void MarchingCubes::executeIndexed(const half* grid) {
+            executeIndexedGrid(grid);
+        }
 
-            // is there a remaining z-slice?
-            if ((dim_z % 2) == 0) {
+        void MarchingCubes::executeIndexed(const q15* grid) {
+            executeIndexedGrid(grid);
+        }
 
-                // perform last z-slice.
-                z                 = ubd_z;
-                const int_type zz = z + 1;
-                off_z1 = offset_z + static_cast<float>(z) * voxel_depth;
-                off_z2 = off_z1 + voxel_height;
+        template <typename cell_type>
+        void MarchingCubes::executeGrid(const cell_type* grid) {
 
-                // ignore possible last (y) row in next section, if y-slice has
-                // been
-                // proceed.
-                const int iubd_y = ubd_y - (((dim_y % 2) == 0) ? (1) : (0));
+            triangle_vector_.clear();
 
-                off_y1 = offset_y + (lbd_y * voxel_height);
-                off_y2 = off_y1 + voxel_height;
-                for (y = lbd_y; y <= iubd_y; y += 1) {
+            const auto bounds = split_slabs(grid_dim_y_, num_threads_);
+            const auto slabs  = bounds.size() - 1;
+            if (slabs == 1) {
+                // As first estimation for the expected number of triangles
+                // we use sqrt(cubes).
+                triangle_vector_.reserve(static_cast<std::size_t>(
+                    sqrt(grid_dim_x_ * grid_dim_y_ * grid_dim_z_)));
+
+                triangle_output output(triangle_vector_);
+                perform_slices(grid, grid_dim_x_, grid_dim_z_, grid_dim_y_,
+                               offset_x_, offset_z_, offset_y_, voxel_width_,
+                               voxel_depth_, voxel_height_, isolevel_,
+                               bounds[0], bounds[1], output);
+                return;
+            }
 
-                    const int yy = y + 1;
-                    for (x = lbd_x; x < ubd_x; x++) {
+            // Each slab is triangulated into its own buffer and the buffers
+            // are concatenated in order, which yields the same triangles as
+            // a single slab.
+            std::vector<triangle_vector_type> slab_triangles(slabs);
+            ParallelFor(0, slabs, slabs, [&](const std::size_t begin,
+                                             const std::size_t end) {
+                for (auto slab = begin; slab < end; ++slab) {
+                    triangle_output output(slab_triangles[slab]);
+                    perform_slices(grid, grid_dim_x_, grid_dim_z_,
+                                   grid_dim_y_, offset_x_, offset_z_,
+                                   offset_y_, voxel_width_, voxel_depth_,
+                                   voxel_height_, isolevel_, bounds[slab],
+                                   bounds[slab + 1], output);
+                }
+            });
 
-                        const int_type xx = x + 1;
+            std::size_t num_triangles = 0;
+            for (const auto& triangles : slab_triangles) {
+                num_triangles += triangles.size();
+            }
+            triangle_vector_.reserve(num_triangles);
+            for (const auto& triangles : slab_triangles) {
+                triangle_vector_.insert(triangle_vector_.end(),
+                                        triangles.begin(), triangles.end());
+            }
+        }
 
-                        values.data[cubeidx<0>::i0] =
-                            grid[MC_COMPUTE_INDEX(dim_x, dim_xz, x, z, y)];
-                        values.data[cubeidx<0>::i1] =
-                            grid[MC_COMPUTE_INDEX(dim_x, dim_xz, xx, z, y)];
-                        values.data[cubeidx<0>::i2] =
-                            grid[MC_COMPUTE_INDEX(dim_x, dim_xz, xx, z, yy)];
-                        values.data[cubeidx<0>::i3] =
-                            grid[MC_COMPUTE_INDEX(dim_x, dim_xz, x, z, yy)];
-                        values.data[cubeidx<0>::i4] =
-                            grid[MC_COMPUTE_INDEX(dim_x, dim_xz, x, zz, y)];
-                        values.data[cubeidx<0>::i5] =
-                            grid[MC_COMPUTE_INDEX(dim_x, dim_xz, xx, zz, y)];
-                        values.data[cubeidx<0>::i6] =
-                            grid[MC_COMPUTE_INDEX(dim_x, dim_xz, xx, zz, yy)];
-                        values.data[cubeidx<0>::i7] =
-                            grid[MC_COMPUTE_INDEX(dim_x, dim_xz, x, zz, yy)];
+        template <typename cell_type>
+        void MarchingCubes::executeIndexedGrid(const cell_type* grid) {
 
-                        points.idx.c0.z = off_z1;
-                        points.idx.c0.y = off_y1;
-                        points.idx.c1.z = off_z1;
-                        points.idx.c1.y = off_y1;
-                        points.idx.c2.z = off_z1;
-                        points.idx.c2.y = off_y2;
-                        points.idx.c3.z = off_z1;
-                        points.idx.c3.y = off_y2;
-
-                        points.idx.c4.z = off_z2;
-                        points.idx.c4.y = off_y1;
-                        points.idx.c5.z = off_z2;
-                        points.idx.c5.y = off_y1;
-                        points.idx.c6.z = off_z2;
-                        points.idx.c6.y = off_y2;
-                        points.idx.c7.z = off_z2;
-                        points.idx.c7.y = off_y2;
-
-                        // triangulate.
-                        triangulate<0>(values, points, triangles, isolevel);
+            vertices_.clear();
+            normals_.clear();
+            indices_.clear();
+
+            const auto bounds = split_slabs(grid_dim_y_, num_threads_);
+            const auto slabs  = bounds.size() - 1;
+            std::vector<indexed_output> outputs;
+            outputs.reserve(slabs);
+            for (std::size_t slab = 0; slab < slabs; ++slab) {
+                outputs.emplace_back(grid_dim_x_, grid_dim_z_);
+            }
+            ParallelFor(0, slabs, slabs, [&](const std::size_t begin,
+                                             const std::size_t end) {
+                for (auto slab = begin; slab < end; ++slab) {
+                    perform_slices(grid, grid_dim_x_, grid_dim_z_,
+                                   grid_dim_y_, offset_x_, offset_z_,
+                                   offset_y_, voxel_width_, voxel_depth_,
+                                   voxel_height_, isolevel_, bounds[slab],
+                                   bounds[slab + 1], outputs[slab]);
+                }
+            });
+
+            // The x- and z-edges on the first y-slice of a slab have been
+            // created by the preceding slab as well. Those vertices are
+            // mapped to the ones of the preceding slab, all others are
+            // appended in order. This yields the same mesh as a single slab.
+            std::vector<indexed_output::vertex_type> remap, prev_remap;
+            for (std::size_t slab = 0; slab < slabs; ++slab) {
+                const auto& output = outputs[slab];
+                remap.assign(output.getVertices().size(),
+                             indexed_output::NO_VERTEX);
+                if (slab > 0) {
+                    const auto& first = output.getFirstSlice();
+                    const auto& last  = outputs[slab - 1].getLastSlice();
+                    for (std::size_t edge = 0; edge < first.size(); ++edge) {
+                        if (edge % 3 != 1 &&
+                            first[edge] != indexed_output::NO_VERTEX) {
+                            assert(last[edge] != indexed_output::NO_VERTEX);
+                            remap[first[edge]] = prev_remap[last[edge]];
+                        }
                     }
                 }
+                for (std::size_t v = 0; v < remap.size(); ++v) {
+                    if (remap[v] == indexed_output::NO_VERTEX) {
+                        remap[v] =
+                            static_cast<indexed_output::vertex_type>(
+                                vertices_.size());
+                        vertices_.push_back(output.getVertices()[v]);
+                    }
+                }
+                for (const auto idx : output.getIndices()) {
+                    indices_.push_back(remap[idx]);
+                }
+                remap.swap(prev_remap);
+            }
+
+            // Area weighted vertex normals. The triangles are wound
+            // clockwise when seen from the side of the lower values.
+            normals_.assign(vertices_.size(), vec3f(0.0f, 0.0f, 0.0f));
+            for (std::size_t idx = 0; idx < indices_.size(); idx += 3) {
+                const auto& v1 = vertices_[indices_[idx]];
+                const auto& v2 = vertices_[indices_[idx + 1]];
+                const auto& v3 = vertices_[indices_[idx + 2]];
+                const vec3f e1(v3.x - v1.x, v3.y - v1.y, v3.z - v1.z);
+                const vec3f e2(v2.x - v1.x, v2.y - v1.y, v2.z - v1.z);
+                const auto n = e1.cross(e2);
+                for (auto corner = idx; corner < idx + 3; ++corner) {
+                    auto& normal = normals_[indices_[corner]];
+                    normal.x += n.x;
+                    normal.y += n.y;
+                    normal.z += n.z;
+                }
+            }
+            for (auto& normal : normals_) {
+                const auto length = std::sqrt(normal.x * normal.x +
+                                              normal.y * normal.y +
+                                              normal.z * normal.z);
+                if (length > 0.0f) {
+                    normal.x /= length;
+                    normal.y /= length;
+                    normal.z /= length;
+                }
             }
         }
 
-        void MarchingCubes::execute(const float* grid) {
+        void MarchingCubes::setNumThreads(const std::size_t num_threads) {
 
-            triangle_vector_.clear();
+            num_threads_ =
+                num_threads == 0 ? HardwareConcurrency() : num_threads;
+        }
 
-            // As first estimation for the expected number of triangles we use
-            // sqrt(cubes).
-            triangle_vector_.reserve(static_cast<std::size_t>(
-                sqrt(grid_dim_x_ * grid_dim_y_ * grid_dim_z_)));
+        std::size_t MarchingCubes::getNumThreads() const {
 
-            perform_slices(grid, grid_dim_x_, grid_dim_z_, grid_dim_y_,
-                           offset_x_, offset_z_, offset_y_, voxel_width_,
-                           voxel_depth_, voxel_height_, isolevel_,
-                           triangle_vector_);
+            return num_threads_;
         }
 
     } // namespace mc
@@ -13,6 +13,8 @@
 #ifndef RENDERING_MC_MARCHING_CUBES_HPP
 #define RENDERING_MC_MARCHING_CUBES_HPP
 
+#include <cstddef>
+#include <cstdint>
 #include <vector>
 
 #include "common/types/triangle.hpp"
@@ -29,6 +31,8 @@ namespace rendering {
 
           public:
             typedef std::vector<triangle> triangle_vector_type;
+            typedef std::vector<vec3f> vertex_vector_type;
+            typedef std::vector<std::uint32_t> index_vector_type;
             MarchingCubes();
             MarchingCubes(const float offset_x, const float offset_y,
                           const float offset_z, const float voxel_width,
@@ -50,21 +54,74 @@ namespace rendering {
             /// be extracted
             void execute(const float* grid);
 
+            /// Extracts an iso-surface from a half precision or Q15 voxel
+            /// grid. The isolevel is given as distance, just like for a
+            /// grid of floats.
+            void execute(const half* grid);
+            void execute(const q15* grid);
+
             /// Returns the triangles of the extracted iso-surface.
             /// Should be invoked after execute().
             const triangle_vector_type& getTriangles() const;
 
+            /// Extracts an iso-surface as indexed mesh, i.e. each
+            /// intersected grid edge yields a single vertex, which is
+            /// shared by all adjacent triangles. Must be executed before
+            /// getVertices(), getNormals() and getIndices() should be
+            /// invoked.
+            /// @param *grid the voxelgrid from which the iso-surface shall
+            /// be extracted
+            void executeIndexed(const float* grid);
+            void executeIndexed(const half* grid);
+            void executeIndexed(const q15* grid);
+
+            /// Returns the vertices of the extracted indexed mesh.
+            const vertex_vector_type& getVertices() const;
+
+            /// Returns the area weighted vertex normals of the extracted
+            /// indexed mesh, pointing towards the lower values.
+            const vertex_vector_type& getNormals() const;
+
+            /// Returns three vertex indices per triangle of the extracted
+            /// indexed mesh. Triangles are stored in the same order and
+            /// with the same winding as by execute().
+            const index_vector_type& getIndices() const;
+
+            /// Sets the number of threads used by execute(). The grid is
+            /// split into slabs along the y-axis, one per thread; the
+            /// resulting triangles do not depend on the number of threads.
+            /// @param num_threads number of threads, 0 uses all hardware
+            /// threads. Defaults to 1.
+            void setNumThreads(const std::size_t num_threads);
+            std::size_t getNumThreads() const;
+
             int_type getGridDimX() const;
             int_type getGridDimY() const;
             int_type getGridDimZ() const;
 
-            /// @brief Saves the surface data as an obj-file.
-            /// @param name the name of the obj-file (without .obj)
+            /// @brief Saves the surface data as an obj-file, see
+            /// io::WriteOBJ. Vertices at the same position are written
+            /// only once.
+            /// @param name the name of the obj-file
+            /// @param normals one normal per triangle
             void saveASOBJ(const char* name,
                            const triangle_vector_type& triangles,
                            const std::vector<vec3f>& normals) const;
 
+            /// @brief Saves an indexed mesh as an obj-file, writing each
+            /// vertex only once, see io::WriteOBJ.
+            /// @param name the name of the obj-file
+            void saveASOBJ(const char* name,
+                           const vertex_vector_type& vertices,
+                           const vertex_vector_type& normals,
+                           const index_vector_type& indices) const;
+
           private:
+            template <typename cell_type>
+            void executeGrid(const cell_type* grid);
+            template <typename cell_type>
+            void executeIndexedGrid(const cell_type* grid);
+
             /// origin of the voxel grid
             float offset_x_;
             float offset_y_;
@@ -81,12 +138,21 @@ namespace rendering {
             int_type grid_dim_y_;
             int_type grid_dim_z_;
 
+            /// number of threads used for extraction
+            std::size_t num_threads_;
+
             /// the triangle data of the currently extracted surface
             triangle_vector_type triangle_vector_;
+
+            /// the currently extracted indexed mesh
+            vertex_vector_type vertices_;
+            vertex_vector_type normals_;
+            index_vector_type indices_;
         };
 
+        template <typename cell_type>
         inline void interpolate(vec3f& result, const vec3f& p1, const vec3f& p2,
-                                const grid_cell& valp1, const grid_cell& valp2,
+                                const cell_type& valp1, const cell_type& valp2,
                                 const float isolevel) {
 
             const float mu = ((isolevel - MC_VALUE(valp1)) /
@@ -23,6 +23,21 @@ namespace rendering {
             return triangle_vector_;
         }
 
+        inline const MarchingCubes::vertex_vector_type&
+        MarchingCubes::getVertices() const {
+            return vertices_;
+        }
+
+        inline const MarchingCubes::vertex_vector_type&
+        MarchingCubes::getNormals() const {
+            return normals_;
+        }
+
+        inline const MarchingCubes::index_vector_type&
+        MarchingCubes::getIndices() const {
+            return indices_;
+        }
+
         inline int_type MarchingCubes::getGridDimX() const {
             return grid_dim_x_;
         }
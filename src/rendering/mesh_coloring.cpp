@@ -20,11 +20,12 @@
 
 #include "rendering/mesh_coloring.hpp"
 
+#include <algorithm>
 #include <cassert>
 #include <cstddef>
-#include <map>
 #include <type_traits>
 #include <utility>
+#include <vector>
 
 #include <vtkDataArray.h>
 #include <vtkPointData.h>
@@ -36,8 +37,11 @@
 #include <opencv2/imgproc/imgproc.hpp>
 
 #include "common/camera.hpp"
+#include "common/parallel.hpp"
 #include "common/utils.hpp"
-#include "rendering/cv_utils.hpp"
+#include "rendering/depth_buffer.hpp"
+#include "rendering/direction_lookup.hpp"
+#include "rendering/projection_table.hpp"
 #include "rendering/vtk_utils.hpp"
 
 namespace ret {
@@ -69,48 +73,91 @@ namespace rendering {
         return img.at<cv::Vec3b>(pt.y, pt.x);
     }
 
-    Color<double> getAverageColor(const vtkSmartPointer<vtkPolyData> &mesh,
-                                  const std::vector<Camera> &dataset, int idx,
-                                  const std::map<size_t, double> &angles) {
+    // minimal dot product between normal and viewing direction
+    const double MIN_VIEW_DOT = 0.5;
+
+    Color<double> getAverageColor(const cv::Point3d &vertex,
+                                  const cv::Vec3d &normal,
+                                  const std::vector<cv::Mat> &images,
+                                  const ProjectionTable &table,
+                                  const DirectionLookup &lookup,
+                                  const MeshVisibility &visibility,
+                                  const std::size_t idx) {
         Color<double> color;
-        for (const auto &angle : angles) {
-            double v[3];
-            mesh->GetPoint(idx, v);
-            Camera cam = dataset[angle.first];
-            auto col_pix = project<cv::Point2f, cv::Point3d>(
-                cam, cv::Point3d(v[0], v[1], v[2]));
-            color += getColor(cam.getImage(), col_pix) * angle.second;
+        std::size_t num_views = 0;
+
+        // the first camera contributes regardless of its angle, unless the
+        // vertex is occluded in its image
+        const auto col_pix0 =
+            table.project<cv::Point2f, cv::Point3d>(0, vertex);
+        if (visibility.isVisible(0, idx)) {
+            const auto dot = normal.dot(table.getDirection(0));
+            color += getColor(images[0], col_pix0) * std::max(dot, 0.0);
+            ++num_views;
+        }
+        for (const auto cam_idx : lookup.getCandidates(normal)) {
+            const auto dot = normal.dot(table.getDirection(cam_idx));
+            if (cam_idx == 0 || dot < MIN_VIEW_DOT ||
+                !visibility.isVisible(cam_idx, idx)) {
+                continue;
+            }
+            const auto col_pix =
+                table.project<cv::Point2f, cv::Point3d>(cam_idx, vertex);
+            color += getColor(images[cam_idx], col_pix) * dot;
+            ++num_views;
+        }
+
+        // vertices hidden from every camera take the unweighted color of
+        // the first one
+        if (num_views == 0) {
+            color += getColor(images[0], col_pix0);
+            num_views = 1;
         }
 
         // weighted mean average color for each vertex
-        color /= angles.size();
+        color /= num_views;
         return color;
     }
 
     void Colorize(vtkSmartPointer<vtkPolyData> mesh,
-                  std::vector<Camera> dataset) {
+                  const std::vector<Camera> &dataset,
+                  const std::size_t num_threads) {
 
         assert(not dataset.empty());
+        auto *const meshNormals = mesh->GetPointData()->GetNormals();
+        const ProjectionTable table(dataset);
+        const MeshVisibility visibility(mesh, dataset, num_threads);
+        const DirectionLookup lookup(table, table.size(), MIN_VIEW_DOT);
+
+        // fetch every image once instead of once per vertex and view
+        std::vector<cv::Mat> images;
+        images.reserve(dataset.size());
+        for (const auto &cam : dataset) {
+            images.emplace_back(cam.getImage());
+        }
+
+        // each thread writes the colors of its own range of vertices
+        const auto num_points = mesh->GetNumberOfPoints();
         auto colors = vtkSmartPointer<vtkUnsignedCharArray>::New();
         colors->SetNumberOfComponents(3);
+        colors->SetNumberOfTuples(num_points);
         colors->SetName("Colors");
-        auto *const meshNormals = mesh->GetPointData()->GetNormals();
-        for (auto idx = 0; idx < mesh->GetNumberOfPoints(); ++idx) {
-
-            // camera image indexes and appropriate dot product
-            std::map<std::size_t, double> angles;
-            auto normal = GetNormal(meshNormals, idx);
-            angles[0] = normal.dot(dataset[0].getDirection());
-            for (std::size_t j = 1; j < dataset.size(); ++j) {
-                auto angle = normal.dot(dataset[j].getDirection());
-                if (angle >= 0.5) {
-                    angles[j] = angle;
-                }
-            }
-
-            Color<double> color = getAverageColor(mesh, dataset, idx, angles);
-            colors->InsertNextTuple(reinterpret_cast<double *>(&color));
-        }
+        auto *const rgb = colors->GetPointer(0);
+        ParallelFor(0, static_cast<std::size_t>(num_points), num_threads,
+                    [&](const std::size_t begin, const std::size_t end) {
+                        for (auto idx = begin; idx < end; ++idx) {
+                            const auto color = getAverageColor(
+                                GetVertex(mesh, idx),
+                                GetNormal(meshNormals, idx), images, table,
+                                lookup, visibility, idx);
+                            rgb[3 * idx]     =
+                                static_cast<unsigned char>(color.r);
+                            rgb[3 * idx + 1] =
+                                static_cast<unsigned char>(color.g);
+                            rgb[3 * idx + 2] =
+                                static_cast<unsigned char>(color.b);
+                        }
+                    });
         mesh->GetPointData()->SetScalars(colors);
     }
 
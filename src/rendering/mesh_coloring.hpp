@@ -21,6 +21,7 @@
 #ifndef RENDERING_MESH_COLORING_HPP
 #define RENDERING_MESH_COLORING_HPP
 
+#include <cstddef>
 #include <vector>
 #include <vtkSmartPointer.h>
 class vtkPolyData;
@@ -34,11 +35,19 @@ namespace rendering {
       * vertex of the mesh.
       * Extracts color information from the whole dataset and
       * colorizes each vertex of the mesh using a robust weighted
-      * approach where inconsistent surface colors are filtered
+      * approach where inconsistent surface colors are filtered.
+      * Cameras, in which a vertex is occluded by the mesh itself, are
+      * skipped, see @ref MeshVisibility. The first camera is blended in
+      * regardless of its viewing angle, a vertex occluded in every camera
+      * takes the color of the first one. The vertices are colorized in
+      * parallel, the colors do not depend on the number of threads
       * @param mesh 3D reconstructed mesh
-      * @param dataset Camera dataset for the given mesh */
+      * @param dataset Camera dataset for the given mesh
+      * @param num_threads number of threads, 0 uses all hardware threads
+      * and 1 colorizes serially */
     void Colorize(vtkSmartPointer<vtkPolyData> mesh,
-                  std::vector<Camera> dataset);
+                  const std::vector<Camera> &dataset,
+                  const std::size_t num_threads = 0);
 } // namespace rendering
 } // namespace ret
 
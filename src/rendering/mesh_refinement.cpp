@@ -27,6 +27,8 @@
 #include <opencv2/core/mat.hpp>
 #include <opencv2/core/operations.hpp>
 #include "common/camera.hpp"
+#include "rendering/direction_lookup.hpp"
+#include "rendering/projection_table.hpp"
 #include "rendering/vtk_utils.hpp"
 
 namespace ret {
@@ -34,18 +36,10 @@ namespace ret {
     namespace rendering {
 
         std::size_t GetMiddleCamera(cv::Vec3d normal,
-                                    const std::vector<Camera> &dataset) {
-
-            auto best_angle = -1.0;
-            auto cam_idx = 0;
-            for (auto i = 0; i < dataset.size(); ++i) {
-                auto current_angle = normal.dot(dataset[i].getDirection());
-                if (current_angle > best_angle) {
-                    best_angle = current_angle;
-                    cam_idx = i;
-                }
-            }
+                                    const DirectionLookup &lookup) {
 
+            std::size_t cam_idx = 0;
+            lookup.findBest(normal, &cam_idx, 1);
             return cam_idx;
         }
 
@@ -59,12 +53,13 @@ namespace ret {
                         const std::vector<Camera> &dataset) {
 
             auto *const meshNormals = mesh->GetPointData()->GetNormals();
+            const DirectionLookup lookup(ProjectionTable(dataset), 1);
 
             for (std::size_t idx = 0; idx < mesh->GetNumberOfPoints(); ++idx) {
 
                 auto normal = GetNormal(meshNormals, idx);
                 auto vertex = GetVertex(mesh, idx);
-                int cam_idx = GetMiddleCamera(normal, dataset);
+                int cam_idx = GetMiddleCamera(normal, lookup);
 
             }
         }
@@ -0,0 +1,307 @@
+// Copyright (c) 2015-2016, Kai Wolf
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "rendering/octree_carving.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <limits>
+#include <utility>
+
+#include <opencv2/core/core.hpp>
+#include <vtkPolyData.h>
+
+#include "common/camera.hpp"
+#include "common/parallel.hpp"
+#include "common/types/triangle.hpp"
+#include "common/utils.hpp"
+#include "filtering/dist_map_cache.hpp"
+#include "filtering/preprocessing.hpp"
+#include "rendering/surface_extraction.hpp"
+#include "rendering/voxel_carving_kernel.hpp"
+
+namespace ret {
+
+namespace rendering {
+
+    namespace {
+        constexpr std::size_t B = SparseVoxelGrid::BRICK_SIZE;
+
+        // the distance map is calculated with a 3x3 mask, which deviates
+        // from the euclidean distance by less than 5 percent. Additionally
+        // a voxel is looked up at its rounded image coordinates
+        constexpr float DIST_SAFETY_FACTOR = 1.1f;
+        constexpr float DIST_SAFETY_MARGIN = 1.0f;
+    } // namespace
+
+    OctreeCarving::OctreeCarving(const bb_bounds bbox,
+                                 const std::size_t voxel_dim)
+        : voxel_dim_(voxel_dim),
+          num_threads_(HardwareConcurrency()),
+          params_(CalcStartParameter(bbox, voxel_dim,
+                                     std::make_pair(0.10f, 0.10f))),
+          grid_(ret::make_unique<SparseVoxelGrid>(
+              voxel_dim, std::numeric_limits<float>::max())),
+          dist_cache_() {}
+
+    void OctreeCarving::carve(const std::vector<Camera>& cams) {
+
+        grid_ = ret::make_unique<SparseVoxelGrid>(
+            voxel_dim_, std::numeric_limits<float>::max());
+
+        std::vector<carve_view> views(cams.size());
+        ParallelFor(0, cams.size(), num_threads_,
+                    [&](const std::size_t c_begin, const std::size_t c_end) {
+                        for (auto c = c_begin; c < c_end; ++c) {
+                            const auto& Mask = cams[c].getMask();
+                            views[c]        = CreateCarveView(
+                                cams[c].getProjectionMatrix(), Mask,
+                                filtering::GetDistMap(cams[c],
+                                                      dist_cache_.get()));
+                        }
+                    });
+
+        // phase 1: classify the cells of one octree level after another
+        // and only refine the boundary cells
+        const auto brick_dim = grid_->getBrickDim();
+        std::vector<cell> cells = {
+            {{0, 0, 0}, {brick_dim, brick_dim, brick_dim}}};
+        std::vector<std::size_t> boundary;
+        while (not cells.empty()) {
+
+            std::vector<cell_state> states(cells.size());
+            std::vector<float> values(cells.size());
+            ParallelFor(0, cells.size(), num_threads_,
+                        [&](const std::size_t begin, const std::size_t end) {
+                            for (auto idx = begin; idx < end; ++idx) {
+                                states[idx] =
+                                    classify(views, cells[idx], values[idx]);
+                            }
+                        });
+
+            std::vector<cell> refined;
+            for (std::size_t idx = 0; idx < cells.size(); ++idx) {
+                const auto& c = cells[idx];
+                if (states[idx] != cell_state::Boundary) {
+                    for (auto bi = c.begin[0]; bi < c.end[0]; ++bi) {
+                        for (auto bj = c.begin[1]; bj < c.end[1]; ++bj) {
+                            for (auto bk = c.begin[2]; bk < c.end[2]; ++bk) {
+                                grid_->setUniform(
+                                    grid_->getBrickIdx(bi, bj, bk),
+                                    values[idx]);
+                            }
+                        }
+                    }
+                    continue;
+                }
+
+                if (c.end[0] - c.begin[0] == 1 && c.end[1] - c.begin[1] == 1 &&
+                    c.end[2] - c.begin[2] == 1) {
+                    boundary.push_back(
+                        grid_->getBrickIdx(c.begin[0], c.begin[1], c.begin[2]));
+                    continue;
+                }
+
+                // split each axis in halves, as long as it spans more than
+                // a single brick
+                std::size_t splits[3][3];
+                std::size_t num_splits[3];
+                for (auto axis = 0; axis < 3; ++axis) {
+                    const auto extent = c.end[axis] - c.begin[axis];
+                    splits[axis][0]   = c.begin[axis];
+                    splits[axis][1]   = c.begin[axis] + (extent + 1) / 2;
+                    splits[axis][2]   = c.end[axis];
+                    num_splits[axis]  = extent > 1 ? 2 : 1;
+                    if (extent == 1) {
+                        splits[axis][1] = c.end[axis];
+                    }
+                }
+                for (std::size_t si = 0; si < num_splits[0]; ++si) {
+                    for (std::size_t sj = 0; sj < num_splits[1]; ++sj) {
+                        for (std::size_t sk = 0; sk < num_splits[2]; ++sk) {
+                            refined.push_back(
+                                {{splits[0][si], splits[1][sj], splits[2][sk]},
+                                 {splits[0][si + 1], splits[1][sj + 1],
+                                  splits[2][sk + 1]}});
+                        }
+                    }
+                }
+            }
+            cells.swap(refined);
+        }
+
+        // phase 2: carve the boundary bricks densely
+        ParallelFor(0, boundary.size(), num_threads_,
+                    [&](const std::size_t begin, const std::size_t end) {
+                        for (auto idx = begin; idx < end; ++idx) {
+                            const auto brick = boundary[idx];
+                            const auto bk    = brick % brick_dim;
+                            const auto bj    = (brick / brick_dim) % brick_dim;
+                            const auto bi    = brick / (brick_dim * brick_dim);
+                            carveBrick(views, bi, bj, bk,
+                                       grid_->allocate(brick));
+                        }
+                    });
+    }
+
+    OctreeCarving::cell_state OctreeCarving::classify(
+        const std::vector<carve_view>& views, const cell& c,
+        float& value) const {
+
+        // bounding box of the voxel centers including one voxel margin in
+        // each direction, such that the neighbors of uniform cells have
+        // the same sign and no surface passes through uniform cells
+        float lower[3], upper[3];
+        const float start[3] = {params_.start_z, params_.start_y,
+                                params_.start_x};
+        const float size[3] = {params_.voxel_depth, params_.voxel_height,
+                               params_.voxel_width};
+        for (auto axis = 0; axis < 3; ++axis) {
+            const auto first = static_cast<float>(c.begin[axis] * B) - 1.0f;
+            const auto last  = static_cast<float>(
+                std::min(c.end[axis] * B, voxel_dim_));
+            lower[axis] = start[axis] + first * size[axis];
+            upper[axis] = start[axis] + last * size[axis];
+        }
+
+        const float center[3] = {(lower[2] + upper[2]) / 2.0f,
+                                 (lower[1] + upper[1]) / 2.0f,
+                                 (lower[0] + upper[0]) / 2.0f};
+
+        auto inside     = true;
+        auto min_inside = std::numeric_limits<float>::max();
+        for (const auto& view : views) {
+
+            const auto P = view.P;
+            auto project = [&](const float x, const float y, const float z,
+                               float& im_x, float& im_y) {
+                const auto w = P[8] * x + P[9] * y + P[10] * z + P[11];
+                im_x = (P[0] * x + P[1] * y + P[2] * z + P[3]) / w;
+                im_y = (P[4] * x + P[5] * y + P[6] * z + P[7]) / w;
+                return w > 0.0f;
+            };
+
+            // the projection of the cell lies within the convex hull of its
+            // projected corners, which lies within a circle around the
+            // projected center
+            float c_x, c_y;
+            auto valid = project(center[0], center[1], center[2], c_x, c_y);
+            auto rho   = 0.0f;
+            for (auto corner = 0; corner < 8 && valid; ++corner) {
+                float im_x, im_y;
+                valid = project(corner & 1 ? upper[2] : lower[2],
+                                corner & 2 ? upper[1] : lower[1],
+                                corner & 4 ? upper[0] : lower[0], im_x, im_y);
+                rho = std::max(rho, std::hypot(im_x - c_x, im_y - c_y));
+            }
+            if (not valid) {
+                // cell reaches behind the camera
+                inside = false;
+                continue;
+            }
+
+            const auto r      = DIST_SAFETY_FACTOR * rho + DIST_SAFETY_MARGIN;
+            const auto width  = static_cast<float>(view.width);
+            const auto height = static_cast<float>(view.height);
+            if (c_x + r <= 0.0f || c_y + r <= 0.0f ||
+                c_x - r >= width || c_y - r >= height) {
+                // every voxel is projected outside of the image
+                value = -1.0f;
+                return cell_state::Outside;
+            }
+
+            if (c_x - r <= 0.0f || c_y - r <= 0.0f ||
+                c_x + r >= width || c_y + r >= height) {
+                inside = false;
+                continue;
+            }
+
+            const auto x    = cvRound(c_x);
+            const auto y    = cvRound(c_y);
+            const auto dist = view.signed_dist[static_cast<std::size_t>(
+                y * view.width + x)];
+            if (dist < -r) {
+                // no silhouette edge within the projection of the cell
+                value = dist + r;
+                return cell_state::Outside;
+            }
+            if (dist > r) {
+                min_inside = std::min(min_inside, dist - r);
+            } else {
+                inside = false;
+            }
+        }
+
+        if (inside) {
+            value = min_inside;
+            return cell_state::Inside;
+        }
+
+        return cell_state::Boundary;
+    }
+
+    void OctreeCarving::carveBrick(const std::vector<carve_view>& views,
+                                   const std::size_t bi, const std::size_t bj,
+                                   const std::size_t bk, float* storage) const {
+
+        const auto k_begin = bk * B;
+        const auto k_end   = std::min(k_begin + B, voxel_dim_);
+        for (std::size_t li = 0; li < B && bi * B + li < voxel_dim_; ++li) {
+            for (std::size_t lj = 0; lj < B && bj * B + lj < voxel_dim_;
+                 ++lj) {
+                auto row = storage + (li * B + lj) * B;
+                for (const auto& view : views) {
+                    CarveRow(view, params_, bi * B + li, bj * B + lj, k_begin,
+                             k_end, row);
+                }
+            }
+        }
+    }
+
+    vtkSmartPointer<vtkPolyData> OctreeCarving::createVisualHull() const {
+
+        // no surface passes through a uniform brick, including its margin
+        // of one voxel
+        std::vector<triangle> surface;
+        ExtractSurface(*grid_, params_, 0.0f, num_threads_, surface);
+
+        const auto voxel_size =
+            std::min({params_.voxel_width, params_.voxel_height,
+                      params_.voxel_depth});
+        return CreatePolyData(surface, 1e-3 * voxel_size);
+    }
+
+    void OctreeCarving::setNumThreads(const std::size_t num_threads) {
+
+        num_threads_ = num_threads == 0 ? HardwareConcurrency() : num_threads;
+    }
+
+    void OctreeCarving::setDistMapCache(
+        std::shared_ptr<filtering::DistMapCache> cache) {
+
+        dist_cache_ = std::move(cache);
+    }
+
+    const SparseVoxelGrid& OctreeCarving::getVoxelGrid() const {
+        return *grid_;
+    }
+} // namespace rendering
+} // namespace ret
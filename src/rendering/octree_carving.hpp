@@ -0,0 +1,114 @@
+// Copyright (c) 2015-2016, Kai Wolf
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#ifndef RENDERING_OCTREE_CARVING_HPP
+#define RENDERING_OCTREE_CARVING_HPP
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+#include <vtkSmartPointer.h>
+
+#include "rendering/bounding_box.hpp"
+#include "rendering/sparse_voxel_grid.hpp"
+#include "rendering/voxel_carving.hpp"
+
+class vtkPolyData;
+namespace ret { class Camera; }
+namespace ret { namespace filtering { class DistMapCache; } }
+
+namespace ret {
+
+namespace rendering {
+
+    struct carve_view;
+
+    /** @brief Creates a visual hull like @ref VoxelCarving, but carves
+      * coarse to fine. Starting with the whole voxel grid, each cell is
+      * projected into every camera and classified using the distance maps
+      * as either fully inside, fully outside or intersecting the
+      * silhouette boundary. Only boundary cells are subdivided further,
+      * down to bricks of @ref SparseVoxelGrid::BRICK_SIZE^3 voxels which
+      * are carved densely. Memory and time therefore grow with the surface
+      * of the object instead of the volume of the voxel grid.
+      *
+      * Cells are classified including a margin of one voxel, hence the
+      * sign of every voxel is the same as for @ref VoxelCarving and all
+      * voxels near the surface are carved with identical values */
+    class OctreeCarving {
+      public:
+        /** @brief Prepares an empty voxel grid
+          * @param bbox Dimensions of the bounding box
+          * @param voxel_dim Dimension of the voxel grid */
+        OctreeCarving(const bb_bounds bbox, const std::size_t voxel_dim);
+
+        OctreeCarving(OctreeCarving const&)            = delete;
+        OctreeCarving operator&=(OctreeCarving const&) = delete;
+
+        /** @brief Carves the voxel grid with all cameras of a set. Any
+          * previous result is discarded
+          * @param cams complete @ref Camera set */
+        void carve(const std::vector<Camera>& cams);
+
+        /** @brief Creates the visual hull from the boundary bricks of the
+          * carved voxel grid
+          * @return visual hull */
+        vtkSmartPointer<vtkPolyData> createVisualHull() const;
+
+        /** @brief Sets the number of threads used for classification,
+          * carving and surface extraction
+          * @param num_threads number of threads, 0 uses all hardware
+          * threads */
+        void setNumThreads(const std::size_t num_threads);
+
+        /** @brief Shares a cache for the distance maps of the camera
+          * masks, see @ref VoxelCarving::setDistMapCache
+          * @param cache distance map cache or nullptr to disable caching */
+        void setDistMapCache(std::shared_ptr<filtering::DistMapCache> cache);
+
+        /** @brief Returns the carved sparse voxel grid. Voxel values of
+          * uniform bricks are bounds of the actual values with the correct
+          * sign */
+        const SparseVoxelGrid& getVoxelGrid() const;
+
+      private:
+        /** half-open range of bricks along each axis (i, j, k) */
+        struct cell {
+            std::size_t begin[3], end[3];
+        };
+
+        enum class cell_state { Inside, Outside, Boundary };
+
+        cell_state classify(const std::vector<carve_view>& views,
+                            const cell& c, float& value) const;
+        void carveBrick(const std::vector<carve_view>& views,
+                        const std::size_t bi, const std::size_t bj,
+                        const std::size_t bk, float* storage) const;
+
+        std::size_t voxel_dim_, num_threads_;
+        start_params params_;
+        std::unique_ptr<SparseVoxelGrid> grid_;
+        std::shared_ptr<filtering::DistMapCache> dist_cache_;
+    };
+} // namespace rendering
+} // namespace ret
+
+#endif
@@ -0,0 +1,146 @@
+// Copyright (c) 2015-2016, Kai Wolf
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "rendering/projection_table.hpp"
+
+#include <cassert>
+#include <cstdint>
+#include <utility>
+
+#include "common/camera.hpp"
+#include "common/dataset.hpp"
+
+namespace ret {
+
+namespace rendering {
+
+    namespace {
+        const std::size_t ROW_ALIGNMENT = 32;
+        const std::size_t ROW_FLOATS    = ROW_ALIGNMENT / sizeof(float);
+
+        // allocates a zeroed block starting at a ROW_ALIGNMENT boundary
+        std::shared_ptr<float> AllocateAligned(const std::size_t num_floats) {
+            std::shared_ptr<float> block(
+                new float[num_floats + ROW_FLOATS](),
+                std::default_delete<float[]>());
+            const auto address =
+                reinterpret_cast<std::uintptr_t>(block.get());
+            const auto offset =
+                (ROW_ALIGNMENT - address % ROW_ALIGNMENT) % ROW_ALIGNMENT;
+            return std::shared_ptr<float>(block,
+                                          block.get() + offset / sizeof(float));
+        }
+    } // namespace
+
+    ProjectionTable::ProjectionTable() : num_cams_(0), stride_(0), data_() {}
+
+    ProjectionTable::ProjectionTable(const Camera* cams,
+                                     const std::size_t num_cams)
+        : num_cams_(num_cams),
+          stride_((num_cams + ROW_FLOATS - 1) / ROW_FLOATS * ROW_FLOATS),
+          data_() {
+
+        auto data = AllocateAligned(NUM_ROWS * stride_);
+        for (std::size_t c = 0; c < num_cams_; ++c) {
+            const auto& cam = cams[c];
+            const auto P    = cam.getProjectionMatrix();
+            assert(P.type() == CV_32F);
+            for (auto r = 0; r < 3; ++r) {
+                for (auto col = 0; col < 4; ++col) {
+                    data.get()[(4 * r + col) * stride_ + c] =
+                        P.at<float>(r, col);
+                }
+            }
+
+            const auto center = cam.getCenter();
+            const auto& dir   = cam.getDirection();
+            const float values[] = {static_cast<float>(center.x),
+                                    static_cast<float>(center.y),
+                                    static_cast<float>(center.z),
+                                    dir[0], dir[1], dir[2]};
+            for (auto r = 0; r < 6; ++r) {
+                data.get()[(CENTER_X + r) * stride_ + c] = values[r];
+            }
+        }
+        data_ = std::move(data);
+    }
+
+    ProjectionTable::ProjectionTable(const std::vector<Camera>& cams)
+        : ProjectionTable(cams.data(), cams.size()) {}
+
+    ProjectionTable::ProjectionTable(const DataSet& ds)
+        : ProjectionTable(ds.data(), ds.size()) {}
+
+    std::size_t ProjectionTable::size() const { return num_cams_; }
+
+    std::size_t ProjectionTable::getStride() const { return stride_; }
+
+    const float* ProjectionTable::getRow(const row r) const {
+        return data_.get() + static_cast<std::size_t>(r) * stride_;
+    }
+
+    void ProjectionTable::projectAll(const cv::Point3f& v, float* x,
+                                     float* y) const {
+
+        const auto P = data_.get();
+        const auto s = stride_;
+        for (std::size_t c = 0; c < num_cams_; ++c) {
+            const auto z = P[8 * s + c] * v.x + P[9 * s + c] * v.y +
+                           P[10 * s + c] * v.z + P[11 * s + c];
+            x[c] = (P[c] * v.x + P[s + c] * v.y + P[2 * s + c] * v.z +
+                    P[3 * s + c]) /
+                   z;
+            y[c] = (P[4 * s + c] * v.x + P[5 * s + c] * v.y +
+                    P[6 * s + c] * v.z + P[7 * s + c]) /
+                   z;
+        }
+    }
+
+    void ProjectionTable::dotDirections(const cv::Vec3d& normal,
+                                        double* dots) const {
+        dotDirections(normal, 0, num_cams_, dots);
+    }
+
+    void ProjectionTable::dotDirections(const cv::Vec3d& normal,
+                                        const std::size_t first,
+                                        const std::size_t count,
+                                        double* dots) const {
+
+        assert(first + count <= num_cams_);
+        const auto dir_x = getRow(DIR_X) + first;
+        const auto dir_y = getRow(DIR_Y) + first;
+        const auto dir_z = getRow(DIR_Z) + first;
+        for (std::size_t c = 0; c < count; ++c) {
+            dots[c] = normal[0] * dir_x[c] + normal[1] * dir_y[c] +
+                      normal[2] * dir_z[c];
+        }
+    }
+
+    cv::Point3d ProjectionTable::getCenter(const std::size_t cam_idx) const {
+        return cv::Point3d(*at(CENTER_X, cam_idx), *at(CENTER_Y, cam_idx),
+                           *at(CENTER_Z, cam_idx));
+    }
+
+    cv::Vec3d ProjectionTable::getDirection(const std::size_t cam_idx) const {
+        return cv::Vec3d(*at(DIR_X, cam_idx), *at(DIR_Y, cam_idx),
+                         *at(DIR_Z, cam_idx));
+    }
+} // namespace rendering
+} // namespace ret
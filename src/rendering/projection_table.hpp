@@ -0,0 +1,149 @@
+// Copyright (c) 2015-2016, Kai Wolf
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#ifndef RENDERING_PROJECTION_TABLE_HPP
+#define RENDERING_PROJECTION_TABLE_HPP
+
+#include <cassert>
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+#include <opencv2/core/core.hpp>
+
+namespace ret { class Camera; class DataSet; }
+
+namespace ret {
+
+namespace rendering {
+
+    /** @brief Projection matrices, centers and viewing directions of a
+      * camera set, stored as plain floats in structure-of-arrays layout.
+      * Each quantity is stored as one row over all cameras, which starts
+      * at a 32 byte boundary, such that looping over the cameras of a
+      * single point is vectorized. The table is built once and immutable
+      * afterwards, hence copies share the same storage and concurrent
+      * reads are safe */
+    class ProjectionTable {
+      public:
+        /** @brief Rows of the table. P00 ... P23 hold the projection
+          * matrix in row-major order */
+        enum row {
+            P00, P01, P02, P03,
+            P10, P11, P12, P13,
+            P20, P21, P22, P23,
+            CENTER_X, CENTER_Y, CENTER_Z,
+            DIR_X, DIR_Y, DIR_Z,
+            NUM_ROWS
+        };
+
+        /** @brief Creates an empty table */
+        ProjectionTable();
+
+        /** @param cams first camera of a contiguous range
+          * @param num_cams number of cameras */
+        ProjectionTable(const Camera* cams, const std::size_t num_cams);
+
+        explicit ProjectionTable(const std::vector<Camera>& cams);
+        explicit ProjectionTable(const DataSet& ds);
+
+        /** @brief Returns the number of cameras */
+        std::size_t size() const;
+
+        /** @brief Returns the distance between two rows in floats, which
+          * is a multiple of 8 */
+        std::size_t getStride() const;
+
+        /** @brief Returns the values of the given quantity for all
+          * cameras */
+        const float* getRow(const row r) const;
+
+        /** @brief Projects a point into the image of a camera. Computes
+          * in the precision of the point, hence the result equals
+          * @ref ret::project with the projection matrix of the camera
+          * @param cam_idx index of the camera
+          * @param v point with members x, y and z
+          * @return image coordinates */
+        template <typename coord, typename point>
+        coord project(const std::size_t cam_idx, const point& v) const;
+
+        /** @brief Projects a point into all cameras at once
+          * @param v point in world coordinates
+          * @param x receives size() image x coordinates
+          * @param y receives size() image y coordinates */
+        void projectAll(const cv::Point3f& v, float* x, float* y) const;
+
+        /** @brief Calculates the dot product of a normal with the viewing
+          * direction of every camera
+          * @param normal surface normal
+          * @param dots receives size() dot products */
+        void dotDirections(const cv::Vec3d& normal, double* dots) const;
+
+        /** @brief Calculates the dot products for a range of cameras
+          * only, e.g. in order to fill a fixed size buffer block by block
+          * @param normal surface normal
+          * @param first index of the first camera
+          * @param count number of cameras
+          * @param dots receives count dot products */
+        void dotDirections(const cv::Vec3d& normal, const std::size_t first,
+                           const std::size_t count, double* dots) const;
+
+        /** @brief Returns the center of a camera, see
+          * @ref Camera::getCenter */
+        cv::Point3d getCenter(const std::size_t cam_idx) const;
+
+        /** @brief Returns the viewing direction of a camera, see
+          * @ref Camera::getDirection */
+        cv::Vec3d getDirection(const std::size_t cam_idx) const;
+
+      private:
+        const float* at(const row r, const std::size_t cam_idx) const;
+
+        std::size_t num_cams_, stride_;
+        std::shared_ptr<const float> data_;
+    };
+
+    inline const float* ProjectionTable::at(const row r,
+                                            const std::size_t cam_idx) const {
+        assert(cam_idx < num_cams_);
+        return data_.get() + static_cast<std::size_t>(r) * stride_ + cam_idx;
+    }
+
+    template <typename coord, typename point>
+    coord ProjectionTable::project(const std::size_t cam_idx,
+                                   const point& v) const {
+
+        typedef decltype(v.x + 0.0f) T;
+        const auto P = at(P00, cam_idx);
+        const auto s = stride_;
+        const T z = P[8 * s] * v.x + P[9 * s] * v.y + P[10 * s] * v.z +
+                    P[11 * s];
+
+        coord im;
+        im.y = (P[4 * s] * v.x + P[5 * s] * v.y + P[6 * s] * v.z +
+                P[7 * s]) /
+               z;
+        im.x = (P[0] * v.x + P[s] * v.y + P[2 * s] * v.z + P[3 * s]) / z;
+        return im;
+    }
+} // namespace rendering
+} // namespace ret
+
+#endif
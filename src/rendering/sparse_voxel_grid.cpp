@@ -0,0 +1,162 @@
+// Copyright (c) 2015-2016, Kai Wolf
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "rendering/sparse_voxel_grid.hpp"
+
+#include <algorithm>
+#include <cassert>
+
+#include "common/utils.hpp"
+
+namespace ret {
+
+namespace rendering {
+
+    constexpr std::size_t SparseVoxelGrid::BRICK_SIZE;
+    constexpr std::size_t SparseVoxelGrid::BRICK_VOXELS;
+
+    SparseVoxelGrid::SparseVoxelGrid(const std::size_t voxel_dim,
+                                     const float value)
+        : voxel_dim_(voxel_dim),
+          brick_dim_((voxel_dim + BRICK_SIZE - 1) / BRICK_SIZE),
+          uniform_(brick_dim_ * brick_dim_ * brick_dim_, value),
+          bricks_(brick_dim_ * brick_dim_ * brick_dim_) {}
+
+    std::size_t SparseVoxelGrid::getVoxelDim() const { return voxel_dim_; }
+
+    std::size_t SparseVoxelGrid::getBrickDim() const { return brick_dim_; }
+
+    std::size_t SparseVoxelGrid::getBrickIdx(const std::size_t bi,
+                                             const std::size_t bj,
+                                             const std::size_t bk) const {
+
+        assert(bi < brick_dim_ && bj < brick_dim_ && bk < brick_dim_);
+        return bk + bj * brick_dim_ + bi * brick_dim_ * brick_dim_;
+    }
+
+    void SparseVoxelGrid::setUniform(const std::size_t brick,
+                                     const float value) {
+
+        assert(brick < uniform_.size());
+        bricks_[brick].reset();
+        uniform_[brick] = value;
+    }
+
+    float* SparseVoxelGrid::allocate(const std::size_t brick) {
+
+        assert(brick < uniform_.size());
+        if (not bricks_[brick]) {
+            bricks_[brick] = ret::make_unique<float[]>(BRICK_VOXELS);
+            std::fill_n(bricks_[brick].get(), BRICK_VOXELS, uniform_[brick]);
+        }
+        return bricks_[brick].get();
+    }
+
+    bool SparseVoxelGrid::isAllocated(const std::size_t brick) const {
+
+        assert(brick < uniform_.size());
+        return static_cast<bool>(bricks_[brick]);
+    }
+
+    const float* SparseVoxelGrid::getBrick(const std::size_t brick) const {
+
+        assert(brick < uniform_.size());
+        return bricks_[brick].get();
+    }
+
+    float* SparseVoxelGrid::getBrick(const std::size_t brick) {
+
+        assert(brick < uniform_.size());
+        return bricks_[brick].get();
+    }
+
+    float SparseVoxelGrid::getUniformValue(const std::size_t brick) const {
+
+        assert(brick < uniform_.size());
+        return uniform_[brick];
+    }
+
+    float SparseVoxelGrid::at(const std::size_t i, const std::size_t j,
+                              const std::size_t k) const {
+
+        assert(i < voxel_dim_ && j < voxel_dim_ && k < voxel_dim_);
+        const auto brick = getBrickIdx(i / BRICK_SIZE, j / BRICK_SIZE,
+                                       k / BRICK_SIZE);
+        const auto storage = getBrick(brick);
+        if (storage == nullptr) {
+            return uniform_[brick];
+        }
+
+        return storage[(k % BRICK_SIZE) +
+                       (j % BRICK_SIZE) * BRICK_SIZE +
+                       (i % BRICK_SIZE) * BRICK_SIZE * BRICK_SIZE];
+    }
+
+    void SparseVoxelGrid::copyBlock(const std::size_t i0, const std::size_t j0,
+                                    const std::size_t k0,
+                                    const std::size_t dim_i,
+                                    const std::size_t dim_j,
+                                    const std::size_t dim_k,
+                                    float* block) const {
+
+        assert(i0 + dim_i <= voxel_dim_ && j0 + dim_j <= voxel_dim_ &&
+               k0 + dim_k <= voxel_dim_);
+        for (auto i = i0; i < i0 + dim_i; ++i) {
+            for (auto j = j0; j < j0 + dim_j; ++j) {
+                // copy each row in runs of voxels sharing the same brick
+                auto k = k0;
+                while (k < k0 + dim_k) {
+                    const auto brick = getBrickIdx(
+                        i / BRICK_SIZE, j / BRICK_SIZE, k / BRICK_SIZE);
+                    const auto run = std::min(BRICK_SIZE - k % BRICK_SIZE,
+                                              k0 + dim_k - k);
+                    const auto storage = getBrick(brick);
+                    if (storage == nullptr) {
+                        std::fill_n(block, run, uniform_[brick]);
+                    } else {
+                        std::copy_n(storage + (k % BRICK_SIZE) +
+                                        (j % BRICK_SIZE) * BRICK_SIZE +
+                                        (i % BRICK_SIZE) * BRICK_SIZE *
+                                            BRICK_SIZE,
+                                    run, block);
+                    }
+                    block += run;
+                    k += run;
+                }
+            }
+        }
+    }
+
+    std::size_t SparseVoxelGrid::getNumAllocated() const {
+
+        return static_cast<std::size_t>(
+            std::count_if(bricks_.begin(), bricks_.end(),
+                          [](const std::unique_ptr<float[]>& storage) {
+                              return static_cast<bool>(storage);
+                          }));
+    }
+
+    std::size_t SparseVoxelGrid::getMemoryUsage() const {
+
+        return uniform_.size() * (sizeof(float) + sizeof(bricks_[0])) +
+               getNumAllocated() * BRICK_VOXELS * sizeof(float);
+    }
+} // namespace rendering
+} // namespace ret
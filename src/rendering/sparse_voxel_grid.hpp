@@ -0,0 +1,121 @@
+// Copyright (c) 2015-2016, Kai Wolf
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#ifndef RENDERING_SPARSE_VOXEL_GRID_HPP
+#define RENDERING_SPARSE_VOXEL_GRID_HPP
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+namespace ret {
+
+namespace rendering {
+
+    /** @brief Voxel grid of dimension voxel_dim^3, which is partitioned
+      * into bricks of BRICK_SIZE^3 voxels. Only bricks which have been
+      * allocated explicitly store a value per voxel, every other brick is
+      * represented by a single uniform value. Within an allocated brick the
+      * voxel (i, j, k) is stored at k + j * BRICK_SIZE + i * BRICK_SIZE^2,
+      * i.e. in the same order as in the dense @ref VoxelCarving grid */
+    class SparseVoxelGrid {
+      public:
+        static constexpr std::size_t BRICK_SIZE = 8;
+        static constexpr std::size_t BRICK_VOXELS =
+            BRICK_SIZE * BRICK_SIZE * BRICK_SIZE;
+
+        /** @brief Creates a voxel grid where each brick is uniform
+          * @param voxel_dim Dimension of the voxel grid
+          * @param value initial value of every voxel */
+        SparseVoxelGrid(const std::size_t voxel_dim, const float value);
+
+        SparseVoxelGrid(SparseVoxelGrid const&)            = delete;
+        SparseVoxelGrid operator&=(SparseVoxelGrid const&) = delete;
+
+        /** @brief Returns the dimension of the voxel grid in each direction
+          * @return voxel grid dimension */
+        std::size_t getVoxelDim() const;
+
+        /** @brief Returns the number of bricks in each direction
+          * @return brick grid dimension */
+        std::size_t getBrickDim() const;
+
+        /** @brief Returns the index of the brick at (bi, bj, bk), which is
+          * bk + bj * brick_dim + bi * brick_dim^2 */
+        std::size_t getBrickIdx(const std::size_t bi, const std::size_t bj,
+                                const std::size_t bk) const;
+
+        /** @brief Sets all voxels of a brick to the same value and releases
+          * its storage, if any. May be called concurrently for distinct
+          * bricks
+          * @param brick index of the brick */
+        void setUniform(const std::size_t brick, const float value);
+
+        /** @brief Allocates storage for a brick, which is initialized with
+          * its uniform value. May be called concurrently for distinct
+          * bricks
+          * @param brick index of the brick
+          * @return storage of BRICK_VOXELS values */
+        float* allocate(const std::size_t brick);
+
+        /** @brief Returns whether a brick stores a value per voxel
+          * @param brick index of the brick */
+        bool isAllocated(const std::size_t brick) const;
+
+        /** @brief Returns the storage of an allocated brick
+          * @param brick index of the brick
+          * @return storage of BRICK_VOXELS values or nullptr, if the brick
+          * is uniform */
+        const float* getBrick(const std::size_t brick) const;
+        float* getBrick(const std::size_t brick);
+
+        /** @brief Returns the value of a uniform brick
+          * @param brick index of the brick */
+        float getUniformValue(const std::size_t brick) const;
+
+        /** @brief Returns the value of the voxel (i, j, k) */
+        float at(const std::size_t i, const std::size_t j,
+                 const std::size_t k) const;
+
+        /** @brief Copies a block of voxels starting at (i0, j0, k0) into a
+          * dense array, in which voxel (i0 + i, j0 + j, k0 + k) is stored
+          * at k + j * dim_k + i * dim_k * dim_j
+          * @param block destination of dim_i * dim_j * dim_k values */
+        void copyBlock(const std::size_t i0, const std::size_t j0,
+                       const std::size_t k0, const std::size_t dim_i,
+                       const std::size_t dim_j, const std::size_t dim_k,
+                       float* block) const;
+
+        /** @brief Returns the number of allocated bricks */
+        std::size_t getNumAllocated() const;
+
+        /** @brief Returns the number of bytes used by the voxel grid */
+        std::size_t getMemoryUsage() const;
+
+      private:
+        std::size_t voxel_dim_, brick_dim_;
+        std::vector<float> uniform_;
+        /** storage of each brick or nullptr for uniform bricks */
+        std::vector<std::unique_ptr<float[]>> bricks_;
+    };
+} // namespace rendering
+} // namespace ret
+
+#endif
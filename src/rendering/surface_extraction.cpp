@@ -0,0 +1,331 @@
+// Copyright (c) 2015-2016, Kai Wolf
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "rendering/surface_extraction.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <utility>
+
+#include <vtkCellArray.h>
+#include <vtkCleanPolyData.h>
+#include <vtkFloatArray.h>
+#include <vtkIdTypeArray.h>
+#include <vtkPointData.h>
+#include <vtkPoints.h>
+#include <vtkPolyData.h>
+#include <vtkPolyDataNormals.h>
+#include <vtkType.h>
+#include <vtkVersion.h>
+
+#include "common/parallel.hpp"
+#include "rendering/mc/marching_cubes.hpp"
+
+namespace ret {
+
+namespace rendering {
+
+    template <typename T>
+    void ExtractSurface(const T* block, const std::size_t dim_i,
+                        const std::size_t dim_j, const std::size_t dim_k,
+                        const start_params& params, const float isolevel,
+                        std::vector<triangle>& triangles,
+                        const std::size_t num_threads) {
+
+        if (dim_i < 2 || dim_j < 2 || dim_k < 2) {
+            return;
+        }
+
+        // marching cubes expects x + z * dim_x + y * dim_x * dim_z, hence
+        // the y- and z-axis of the voxel grid are passed in swapped order
+        mc::MarchingCubes mc(
+            params.start_x, params.start_z, params.start_y, params.voxel_width,
+            params.voxel_depth, params.voxel_height, isolevel,
+            static_cast<mc::int_type>(dim_k), static_cast<mc::int_type>(dim_i),
+            static_cast<mc::int_type>(dim_j));
+        mc.setNumThreads(num_threads);
+        mc.execute(block);
+
+        // swapping back y and z mirrors each triangle, which turns the
+        // clockwise output of marching cubes into counter-clockwise
+        triangles.reserve(triangles.size() + mc.getTriangles().size());
+        for (auto tri : mc.getTriangles()) {
+            std::swap(tri.comp.v1.y, tri.comp.v1.z);
+            std::swap(tri.comp.v2.y, tri.comp.v2.z);
+            std::swap(tri.comp.v3.y, tri.comp.v3.z);
+            triangles.push_back(tri);
+        }
+    }
+
+    template void ExtractSurface<float>(const float*, const std::size_t,
+                                        const std::size_t, const std::size_t,
+                                        const start_params&, const float,
+                                        std::vector<triangle>&,
+                                        const std::size_t);
+    template void ExtractSurface<half>(const half*, const std::size_t,
+                                       const std::size_t, const std::size_t,
+                                       const start_params&, const float,
+                                       std::vector<triangle>&,
+                                       const std::size_t);
+    template void ExtractSurface<q15>(const q15*, const std::size_t,
+                                      const std::size_t, const std::size_t,
+                                      const start_params&, const float,
+                                      std::vector<triangle>&,
+                                      const std::size_t);
+
+    template <typename T>
+    void ExtractIndexedSurface(const T* block, const std::size_t dim_i,
+                               const std::size_t dim_j,
+                               const std::size_t dim_k,
+                               const start_params& params,
+                               const float isolevel,
+                               std::vector<vec3f>& vertices,
+                               std::vector<vec3f>& normals,
+                               std::vector<std::uint32_t>& indices,
+                               const std::size_t num_threads) {
+
+        vertices.clear();
+        normals.clear();
+        indices.clear();
+        if (dim_i < 2 || dim_j < 2 || dim_k < 2) {
+            return;
+        }
+
+        // see ExtractSurface for the swapped axes
+        mc::MarchingCubes mc(
+            params.start_x, params.start_z, params.start_y, params.voxel_width,
+            params.voxel_depth, params.voxel_height, isolevel,
+            static_cast<mc::int_type>(dim_k), static_cast<mc::int_type>(dim_i),
+            static_cast<mc::int_type>(dim_j));
+        mc.setNumThreads(num_threads);
+        mc.executeIndexed(block);
+
+        auto swap_yz = [](vec3f v) {
+            std::swap(v.y, v.z);
+            return v;
+        };
+        vertices.resize(mc.getVertices().size());
+        std::transform(mc.getVertices().begin(), mc.getVertices().end(),
+                       vertices.begin(), swap_yz);
+        normals.resize(mc.getNormals().size());
+        std::transform(mc.getNormals().begin(), mc.getNormals().end(),
+                       normals.begin(), swap_yz);
+        indices = mc.getIndices();
+    }
+
+    template void ExtractIndexedSurface<float>(
+        const float*, const std::size_t, const std::size_t, const std::size_t,
+        const start_params&, const float, std::vector<vec3f>&,
+        std::vector<vec3f>&, std::vector<std::uint32_t>&, const std::size_t);
+    template void ExtractIndexedSurface<half>(
+        const half*, const std::size_t, const std::size_t, const std::size_t,
+        const start_params&, const float, std::vector<vec3f>&,
+        std::vector<vec3f>&, std::vector<std::uint32_t>&, const std::size_t);
+    template void ExtractIndexedSurface<q15>(
+        const q15*, const std::size_t, const std::size_t, const std::size_t,
+        const start_params&, const float, std::vector<vec3f>&,
+        std::vector<vec3f>&, std::vector<std::uint32_t>&, const std::size_t);
+
+    void ExtractIndexedSurface(const VoxelGrid& grid, const float isolevel,
+                               std::vector<vec3f>& vertices,
+                               std::vector<vec3f>& normals,
+                               std::vector<std::uint32_t>& indices,
+                               const std::size_t num_threads) {
+
+        assert(!grid.empty());
+        const auto dim    = grid.getVoxelDim();
+        const auto params = grid.getStartParams();
+        switch (grid.getVoxelType()) {
+            case voxel_type::Half:
+                ExtractIndexedSurface(grid.getVoxels<half>(), dim, dim, dim,
+                                      params, isolevel, vertices, normals,
+                                      indices, num_threads);
+                break;
+            case voxel_type::Q15:
+                ExtractIndexedSurface(grid.getVoxels<q15>(), dim, dim, dim,
+                                      params, isolevel, vertices, normals,
+                                      indices, num_threads);
+                break;
+            default:
+                ExtractIndexedSurface(grid.getVoxels<float>(), dim, dim, dim,
+                                      params, isolevel, vertices, normals,
+                                      indices, num_threads);
+        }
+    }
+
+    void ExtractSurface(const SparseVoxelGrid& grid,
+                        const start_params& params, const float isolevel,
+                        const std::size_t num_threads,
+                        std::vector<triangle>& triangles) {
+
+        constexpr auto B     = SparseVoxelGrid::BRICK_SIZE;
+        const auto voxel_dim = grid.getVoxelDim();
+        const auto brick_dim = grid.getBrickDim();
+
+        // the cubes starting within a brick reach into the next brick
+        // along each axis, thus a brick is visited if any of these eight
+        // bricks is allocated
+        std::vector<std::size_t> bricks;
+        for (std::size_t bi = 0; bi < brick_dim; ++bi) {
+            for (std::size_t bj = 0; bj < brick_dim; ++bj) {
+                for (std::size_t bk = 0; bk < brick_dim; ++bk) {
+                    auto visit = false;
+                    for (auto n = 0; n < 8 && not visit; ++n) {
+                        const auto ni = bi + (n >> 2 & 1);
+                        const auto nj = bj + (n >> 1 & 1);
+                        const auto nk = bk + (n & 1);
+                        visit = ni < brick_dim && nj < brick_dim &&
+                                nk < brick_dim &&
+                                grid.isAllocated(grid.getBrickIdx(ni, nj, nk));
+                    }
+                    if (visit) {
+                        bricks.push_back(grid.getBrickIdx(bi, bj, bk));
+                    }
+                }
+            }
+        }
+
+        std::vector<std::vector<triangle>> brick_triangles(bricks.size());
+        ParallelFor(
+            0, bricks.size(), num_threads,
+            [&](const std::size_t begin, const std::size_t end) {
+                std::vector<float> block((B + 1) * (B + 1) * (B + 1));
+                for (auto idx = begin; idx < end; ++idx) {
+                    const auto brick = bricks[idx];
+                    const auto i0    = brick / (brick_dim * brick_dim) * B;
+                    const auto j0    = (brick / brick_dim) % brick_dim * B;
+                    const auto k0    = brick % brick_dim * B;
+                    const auto dim_i = std::min(B + 1, voxel_dim - i0);
+                    const auto dim_j = std::min(B + 1, voxel_dim - j0);
+                    const auto dim_k = std::min(B + 1, voxel_dim - k0);
+                    grid.copyBlock(i0, j0, k0, dim_i, dim_j, dim_k,
+                                   block.data());
+
+                    auto origin = params;
+                    origin.start_x +=
+                        static_cast<float>(k0) * params.voxel_width;
+                    origin.start_y +=
+                        static_cast<float>(j0) * params.voxel_height;
+                    origin.start_z +=
+                        static_cast<float>(i0) * params.voxel_depth;
+                    ExtractSurface(block.data(), dim_i, dim_j, dim_k, origin,
+                                   isolevel, brick_triangles[idx]);
+                }
+            });
+
+        for (const auto& tris : brick_triangles) {
+            triangles.insert(triangles.end(), tris.begin(), tris.end());
+        }
+    }
+
+    vtkSmartPointer<vtkPolyData> CreatePolyData(
+        const std::vector<triangle>& triangles, const double merge_tolerance) {
+
+        assert(merge_tolerance >= 0.0);
+
+        auto points = vtkSmartPointer<vtkPoints>::New();
+        points->SetDataTypeToFloat();
+        points->SetNumberOfPoints(
+            static_cast<vtkIdType>(3 * triangles.size()));
+        auto polys = vtkSmartPointer<vtkCellArray>::New();
+
+        vtkIdType idx = 0;
+        for (const auto& tri : triangles) {
+            points->SetPoint(idx, tri.comp.v1.x, tri.comp.v1.y, tri.comp.v1.z);
+            points->SetPoint(idx + 1, tri.comp.v2.x, tri.comp.v2.y,
+                             tri.comp.v2.z);
+            points->SetPoint(idx + 2, tri.comp.v3.x, tri.comp.v3.y,
+                             tri.comp.v3.z);
+            const vtkIdType ids[3] = {idx, idx + 1, idx + 2};
+            polys->InsertNextCell(3, ids);
+            idx += 3;
+        }
+
+        auto soup = vtkSmartPointer<vtkPolyData>::New();
+        soup->SetPoints(points);
+        soup->SetPolys(polys);
+
+        // neighboring cubes compute shared vertices independently
+        auto clean = vtkSmartPointer<vtkCleanPolyData>::New();
+#if VTK_MAJOR_VERSION < 6
+        clean->SetInput(soup);
+#else
+        clean->SetInputData(soup);
+#endif
+        clean->PointMergingOn();
+        clean->ToleranceIsAbsoluteOn();
+        clean->SetAbsoluteTolerance(merge_tolerance);
+
+        auto surface_normals = vtkSmartPointer<vtkPolyDataNormals>::New();
+        surface_normals->SetInputConnection(clean->GetOutputPort());
+        surface_normals->SetFeatureAngle(60.0);
+        surface_normals->ComputePointNormalsOn();
+        surface_normals->Update();
+
+        return surface_normals->GetOutput();
+    }
+
+    vtkSmartPointer<vtkPolyData> CreatePolyData(
+        const std::vector<vec3f>& vertices, const std::vector<vec3f>& normals,
+        const std::vector<std::uint32_t>& indices) {
+
+        static_assert(sizeof(vec3f) == 3 * sizeof(float),
+                      "vec3f must be three packed floats");
+        assert(vertices.size() == normals.size());
+        assert(indices.size() % 3 == 0);
+
+        const auto num_points = static_cast<vtkIdType>(vertices.size());
+        auto coords = vtkSmartPointer<vtkFloatArray>::New();
+        coords->SetNumberOfComponents(3);
+        coords->SetNumberOfTuples(num_points);
+        std::copy_n(reinterpret_cast<const float*>(vertices.data()),
+                    3 * vertices.size(), coords->GetPointer(0));
+        auto points = vtkSmartPointer<vtkPoints>::New();
+        points->SetData(coords);
+
+        auto point_normals = vtkSmartPointer<vtkFloatArray>::New();
+        point_normals->SetName("Normals");
+        point_normals->SetNumberOfComponents(3);
+        point_normals->SetNumberOfTuples(num_points);
+        std::copy_n(reinterpret_cast<const float*>(normals.data()),
+                    3 * normals.size(), point_normals->GetPointer(0));
+
+        // legacy cell layout: number of points followed by the point ids
+        const auto num_cells = static_cast<vtkIdType>(indices.size() / 3);
+        auto cell_ids        = vtkSmartPointer<vtkIdTypeArray>::New();
+        cell_ids->SetNumberOfValues(4 * num_cells);
+        auto ids = cell_ids->GetPointer(0);
+        for (std::size_t idx = 0; idx < indices.size(); idx += 3) {
+            *ids++ = 3;
+            *ids++ = static_cast<vtkIdType>(indices[idx]);
+            *ids++ = static_cast<vtkIdType>(indices[idx + 1]);
+            *ids++ = static_cast<vtkIdType>(indices[idx + 2]);
+        }
+        auto polys = vtkSmartPointer<vtkCellArray>::New();
+        polys->SetCells(num_cells, cell_ids);
+
+        auto mesh = vtkSmartPointer<vtkPolyData>::New();
+        mesh->SetPoints(points);
+        mesh->SetPolys(polys);
+        mesh->GetPointData()->SetNormals(point_normals);
+        return mesh;
+    }
+} // namespace rendering
+} // namespace ret
@@ -0,0 +1,143 @@
+// Copyright (c) 2015-2016, Kai Wolf
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#ifndef RENDERING_SURFACE_EXTRACTION_HPP
+#define RENDERING_SURFACE_EXTRACTION_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <vtkSmartPointer.h>
+
+#include "common/types/triangle.hpp"
+#include "common/types/vec3f.hpp"
+#include "rendering/sparse_voxel_grid.hpp"
+#include "rendering/voxel_grid.hpp"
+#include "rendering/voxel_type.hpp"
+
+class vtkPolyData;
+
+namespace ret {
+
+namespace rendering {
+
+    /** @brief Extracts the iso surface from a block of voxels using the
+      * in-tree marching cubes implementation. The block is stored in the
+      * same layout as the carved voxel grid, i.e. voxel (i, j, k) is found
+      * at k + j * dim_k + i * dim_k * dim_j. The resulting triangles are
+      * appended in world coordinates and wound counter-clockwise when
+      * seen from the side of the lower values, i.e. from outside of the
+      * visual hull. Implemented for blocks of float, @ref half and
+      * @ref q15 voxels
+      * @param block voxel values
+      * @param dim_i number of voxels along the z-axis
+      * @param dim_j number of voxels along the y-axis
+      * @param dim_k number of voxels along the x-axis
+      * @param params world position of voxel (0, 0, 0) and voxel size
+      * @param isolevel threshold used for surface extraction
+      * @param triangles extracted triangles are appended here
+      * @param num_threads number of threads, see
+      * @ref mc::MarchingCubes::setNumThreads */
+    template <typename T>
+    void ExtractSurface(const T* block, const std::size_t dim_i,
+                        const std::size_t dim_j, const std::size_t dim_k,
+                        const start_params& params, const float isolevel,
+                        std::vector<triangle>& triangles,
+                        const std::size_t num_threads = 1);
+
+    /** @brief Extracts the iso surface from a block of voxels as indexed
+      * mesh, see @ref mc::MarchingCubes::executeIndexed. Layout,
+      * coordinates and winding are the same as for @ref ExtractSurface.
+      * Implemented for blocks of float, @ref half and @ref q15 voxels
+      * @param block voxel values
+      * @param dim_i number of voxels along the z-axis
+      * @param dim_j number of voxels along the y-axis
+      * @param dim_k number of voxels along the x-axis
+      * @param params world position of voxel (0, 0, 0) and voxel size
+      * @param isolevel threshold used for surface extraction
+      * @param vertices replaced by the vertices in world coordinates
+      * @param normals replaced by the vertex normals, pointing outwards
+      * @param indices replaced by three vertex indices per triangle
+      * @param num_threads number of threads, see
+      * @ref mc::MarchingCubes::setNumThreads */
+    template <typename T>
+    void ExtractIndexedSurface(const T* block, const std::size_t dim_i,
+                               const std::size_t dim_j,
+                               const std::size_t dim_k,
+                               const start_params& params,
+                               const float isolevel,
+                               std::vector<vec3f>& vertices,
+                               std::vector<vec3f>& normals,
+                               std::vector<std::uint32_t>& indices,
+                               const std::size_t num_threads = 1);
+
+    /** @brief Extracts the iso surface from a dense voxel grid of any
+      * element type as indexed mesh, see @ref ExtractIndexedSurface
+      * @param grid voxel grid, must not be empty
+      * @param isolevel threshold used for surface extraction
+      * @param vertices replaced by the vertices in world coordinates
+      * @param normals replaced by the vertex normals, pointing outwards
+      * @param indices replaced by three vertex indices per triangle
+      * @param num_threads number of threads, see
+      * @ref mc::MarchingCubes::setNumThreads */
+    void ExtractIndexedSurface(const VoxelGrid& grid, const float isolevel,
+                               std::vector<vec3f>& vertices,
+                               std::vector<vec3f>& normals,
+                               std::vector<std::uint32_t>& indices,
+                               const std::size_t num_threads = 1);
+
+    /** @brief Extracts the iso surface from a sparse voxel grid. Only the
+      * cubes with at least one corner within an allocated brick are
+      * visited, hence the surface must not pass between two voxels of
+      * uniform bricks
+      * @param grid sparse voxel grid
+      * @param params world position of voxel (0, 0, 0) and voxel size
+      * @param isolevel threshold used for surface extraction
+      * @param num_threads number of threads used for extraction
+      * @param triangles extracted triangles are appended here, in the
+      * same order for any number of threads */
+    void ExtractSurface(const SparseVoxelGrid& grid,
+                        const start_params& params, const float isolevel,
+                        const std::size_t num_threads,
+                        std::vector<triangle>& triangles);
+
+    /** @brief Creates a mesh from a set of triangles. Vertices closer
+      * than the given tolerance are merged and point normals are
+      * calculated the same way as for @ref VoxelCarving::createVisualHull
+      * @param triangles triangles in world coordinates
+      * @param merge_tolerance absolute tolerance for merging vertices
+      * @return mesh with point normals */
+    vtkSmartPointer<vtkPolyData> CreatePolyData(
+        const std::vector<triangle>& triangles, const double merge_tolerance);
+
+    /** @brief Creates a mesh from an indexed mesh. The arrays are copied
+      * into the mesh as they are, without running any vtk filter
+      * @param vertices vertices in world coordinates
+      * @param normals vertex normals
+      * @param indices three vertex indices per triangle
+      * @return mesh with point normals */
+    vtkSmartPointer<vtkPolyData> CreatePolyData(
+        const std::vector<vec3f>& vertices, const std::vector<vec3f>& normals,
+        const std::vector<std::uint32_t>& indices);
+} // namespace rendering
+} // namespace ret
+
+#endif
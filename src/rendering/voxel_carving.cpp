@@ -21,40 +21,154 @@
 #include "rendering/voxel_carving.hpp"
 
 #include <algorithm>
+#include <cassert>
 #include <cmath>
+#include <cstdint>
 #include <limits>
+#include <stdexcept>
 
+#include <boost/filesystem.hpp>
 #include <opencv2/core/types_c.h>
 #include <opencv2/core/mat.hpp>
 #include <opencv2/core/operations.hpp>
-#include <vtkFloatArray.h>
 #include <vtkMarchingCubes.h>
-#include <vtkPointData.h>
 #include <vtkPolyData.h>
 #include <vtkPolyDataNormals.h>
 #include <vtkStructuredPoints.h>
-#include <vtkType.h>
 #include <vtkVersion.h>
 
 #include "common/camera.hpp"
+#include "common/parallel.hpp"
 #include "common/utils.hpp"
-#include "filtering/segmentation.hpp"
-#include "rendering/cv_utils.hpp"
+#include "common/types/triangle.hpp"
+#include "common/types/vec3f.hpp"
+#include "filtering/dist_map_cache.hpp"
+#include "filtering/preprocessing.hpp"
+#include "rendering/surface_extraction.hpp"
+#include "rendering/voxel_carving_kernel.hpp"
 
 namespace ret {
 
 namespace rendering {
 
+    namespace {
+        const std::pair<float, float> DEFAULT_BB_MARGIN(0.10f, 0.10f);
+        const std::size_t DEFAULT_VIEW_MEMORY_LIMIT = 64u << 20;
+
+        template <typename T>
+        void FillVoxels(VoxelGrid& grid, const float value) {
+            std::fill_n(grid.getVoxels<T>(), grid.getNumVoxels(),
+                        FloatToVoxel<T>(value));
+        }
+
+        void FillGrid(VoxelGrid& grid, const float value) {
+            switch (grid.getVoxelType()) {
+                case voxel_type::Half:
+                    FillVoxels<half>(grid, value);
+                    break;
+                case voxel_type::Q15:
+                    FillVoxels<q15>(grid, value);
+                    break;
+                default:
+                    FillVoxels<float>(grid, value);
+            }
+        }
+
+        template <typename T>
+        void CopyVoxels(const VoxelGrid& grid, const std::size_t i0,
+                        const std::size_t j0, const std::size_t k0,
+                        const std::size_t dim_i, const std::size_t dim_j,
+                        const std::size_t dim_k, float* block) {
+
+            const auto voxels    = grid.getVoxels<T>();
+            const auto voxel_dim = grid.getVoxelDim();
+            for (auto i = i0; i < i0 + dim_i; ++i) {
+                for (auto j = j0; j < j0 + dim_j; ++j) {
+                    const auto row =
+                        voxels + k0 + j * voxel_dim + i * voxel_dim * voxel_dim;
+                    block = std::transform(
+                        row, row + dim_k, block,
+                        [](const T value) { return VoxelToFloat(value); });
+                }
+            }
+        }
+    } // namespace
+
+    VoxelCarving::VoxelCarving(const bb_bounds bbox,
+                               const std::size_t voxel_dim,
+                               const float narrow_band)
+        : VoxelCarving(bbox, voxel_dim, narrow_band, voxel_type::Float) {}
+
     VoxelCarving::VoxelCarving(const bb_bounds bbox,
-                               const std::size_t voxel_dim)
+                               const std::size_t voxel_dim,
+                               const voxel_type type)
+        : VoxelCarving(bbox, voxel_dim, 0.0f, type) {}
+
+    VoxelCarving::VoxelCarving(const bb_bounds bbox,
+                               const std::size_t voxel_dim,
+                               const float narrow_band, const voxel_type type)
         : voxel_dim_(voxel_dim),
           voxel_slice_(voxel_dim * voxel_dim),
           voxel_size_(voxel_dim * voxel_dim * voxel_dim),
-          vox_array_(ret::make_unique<float[]>(voxel_size_)),
-          params_(calcStartParameter(bbox)),
-          bb_margin_(std::make_pair(0.10f, 0.10f)) {
-        std::fill_n(vox_array_.get(), voxel_size_,
-                    std::numeric_limits<float>::max());
+          num_threads_(HardwareConcurrency()),
+          view_memory_limit_(DEFAULT_VIEW_MEMORY_LIMIT),
+          narrow_band_(narrow_band),
+          type_(type),
+          backend_(surface_backend::Vtk),
+          grid_(),
+          band_grid_(),
+          bb_margin_(DEFAULT_BB_MARGIN),
+          params_(CalcStartParameter(bbox, voxel_dim_, bb_margin_)),
+          dist_cache_(),
+          grid_file_() {
+
+        assert(narrow_band >= 0.0f);
+        if (narrow_band_ > 0.0f) {
+            band_grid_ =
+                ret::make_unique<SparseVoxelGrid>(voxel_dim_, narrow_band_);
+            return;
+        }
+
+        grid_ = VoxelGrid(voxel_dim_, type_, params_);
+        FillGrid(grid_, std::numeric_limits<float>::max());
+    }
+
+    VoxelCarving::VoxelCarving(const bb_bounds bbox,
+                               const std::size_t voxel_dim,
+                               const voxel_type type,
+                               const std::string& filename)
+        : VoxelCarving(
+              CreateMappedVoxelGrid(
+                  filename, voxel_dim, type,
+                  CalcStartParameter(bbox, voxel_dim, DEFAULT_BB_MARGIN)),
+              filename) {
+
+        FillGrid(grid_, std::numeric_limits<float>::max());
+    }
+
+    VoxelCarving::VoxelCarving(const std::string& filename)
+        : VoxelCarving(MapVoxelGrid(filename), filename) {}
+
+    VoxelCarving::VoxelCarving(VoxelGrid grid, std::string grid_file)
+        : voxel_dim_(grid.getVoxelDim()),
+          voxel_slice_(voxel_dim_ * voxel_dim_),
+          voxel_size_(voxel_dim_ * voxel_dim_ * voxel_dim_),
+          num_threads_(HardwareConcurrency()),
+          view_memory_limit_(DEFAULT_VIEW_MEMORY_LIMIT),
+          narrow_band_(0.0f),
+          type_(grid.getVoxelType()),
+          backend_(surface_backend::Vtk),
+          grid_(std::move(grid)),
+          band_grid_(),
+          bb_margin_(DEFAULT_BB_MARGIN),
+          params_(grid_.getStartParams()),
+          dist_cache_(),
+          grid_file_(std::move(grid_file)) {
+
+        if (grid_.empty()) {
+            throw std::runtime_error("Cannot map voxel grid file " +
+                                     grid_file_);
+        }
     }
 
     template <typename T>
@@ -62,31 +176,204 @@ namespace rendering {
         return z + y * dim + x * slice;
     }
 
+    template <typename T>
+    void VoxelCarving::carveSlab(const std::vector<carve_view>& views,
+                                 T* grid, const std::size_t i_begin,
+                                 const std::size_t i_end) {
+
+        // each row is carved in float precision and rounded once per call
+        std::vector<float> row(voxel_dim_);
+        for (auto i = i_begin; i < i_end; ++i) {
+            for (std::size_t j = 0; j < voxel_dim_; ++j) {
+                auto voxels = grid + voxelIdx<std::size_t>(i, j, 0, voxel_dim_,
+                                                           voxel_slice_);
+                std::transform(
+                    voxels, voxels + voxel_dim_, row.begin(),
+                    [](const T value) { return VoxelToFloat(value); });
+                for (const auto& view : views) {
+                    CarveRow(view, params_, i, j, 0, voxel_dim_, row.data());
+                }
+                std::transform(
+                    row.begin(), row.end(), voxels,
+                    [](const float value) { return FloatToVoxel<T>(value); });
+            }
+        }
+    }
+
+    template <>
+    void VoxelCarving::carveSlab<float>(const std::vector<carve_view>& views,
+                                        float* grid, const std::size_t i_begin,
+                                        const std::size_t i_end) {
+
+        // a single row stays in L1 cache while it is carved by all views
+        for (auto i = i_begin; i < i_end; ++i) {
+            for (std::size_t j = 0; j < voxel_dim_; ++j) {
+                auto row = grid + voxelIdx<std::size_t>(i, j, 0, voxel_dim_,
+                                                        voxel_slice_);
+                for (const auto& view : views) {
+                    CarveRow(view, params_, i, j, 0, voxel_dim_, row);
+                }
+            }
+        }
+    }
+
     void VoxelCarving::carve(const Camera& cam) {
 
-        const auto Mask      = cam.getMask();
-        const auto DistImage = filtering::CreateDistMap(Mask);
-        const auto img_size  = Mask.size();
-
-        std::size_t i, j, k;
-        for (i = 0; i < voxel_dim_; ++i) {
-            for (j = 0; j < voxel_dim_; ++j) {
-                for (k = 0; k < voxel_dim_; ++k) {
-
-                    auto voxel = calcVoxelPosInCamViewFrustum(i, j, k);
-                    auto coord = project<cv::Point2f, cv::Point3f>(cam, voxel);
-                    auto dist  = -1.0f;
-                    if (inside(coord, img_size)) {
-                        dist = DistImage.at<float>(coord);
-                        if (not(Mask.at<uchar>(coord) == 0u)) { // outside
-                            dist *= -1.0f;
+        const auto& Mask     = cam.getMask();
+        const auto DistImage = filtering::GetDistMap(cam, dist_cache_.get());
+        const std::vector<carve_view> views = {
+            CreateCarveView(cam.getProjectionMatrix(), Mask, DistImage)};
+        carveViews(views);
+    }
+
+    void VoxelCarving::carveAll(const std::vector<Camera>& cams) {
+
+        // the views of a batch are reused by the next one, thus at most
+        // view_memory_limit_ bytes of camera data are held at once
+        std::vector<carve_view> views;
+        std::size_t first = 0;
+        while (first < cams.size()) {
+            auto last        = first;
+            std::size_t size = 0;
+            do {
+                size += cams[last].getMask().total() * sizeof(float);
+                ++last;
+            } while (last < cams.size() &&
+                     size + cams[last].getMask().total() * sizeof(float) <=
+                         view_memory_limit_);
+
+            // the distance transform dominates the per camera setup, hence
+            // the views are created in parallel as well
+            views.resize(last - first);
+            ParallelFor(
+                first, last, num_threads_,
+                [&](const std::size_t c_begin, const std::size_t c_end) {
+                    for (auto c = c_begin; c < c_end; ++c) {
+                        CreateCarveView(cams[c].getProjectionMatrix(),
+                                        cams[c].getMask(),
+                                        filtering::GetDistMap(
+                                            cams[c], dist_cache_.get()),
+                                        views[c - first]);
+                    }
+                });
+            carveViews(views);
+            first = last;
+        }
+    }
+
+    void VoxelCarving::carveViews(const std::vector<carve_view>& views) {
+
+        // every slab along i is owned by exactly one thread, thus no
+        // synchronization is needed when writing to the voxel grid
+        if (band_grid_) {
+            ParallelFor(
+                0, band_grid_->getBrickDim(), num_threads_,
+                [&](const std::size_t bi_begin, const std::size_t bi_end) {
+                    carveBricks(views, bi_begin, bi_end);
+                });
+            return;
+        }
+
+        ParallelFor(0, voxel_dim_, num_threads_,
+                    [&](const std::size_t i_begin, const std::size_t i_end) {
+                        switch (type_) {
+                            case voxel_type::Half:
+                                carveSlab(views, grid_.getVoxels<half>(),
+                                          i_begin, i_end);
+                                break;
+                            case voxel_type::Q15:
+                                carveSlab(views, grid_.getVoxels<q15>(),
+                                          i_begin, i_end);
+                                break;
+                            default:
+                                carveSlab(views, grid_.getVoxels<float>(),
+                                          i_begin, i_end);
+                        }
+                    });
+    }
+
+    void VoxelCarving::carveBricks(const std::vector<carve_view>& views,
+                                   const std::size_t bi_begin,
+                                   const std::size_t bi_end) {
+
+        constexpr auto B     = SparseVoxelGrid::BRICK_SIZE;
+        const auto brick_dim = band_grid_->getBrickDim();
+        float block[SparseVoxelGrid::BRICK_VOXELS];
+        for (auto bi = bi_begin; bi < bi_end; ++bi) {
+            for (std::size_t bj = 0; bj < brick_dim; ++bj) {
+                for (std::size_t bk = 0; bk < brick_dim; ++bk) {
+
+                    const auto brick = band_grid_->getBrickIdx(bi, bj, bk);
+                    auto storage     = band_grid_->getBrick(brick);
+                    const auto value = band_grid_->getUniformValue(brick);
+                    if (storage == nullptr && value <= -narrow_band_) {
+                        // carving only lowers the distances, hence a brick
+                        // outside of the band stays outside
+                        continue;
+                    }
+                    if (storage == nullptr) {
+                        std::fill_n(block, SparseVoxelGrid::BRICK_VOXELS,
+                                    value);
+                    } else {
+                        std::copy_n(storage, SparseVoxelGrid::BRICK_VOXELS,
+                                    block);
+                    }
+
+                    // a brick is carved by one view after another, until
+                    // it lies completely outside of the band
+                    const auto k_begin = bk * B;
+                    const auto k_end   = std::min(k_begin + B, voxel_dim_);
+                    const auto i_end   = std::min(B, voxel_dim_ - bi * B);
+                    const auto j_end   = std::min(B, voxel_dim_ - bj * B);
+                    for (const auto& view : views) {
+                        auto outside = true;
+                        for (std::size_t li = 0; li < i_end; ++li) {
+                            for (std::size_t lj = 0; lj < j_end; ++lj) {
+                                auto row = block + (li * B + lj) * B;
+                                CarveRow(view, params_, bi * B + li,
+                                         bj * B + lj, k_begin, k_end, row);
+                                for (std::size_t lk = 0;
+                                     lk < k_end - k_begin; ++lk) {
+                                    outside =
+                                        outside && row[lk] <= -narrow_band_;
+                                }
+                            }
+                        }
+                        if (outside) {
+                            break;
+                        }
+                    }
+
+                    // clamping commutes with taking the minimum, thus
+                    // the clamped distances do not depend on whether
+                    // the cameras are carved one by one or all at once
+                    auto all_inside = true, all_outside = true;
+                    for (std::size_t li = 0; li < i_end; ++li) {
+                        for (std::size_t lj = 0; lj < j_end; ++lj) {
+                            auto row = block + (li * B + lj) * B;
+                            for (std::size_t lk = 0; lk < k_end - k_begin;
+                                 ++lk) {
+                                row[lk] = std::min(
+                                    std::max(row[lk], -narrow_band_),
+                                    narrow_band_);
+                                all_inside  = all_inside &&
+                                              row[lk] == narrow_band_;
+                                all_outside = all_outside &&
+                                              row[lk] == -narrow_band_;
+                            }
                         }
                     }
 
-                    auto idx = voxelIdx(i, j, k, voxel_dim_, voxel_slice_);
-                    if (dist < vox_array_[idx]) {
-                        vox_array_[idx] = dist;
+                    if (all_inside || all_outside) {
+                        band_grid_->setUniform(
+                            brick, all_inside ? narrow_band_ : -narrow_band_);
+                        continue;
+                    }
+                    if (storage == nullptr) {
+                        storage = band_grid_->allocate(brick);
                     }
+                    std::copy_n(block, SparseVoxelGrid::BRICK_VOXELS,
+                                storage);
                 }
             }
         }
@@ -95,19 +382,37 @@ namespace rendering {
     vtkSmartPointer<vtkPolyData> VoxelCarving::createVisualHull(
         const double isolevel) const {
 
-        // create vtk visualization pipeline from voxel grid
-        auto spoints = vtkSmartPointer<vtkStructuredPoints>::New();
-        auto vdim    = static_cast<int>(voxel_dim_);
-        spoints->SetDimensions(vdim, vdim, vdim);
-        spoints->SetSpacing(params_.voxel_width, params_.voxel_height,
-                            params_.voxel_depth);
-        spoints->SetOrigin(params_.start_x, params_.start_y, params_.start_z);
+        if (band_grid_) {
+            // every surface cube has at least one corner within the band
+            assert(std::abs(isolevel) < narrow_band_);
+            std::vector<triangle> surface;
+            ExtractSurface(*band_grid_, params_, static_cast<float>(isolevel),
+                           num_threads_, surface);
+
+            const auto voxel_size =
+                std::min({params_.voxel_width, params_.voxel_height,
+                          params_.voxel_depth});
+            return CreatePolyData(surface, 1e-3 * voxel_size);
+        }
+
+        // vtk has no half precision arrays
+        if (backend_ == surface_backend::InTree || type_ == voxel_type::Half) {
+            std::vector<vec3f> vertices, normals;
+            std::vector<std::uint32_t> indices;
+            ExtractIndexedSurface(grid_, static_cast<float>(isolevel),
+                                  vertices, normals, indices, num_threads_);
+            return CreatePolyData(vertices, normals, indices);
+        }
 
-        auto farray = vtkSmartPointer<vtkFloatArray>::New();
-        auto vsize  = static_cast<vtkIdType>(voxel_size_);
-        farray->SetNumberOfValues(vsize);
-        farray->SetArray(vox_array_.get(), vsize, 1);
-        spoints->GetPointData()->SetScalars(farray);
+        // create vtk visualization pipeline from voxel grid. The scalars
+        // share the voxels, hence the visual hull stays valid even if this
+        // object is destroyed before the vtk pipeline
+        auto spoints = CreateStructuredPoints(grid_);
+        auto contour = isolevel;
+        if (type_ == voxel_type::Q15) {
+            // the Q15 voxels are contoured in fixed point units
+            contour = isolevel * (32767.0 / Q15_RANGE);
+        }
 
         // create iso surface with marching cubes
         auto mc_source = vtkSmartPointer<vtkMarchingCubes>::New();
@@ -117,7 +422,7 @@ namespace rendering {
         mc_source->SetInputData(spoints);
 #endif
         mc_source->SetNumberOfContours(1);
-        mc_source->SetValue(0, isolevel);
+        mc_source->SetValue(0, contour);
 
         // calculate surface normals
         auto surface_normals = vtkSmartPointer<vtkPolyDataNormals>::New();
@@ -144,24 +449,111 @@ namespace rendering {
         bb_margin_.second = margin_y;
     }
 
-    cv::Point3f VoxelCarving::calcVoxelPosInCamViewFrustum(
-        const std::size_t i, const std::size_t j, const std::size_t k) const {
+    void VoxelCarving::setNumThreads(const std::size_t num_threads) {
+
+        num_threads_ = num_threads == 0 ? HardwareConcurrency() : num_threads;
+    }
+
+    void VoxelCarving::setViewMemoryLimit(const std::size_t max_bytes) {
+
+        view_memory_limit_ = max_bytes;
+    }
+
+    std::size_t VoxelCarving::getViewMemoryLimit() const {
+        return view_memory_limit_;
+    }
+
+    void VoxelCarving::setDistMapCache(
+        std::shared_ptr<filtering::DistMapCache> cache) {
+
+        dist_cache_ = std::move(cache);
+    }
+
+    void VoxelCarving::setSurfaceBackend(const surface_backend backend) {
+
+        backend_ = backend;
+    }
+
+    surface_backend VoxelCarving::getSurfaceBackend() const {
+        return backend_;
+    }
+
+    std::size_t VoxelCarving::getVoxelDim() const { return voxel_dim_; }
+
+    const float* VoxelCarving::getVoxelGrid() const {
+        return type_ == voxel_type::Float
+                   ? grid_.getVoxels<float>()
+                   : nullptr;
+    }
+
+    voxel_type VoxelCarving::getVoxelType() const { return type_; }
 
-        cv::Point3f voxel;
-        voxel.x = params_.start_x + static_cast<float>(k) * params_.voxel_width;
-        voxel.y =
-            params_.start_y + static_cast<float>(j) * params_.voxel_height;
-        voxel.z = params_.start_z + static_cast<float>(i) * params_.voxel_depth;
+    const void* VoxelCarving::getVoxelData() const { return grid_.getData(); }
 
-        return voxel;
+    VoxelGrid VoxelCarving::shareVoxelGrid() { return grid_; }
+
+    float VoxelCarving::getNarrowBand() const { return narrow_band_; }
+
+    const SparseVoxelGrid* VoxelCarving::getSparseVoxelGrid() const {
+        return band_grid_.get();
+    }
+
+    void VoxelCarving::copyBlock(const std::size_t i0, const std::size_t j0,
+                                 const std::size_t k0, const std::size_t dim_i,
+                                 const std::size_t dim_j,
+                                 const std::size_t dim_k, float* block) const {
+
+        if (band_grid_) {
+            band_grid_->copyBlock(i0, j0, k0, dim_i, dim_j, dim_k, block);
+            return;
+        }
+
+        assert(i0 + dim_i <= voxel_dim_ && j0 + dim_j <= voxel_dim_ &&
+               k0 + dim_k <= voxel_dim_);
+        switch (type_) {
+            case voxel_type::Half:
+                CopyVoxels<half>(grid_, i0, j0, k0, dim_i, dim_j, dim_k,
+                                 block);
+                break;
+            case voxel_type::Q15:
+                CopyVoxels<q15>(grid_, i0, j0, k0, dim_i, dim_j, dim_k,
+                                block);
+                break;
+            default:
+                CopyVoxels<float>(grid_, i0, j0, k0, dim_i, dim_j, dim_k,
+                                  block);
+        }
+    }
+
+    std::size_t VoxelCarving::getMemoryUsage() const {
+
+        return band_grid_ ? band_grid_->getMemoryUsage()
+                          : grid_.getSizeInBytes();
+    }
+
+    bool VoxelCarving::save(const std::string& filename) const {
+
+        if (band_grid_) {
+            return false;
+        }
+
+        // rewriting the file of a mapped grid would truncate the mapping
+        boost::system::error_code ec;
+        if (!grid_file_.empty() &&
+            boost::filesystem::equivalent(filename, grid_file_, ec)) {
+            return true;
+        }
+        return SaveVoxelGrid(grid_, filename);
     }
 
-    start_params VoxelCarving::calcStartParameter(const bb_bounds& bbox) const {
+    start_params CalcStartParameter(const bb_bounds& bbox,
+                                    const std::size_t voxel_dim,
+                                    const std::pair<float, float>& margin_xy) {
 
         auto bb_width =
-            std::abs(bbox.xmax - bbox.xmin) * (1.0f + 2.0f * bb_margin_.first);
+            std::abs(bbox.xmax - bbox.xmin) * (1.0f + 2.0f * margin_xy.first);
         auto bb_height =
-            std::abs(bbox.ymax - bbox.ymin) * (1.0f + 2.0f * bb_margin_.second);
+            std::abs(bbox.ymax - bbox.ymin) * (1.0f + 2.0f * margin_xy.second);
         auto bb_depth = std::abs(bbox.zmax - bbox.zmin);
 
         auto offset_x = (bb_width - std::abs(bbox.xmax - bbox.xmin)) / 2.0f;
@@ -171,9 +563,9 @@ namespace rendering {
         params.start_x      = bbox.xmin - offset_x;
         params.start_y      = bbox.ymin - offset_y;
         params.start_z      = 0.0f;
-        params.voxel_width  = bb_width / static_cast<float>(voxel_dim_);
-        params.voxel_height = bb_height / static_cast<float>(voxel_dim_);
-        params.voxel_depth  = bb_depth / static_cast<float>(voxel_dim_);
+        params.voxel_width  = bb_width / static_cast<float>(voxel_dim);
+        params.voxel_height = bb_height / static_cast<float>(voxel_dim);
+        params.voxel_depth  = bb_depth / static_cast<float>(voxel_dim);
 
         return params;
     }
@@ -23,28 +23,43 @@
 
 #include <cstddef>
 #include <memory>
+#include <string>
 #include <utility>
+#include <vector>
 
 #include <vtkSmartPointer.h>
 #include <opencv2/core/core.hpp>
 
 #include "rendering/bounding_box.hpp"
+#include "rendering/sparse_voxel_grid.hpp"
+#include "rendering/voxel_grid.hpp"
+#include "rendering/voxel_type.hpp"
 
 class vtkPolyData;
 namespace ret { class Camera; }
+namespace ret { namespace filtering { class DistMapCache; } }
 
 namespace ret {
 
 namespace rendering {
 
-    /** @brief Start parameter used to calculate the offset when carving
-      * the visual hull */
-    template <typename T>
-    struct start_params_t {
-        T start_x, start_y, start_z;
-        T voxel_width, voxel_height, voxel_depth;
-    };
-    typedef start_params_t<float> start_params;
+    struct carve_view;
+
+    /** @brief Calculates the start parameter of a voxel grid enclosing the
+      * given bounding box
+      * @param bbox Dimensions of the bounding box
+      * @param voxel_dim Dimension of the voxel grid
+      * @param margin_xy relative margin added in x and y direction
+      * @return start parameter of the voxel grid */
+    start_params CalcStartParameter(const bb_bounds& bbox,
+                                    const std::size_t voxel_dim,
+                                    const std::pair<float, float>& margin_xy);
+
+    /** @brief Surface extraction used by @ref VoxelCarving::createVisualHull.
+      * Vtk runs vtkMarchingCubes and vtkPolyDataNormals on the voxel grid,
+      * InTree runs @ref mc::MarchingCubes::executeIndexed and converts the
+      * indexed mesh to vtkPolyData directly */
+    enum class surface_backend { Vtk, InTree };
 
     /** @brief Creates a rough 3D reconstruction (so called visual hull)
       * from a set of @ref Camera. The physical dimension of the object is
@@ -56,8 +71,50 @@ namespace rendering {
         /** @brief Given the voxel grid dimension this constructor fills up
           * a voxel grid ready to be used for carving out a reconstruction
           + @param bbox Dimensions of the bounding box
-          * @param voxel_grid_dim Dimension of the voxel grid */
-        VoxelCarving(const bb_bounds bbox, const std::size_t voxel_dim);
+          * @param voxel_grid_dim Dimension of the voxel grid
+          * @param narrow_band if greater than zero, the carved distances
+          * are clamped to [-narrow_band, narrow_band] and stored in a
+          * @ref SparseVoxelGrid, where only bricks containing voxels
+          * within the band are allocated. Memory then scales with the
+          * surface instead of the volume. The band must exceed the
+          * projected size of a voxel by a few pixels, such that the
+          * extracted surface equals the one of the dense voxel grid */
+        VoxelCarving(const bb_bounds bbox, const std::size_t voxel_dim,
+                     const float narrow_band = 0.0f);
+
+        /** @brief Prepares a dense voxel grid of the given element type.
+          * Each camera is carved in float precision, afterwards the
+          * distances are rounded to the element type. Since rounding is
+          * monotonic, the result equals the rounded result of carving with
+          * floats
+          * @param bbox Dimensions of the bounding box
+          * @param voxel_dim Dimension of the voxel grid
+          * @param type element type of the voxel grid */
+        VoxelCarving(const bb_bounds bbox, const std::size_t voxel_dim,
+                     const voxel_type type);
+
+        /** @brief Carves into a dense voxel grid, which is mapped from a
+          * file instead of being allocated in memory. Hence the voxel grid
+          * may exceed the physical memory and the carved voxels persist
+          * in the file, see @ref CreateMappedVoxelGrid
+          * @param bbox Dimensions of the bounding box
+          * @param voxel_dim Dimension of the voxel grid
+          * @param type element type of the voxel grid
+          * @param filename path of the voxel grid file, which is
+          * overwritten
+          * @throws std::runtime_error if the file cannot be created */
+        VoxelCarving(const bb_bounds bbox, const std::size_t voxel_dim,
+                     const voxel_type type, const std::string& filename);
+
+        /** @brief Maps a voxel grid file written by @ref save or by
+          * carving into a mapped grid, such that carving may continue or
+          * the visual hull can be extracted again without carving. The
+          * dimension, element type and start parameter are read from the
+          * file and further carving is written back to it
+          * @param filename path of the voxel grid file
+          * @throws std::runtime_error if the file is missing or no valid
+          * voxel grid file */
+        explicit VoxelCarving(const std::string& filename);
 
         VoxelCarving(VoxelCarving const&)            = delete;
         VoxelCarving operator&=(VoxelCarving const&) = delete;
@@ -70,12 +127,38 @@ namespace rendering {
           * @param cam current @ref Camera */
         void carve(const Camera& cam);
 
-        /** @brief Creates a visual hull from a camera set
+        /** @brief Carves the voxel grid with all cameras of a set at
+          * once. The distance maps and projection matrices of all cameras
+          * are precomputed first, afterwards the voxel grid is traversed
+          * once per batch of cameras, testing each voxel row against every
+          * camera of the batch while it is still in cache. The batches are
+          * bounded by @ref setViewMemoryLimit. Yields the same result as
+          * calling carve for each camera in the set
+          * @param cams complete @ref Camera set */
+        void carveAll(const std::vector<Camera>& cams);
+
+        /** @brief Limits the memory used by @ref carveAll for the
+          * precomputed camera data. Defaults to 64 MB, a single camera is
+          * carved per batch if it exceeds the limit on its own
+          * @param max_bytes memory limit in bytes */
+        void setViewMemoryLimit(const std::size_t max_bytes);
+        std::size_t getViewMemoryLimit() const;
+
+        /** @brief Creates a visual hull from a camera set. The surface is
+          * extracted with the backend given by @ref setSurfaceBackend.
+          * Voxel grids of half precision and narrow band grids are always
+          * extracted in-tree
           * @param isolevel threshold used for surface extraction
           * @return visual hull */
         vtkSmartPointer<vtkPolyData> createVisualHull(
             const double isolevel = 0.0) const;
 
+        /** @brief Selects the surface extraction used by
+          * @ref createVisualHull. Defaults to surface_backend::Vtk
+          * @param backend surface extraction backend */
+        void setSurfaceBackend(const surface_backend backend);
+        surface_backend getSurfaceBackend() const;
+
         /** @brief Manually adjust the binary image-based bounding box
           * calculation in x and y direction
           * @param margin_xy offset for x and y direction */
@@ -91,22 +174,108 @@ namespace rendering {
           * @param margin_y offset for y direction */
         void setBoundingBoxYMargin(const float margin_y);
 
+        /** @brief Sets the number of threads used for carving. The voxel
+          * grid is split into independent slabs along its slowest axis and
+          * each thread carves its own slab, hence the result is identical
+          * to carving with a single thread
+          * @param num_threads number of threads, 0 uses all hardware
+          * threads and 1 carves serially */
+        void setNumThreads(const std::size_t num_threads);
+
+        /** @brief Shares a cache for the distance maps of the camera
+          * masks, such that carving the same camera set again, e.g. with
+          * another instance at a different resolution, skips the distance
+          * transforms
+          * @param cache distance map cache or nullptr to disable caching,
+          * which is the default */
+        void setDistMapCache(std::shared_ptr<filtering::DistMapCache> cache);
+
+        /** @brief Returns the dimension of the voxel grid in each direction
+          * @return voxel grid dimension */
+        std::size_t getVoxelDim() const;
+
+        /** @brief Returns the carved voxel grid. The voxel (i, j, k) is
+          * stored at k + j * voxel_dim + i * voxel_dim^2
+          * @return pointer to the first voxel of the grid or nullptr, if
+          * the voxel grid is stored as narrow band or not as float */
+        const float* getVoxelGrid() const;
+
+        /** @brief Returns the element type of the dense voxel grid
+          * @return element type */
+        voxel_type getVoxelType() const;
+
+        /** @brief Returns the carved dense voxel grid of any element type,
+          * stored in the same order as by @ref getVoxelGrid
+          * @return pointer to the first voxel of the grid or nullptr, if
+          * the voxel grid is stored as narrow band */
+        const void* getVoxelData() const;
+
+        /** @brief Shares the carved dense voxel grid without copying it.
+          * The handle keeps the voxels alive after this object is
+          * destroyed, further carving is visible through the handle and
+          * writes through the handle change the voxels of this object
+          * @return voxel grid or an empty handle, if the voxel grid is
+          * stored as narrow band */
+        VoxelGrid shareVoxelGrid();
+
+        /** @brief Returns the width of the narrow band
+          * @return narrow band or 0, if the voxel grid is stored densely */
+        float getNarrowBand() const;
+
+        /** @brief Returns the carved narrow band
+          * @return sparse voxel grid or nullptr, if the voxel grid is
+          * stored densely */
+        const SparseVoxelGrid* getSparseVoxelGrid() const;
+
+        /** @brief Copies a block of the carved voxel grid starting at
+          * (i0, j0, k0) into a dense array, e.g. in order to pass it to
+          * @ref mc::MarchingCubes::execute. Voxel (i0 + i, j0 + j, k0 + k)
+          * is stored at k + j * dim_k + i * dim_k * dim_j and converted to
+          * float
+          * @param block destination of dim_i * dim_j * dim_k values */
+        void copyBlock(const std::size_t i0, const std::size_t j0,
+                       const std::size_t k0, const std::size_t dim_i,
+                       const std::size_t dim_j, const std::size_t dim_k,
+                       float* block) const;
+
+        /** @brief Returns the number of bytes used by the voxel grid */
+        std::size_t getMemoryUsage() const;
+
+        /** @brief Saves the dense voxel grid and its start parameter into a
+          * voxel grid file, which can be loaded again with
+          * @ref VoxelCarving(const std::string&). A grid mapped from the
+          * same file is already stored there and is not written again
+          * @param filename path of the voxel grid file
+          * @return false, if the voxel grid is stored as narrow band or the
+          * file could not be written */
+        bool save(const std::string& filename) const;
+
       private:
-        cv::Point3f calcVoxelPosInCamViewFrustum(const std::size_t i,
-                                                 const std::size_t j,
-                                                 const std::size_t k) const;
-        start_params calcStartParameter(const bb_bounds& bbox) const;
-
-        template <typename Coord, typename Size>
-        inline bool inside(const Coord& im, const Size& size) {
-            return (im.x > 0 && im.y > 0 && im.x < size.width &&
-                    im.y < size.height);
-        }
-
-        std::size_t voxel_dim_, voxel_slice_, voxel_size_;
-        std::unique_ptr<float[]> vox_array_;
-        start_params params_;
+        VoxelCarving(const bb_bounds bbox, const std::size_t voxel_dim,
+                     const float narrow_band, const voxel_type type);
+        VoxelCarving(VoxelGrid grid, std::string grid_file);
+
+        template <typename T>
+        void carveSlab(const std::vector<carve_view>& views, T* grid,
+                       const std::size_t i_begin, const std::size_t i_end);
+        void carveBricks(const std::vector<carve_view>& views,
+                         const std::size_t bi_begin,
+                         const std::size_t bi_end);
+        void carveViews(const std::vector<carve_view>& views);
+
+        std::size_t voxel_dim_, voxel_slice_, voxel_size_, num_threads_;
+        std::size_t view_memory_limit_;
+        float narrow_band_;
+        voxel_type type_;
+        surface_backend backend_;
+        /** dense voxel grid of type_ */
+        VoxelGrid grid_;
+        std::unique_ptr<SparseVoxelGrid> band_grid_;
         std::pair<float, float> bb_margin_;
+        start_params params_;
+        std::shared_ptr<filtering::DistMapCache> dist_cache_;
+        /** file the voxel grid is mapped from, empty if in memory */
+        std::string grid_file_;
     };
 } // namespace rendering
 } // namespace ret
@@ -0,0 +1,221 @@
+// Copyright (c) 2015-2016, Kai Wolf
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "rendering/voxel_carving_kernel.hpp"
+
+#include <algorithm>
+#include <cassert>
+
+#include <opencv2/core/types_c.h>
+#include <opencv2/core/mat.hpp>
+
+#if defined(WITH_X86_SIMD) && defined(_MSC_VER) && !defined(__GNUC__)
+#include <immintrin.h>
+#include <intrin.h>
+#endif
+
+#include "rendering/voxel_carving_kernel_simd.hpp"
+
+namespace ret {
+
+namespace rendering {
+
+    static carve_isa DetectCarveISA() {
+
+#if defined(WITH_X86_SIMD) && defined(__GNUC__)
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx2")) {
+            return carve_isa::AVX2;
+        }
+        if (__builtin_cpu_supports("sse4.1")) {
+            return carve_isa::SSE41;
+        }
+#elif defined(WITH_X86_SIMD) && defined(_MSC_VER)
+        int info[4];
+        __cpuid(info, 0);
+        const auto max_leaf = info[0];
+        __cpuid(info, 1);
+        const auto sse41   = (info[2] & (1 << 19)) != 0;
+        const auto osxsave = (info[2] & (1 << 27)) != 0;
+        const auto avx     = (info[2] & (1 << 28)) != 0;
+
+        // AVX2 additionally requires the OS to save the ymm registers
+        if (max_leaf >= 7 && osxsave && avx && (_xgetbv(0) & 0x6) == 0x6) {
+            __cpuidex(info, 7, 0);
+            if ((info[1] & (1 << 5)) != 0) {
+                return carve_isa::AVX2;
+            }
+        }
+        if (sse41) {
+            return carve_isa::SSE41;
+        }
+#endif
+        // any other compiler or CPU uses the scalar kernel only
+        return carve_isa::Scalar;
+    }
+
+    carve_isa GetCarveISA() {
+
+        static const auto isa = DetectCarveISA();
+        return isa;
+    }
+
+    const char* GetCarveISAName(const carve_isa isa) {
+
+        switch (isa) {
+            case carve_isa::Scalar: return "scalar";
+            case carve_isa::SSE41: return "sse4.1";
+            case carve_isa::AVX2: return "avx2";
+        }
+        return "unknown";
+    }
+
+    carve_view CreateCarveView(const cv::Mat& P, const cv::Mat& Mask,
+                               const cv::Mat& DistImage) {
+
+        carve_view view;
+        CreateCarveView(P, Mask, DistImage, view);
+        return view;
+    }
+
+    void CreateCarveView(const cv::Mat& P, const cv::Mat& Mask,
+                         const cv::Mat& DistImage, carve_view& view) {
+
+        assert(P.size() == cv::Size(4, 3) && P.type() == CV_32F);
+        assert(Mask.type() == CV_8U && DistImage.type() == CV_32F);
+        assert(Mask.size() == DistImage.size());
+
+        for (auto r = 0; r < 3; ++r) {
+            for (auto c = 0; c < 4; ++c) {
+                view.P[r * 4 + c] = P.at<float>(r, c);
+            }
+        }
+
+        view.width  = Mask.cols;
+        view.height = Mask.rows;
+        view.signed_dist.resize(static_cast<std::size_t>(Mask.total()));
+
+        auto dst = view.signed_dist.begin();
+        for (auto y = 0; y < Mask.rows; ++y) {
+            const auto mask = Mask.ptr<uchar>(y);
+            const auto dist = DistImage.ptr<float>(y);
+            for (auto x = 0; x < Mask.cols; ++x, ++dst) {
+                *dst = mask[x] == 0u ? dist[x] : -dist[x];
+            }
+        }
+    }
+
+    static carve_row_t CreateCarveRow(const carve_view& view,
+                                      const start_params& params,
+                                      const std::size_t i,
+                                      const std::size_t j) {
+
+        const auto P = view.P;
+        const auto vx = params.start_x;
+        const auto vy =
+            params.start_y + static_cast<float>(j) * params.voxel_height;
+        const auto vz =
+            params.start_z + static_cast<float>(i) * params.voxel_depth;
+
+        carve_row_t r;
+        for (auto row = 0; row < 3; ++row) {
+            const auto p = P + 4 * row;
+            r.h[row]     = p[0] * vx + p[1] * vy + p[2] * vz + p[3];
+            r.step[row]  = p[0] * params.voxel_width;
+        }
+        r.signed_dist = view.signed_dist.data();
+        r.width       = view.width;
+        r.height      = view.height;
+
+        return r;
+    }
+
+    static void CarveRowScalar(const carve_row_t& r, const std::size_t k_begin,
+                               const std::size_t k_end, float* row) {
+
+        const auto width  = static_cast<float>(r.width);
+        const auto height = static_cast<float>(r.height);
+
+        for (auto k = k_begin; k < k_end; ++k, ++row) {
+
+            // the SIMD kernels use the very same operations
+            const auto kf   = static_cast<float>(k);
+            const auto w    = 1.0f / (r.h[2] + kf * r.step[2]);
+            const auto im_x = (r.h[0] + kf * r.step[0]) * w;
+            const auto im_y = (r.h[1] + kf * r.step[1]) * w;
+
+            auto dist = -1.0f;
+            if (im_x > 0 && im_y > 0 && im_x < width && im_y < height) {
+                // rounding may hit the image border, hence clamp
+                const auto x = std::min(cvRound(im_x), r.width - 1);
+                const auto y = std::min(cvRound(im_y), r.height - 1);
+                dist         = r.signed_dist[y * r.width + x];
+            }
+
+            if (dist < *row) {
+                *row = dist;
+            }
+        }
+    }
+
+    cv::Point2f ProjectVoxel(const carve_view& view, const start_params& params,
+                             const std::size_t i, const std::size_t j,
+                             const std::size_t k) {
+
+        const auto r  = CreateCarveRow(view, params, i, j);
+        const auto kf = static_cast<float>(k);
+        const auto w  = 1.0f / (r.h[2] + kf * r.step[2]);
+
+        return cv::Point2f((r.h[0] + kf * r.step[0]) * w,
+                           (r.h[1] + kf * r.step[1]) * w);
+    }
+
+    void CarveRow(const carve_view& view, const start_params& params,
+                  const std::size_t i, const std::size_t j,
+                  const std::size_t k_begin, const std::size_t k_end,
+                  float* row) {
+
+        CarveRow(GetCarveISA(), view, params, i, j, k_begin, k_end, row);
+    }
+
+    void CarveRow(const carve_isa isa, const carve_view& view,
+                  const start_params& params, const std::size_t i,
+                  const std::size_t j, const std::size_t k_begin,
+                  const std::size_t k_end, float* row) {
+
+        assert(isa <= GetCarveISA());
+
+        const auto r     = CreateCarveRow(view, params, i, j);
+        std::size_t done = 0;
+        switch (isa) {
+            case carve_isa::Scalar: break;
+            case carve_isa::SSE41:
+                done = CarveRowSSE41(r, k_begin, k_end, row);
+                break;
+            case carve_isa::AVX2:
+                done = CarveRowAVX2(r, k_begin, k_end, row);
+                break;
+        }
+
+        // remaining voxels which do not fill up a whole register
+        CarveRowScalar(r, k_begin + done, k_end, row + done);
+    }
+} // namespace rendering
+} // namespace ret
@@ -0,0 +1,118 @@
+// Copyright (c) 2015-2016, Kai Wolf
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#ifndef RENDERING_VOXEL_CARVING_KERNEL_HPP
+#define RENDERING_VOXEL_CARVING_KERNEL_HPP
+
+#include <cstddef>
+#include <vector>
+
+#include <opencv2/core/core.hpp>
+
+#include "rendering/voxel_carving.hpp"
+
+namespace ret {
+
+namespace rendering {
+
+    /** @brief Everything needed to carve the voxel grid with a single
+      * camera, precomputed once before sweeping over the grid. The
+      * projection matrix is stored as plain floats and the silhouette mask
+      * is folded into the distance map, such that each voxel needs only a
+      * single lookup */
+    struct carve_view {
+        /** projection matrix in row-major order */
+        float P[12];
+        int width, height;
+        /** distance to the silhouette edge, negated outside of the
+          * silhouette */
+        std::vector<float> signed_dist;
+    };
+
+    /** @brief Instruction sets the row carving kernel is implemented for */
+    enum class carve_isa { Scalar, SSE41, AVX2 };
+
+    /** @brief Returns the widest instruction set supported by both the
+      * build and the executing CPU. Determined once at first call
+      * @return instruction set used by @ref CarveRow */
+    carve_isa GetCarveISA();
+
+    /** @brief Returns a printable name of the given instruction set
+      * @param isa instruction set
+      * @return name of the instruction set */
+    const char* GetCarveISAName(const carve_isa isa);
+
+    /** @brief Precomputes the carving data of a single camera
+      * @param P 3x4 projection matrix of type CV_32F
+      * @param Mask binary mask of the object, non-zero outside
+      * @param DistImage distance map created from the mask
+      * @return carve view of the camera */
+    carve_view CreateCarveView(const cv::Mat& P, const cv::Mat& Mask,
+                               const cv::Mat& DistImage);
+
+    /** @brief Precomputes the carving data of a single camera into an
+      * existing view, whose buffer is reused if it is large enough
+      * @param P 3x4 projection matrix of type CV_32F
+      * @param Mask binary mask of the object, non-zero outside
+      * @param DistImage distance map created from the mask
+      * @param view carve view to overwrite */
+    void CreateCarveView(const cv::Mat& P, const cv::Mat& Mask,
+                         const cv::Mat& DistImage, carve_view& view);
+
+    /** @brief Projects the voxel (i, j, k) into the given view the same
+      * way the carving kernels do. Within a row the homogeneous image
+      * coordinates are updated by a multiple of the first column of P
+      * and divided once, which deviates from the full projection in
+      * project() by less than 1e-3 pixel
+      * @param view precomputed camera data
+      * @param params start parameter of the voxel grid
+      * @return image coordinates of the voxel */
+    cv::Point2f ProjectVoxel(const carve_view& view, const start_params& params,
+                             const std::size_t i, const std::size_t j,
+                             const std::size_t k);
+
+    /** @brief Projects the voxels (i, j, k_begin) ... (i, j, k_end - 1)
+      * into the given view and keeps the minimum of the existing value in
+      * row and the signed distance to the silhouette edge. Voxels which
+      * are projected outside of the image get a distance of -1
+      * @param view precomputed camera data
+      * @param params start parameter of the voxel grid
+      * @param i index along the z-axis
+      * @param j index along the y-axis
+      * @param k_begin first index along the x-axis
+      * @param k_end one past the last index along the x-axis
+      * @param row voxel values, where row[0] belongs to k_begin */
+    void CarveRow(const carve_view& view, const start_params& params,
+                  const std::size_t i, const std::size_t j,
+                  const std::size_t k_begin, const std::size_t k_end,
+                  float* row);
+
+    /** @brief Same as @ref CarveRow, but with an explicitly selected
+      * instruction set. All instruction sets yield identical results
+      * @param isa instruction set, must not be wider than the one
+      * returned by @ref GetCarveISA */
+    void CarveRow(const carve_isa isa, const carve_view& view,
+                  const start_params& params, const std::size_t i,
+                  const std::size_t j, const std::size_t k_begin,
+                  const std::size_t k_end, float* row);
+} // namespace rendering
+} // namespace ret
+
+#endif
@@ -0,0 +1,97 @@
+// Copyright (c) 2015-2016, Kai Wolf
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "rendering/voxel_carving_kernel_simd.hpp"
+
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
+
+namespace ret {
+
+namespace rendering {
+
+#ifdef __AVX2__
+    std::size_t CarveRowAVX2(const carve_row_t& r, const std::size_t k_begin,
+                             const std::size_t k_end, float* row) {
+
+        const auto n = (k_end - k_begin) & ~static_cast<std::size_t>(7);
+
+        const auto hx      = _mm256_set1_ps(r.h[0]);
+        const auto hy      = _mm256_set1_ps(r.h[1]);
+        const auto hz      = _mm256_set1_ps(r.h[2]);
+        const auto step_x  = _mm256_set1_ps(r.step[0]);
+        const auto step_y  = _mm256_set1_ps(r.step[1]);
+        const auto step_z  = _mm256_set1_ps(r.step[2]);
+        const auto one     = _mm256_set1_ps(1.0f);
+        const auto zero    = _mm256_setzero_ps();
+        const auto width   = _mm256_set1_ps(static_cast<float>(r.width));
+        const auto height  = _mm256_set1_ps(static_cast<float>(r.height));
+        const auto outside = _mm256_set1_ps(-1.0f);
+        const auto stride  = _mm256_set1_epi32(r.width);
+        const auto max_x   = _mm256_set1_epi32(r.width - 1);
+        const auto max_y   = _mm256_set1_epi32(r.height - 1);
+        const auto lanes   = _mm256_set1_epi32(8);
+
+        auto k = _mm256_add_epi32(_mm256_set1_epi32(static_cast<int>(k_begin)),
+                                  _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7));
+
+        for (std::size_t done = 0; done < n; done += 8, row += 8) {
+
+            // h + k * step, dividing only once. Same operations as the
+            // scalar kernel, which keeps the results bit-identical. No FMA
+            // for the same reason
+            const auto kf  = _mm256_cvtepi32_ps(k);
+            const auto rcp = _mm256_div_ps(
+                one, _mm256_add_ps(hz, _mm256_mul_ps(kf, step_z)));
+            const auto im_x = _mm256_mul_ps(
+                _mm256_add_ps(hx, _mm256_mul_ps(kf, step_x)), rcp);
+            const auto im_y = _mm256_mul_ps(
+                _mm256_add_ps(hy, _mm256_mul_ps(kf, step_y)), rcp);
+
+            const auto inside = _mm256_and_ps(
+                _mm256_and_ps(_mm256_cmp_ps(im_x, zero, _CMP_GT_OQ),
+                              _mm256_cmp_ps(im_y, zero, _CMP_GT_OQ)),
+                _mm256_and_ps(_mm256_cmp_ps(im_x, width, _CMP_LT_OQ),
+                              _mm256_cmp_ps(im_y, height, _CMP_LT_OQ)));
+
+            // round to nearest like cvRound and clamp to the image border
+            const auto x = _mm256_min_epi32(_mm256_cvtps_epi32(im_x), max_x);
+            const auto y = _mm256_min_epi32(_mm256_cvtps_epi32(im_y), max_y);
+            const auto idx = _mm256_add_epi32(_mm256_mullo_epi32(y, stride), x);
+
+            // lanes outside of the image are masked and keep -1
+            const auto dist = _mm256_mask_i32gather_ps(
+                outside, r.signed_dist, idx, inside, sizeof(float));
+            _mm256_storeu_ps(row, _mm256_min_ps(dist, _mm256_loadu_ps(row)));
+
+            k = _mm256_add_epi32(k, lanes);
+        }
+
+        return n;
+    }
+#else
+    std::size_t CarveRowAVX2(const carve_row_t&, const std::size_t,
+                             const std::size_t, float*) {
+        return 0;
+    }
+#endif
+} // namespace rendering
+} // namespace ret
@@ -0,0 +1,61 @@
+// Copyright (c) 2015-2016, Kai Wolf
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#ifndef RENDERING_VOXEL_CARVING_KERNEL_SIMD_HPP
+#define RENDERING_VOXEL_CARVING_KERNEL_SIMD_HPP
+
+#include <cstddef>
+
+namespace ret {
+
+namespace rendering {
+
+    /** @brief Plain data of a single voxel row as seen by the carving
+      * kernels. Along a row only the x-coordinate of a voxel changes, hence
+      * its homogeneous image coordinates are h + k * step. The SIMD kernels
+      * are built with their own target flags, therefore they must not share
+      * any inline code (e.g. std::vector members) with the rest of the
+      * library and only operate on raw pointers */
+    struct carve_row_t {
+        /** homogeneous image coordinates of the voxel with k = 0 */
+        float h[3];
+        /** first column of P scaled by the voxel width */
+        float step[3];
+        const float* signed_dist;
+        int width, height;
+    };
+
+    /** @brief Carves the voxels k_begin ... k_end - 1 of a row four at a
+      * time using SSE4.1
+      * @return number of carved voxels, always a multiple of four. The
+      * remaining voxels must be carved by the scalar kernel */
+    std::size_t CarveRowSSE41(const carve_row_t& r, const std::size_t k_begin,
+                              const std::size_t k_end, float* row);
+
+    /** @brief Carves the voxels k_begin ... k_end - 1 of a row eight at a
+      * time using AVX2, including a gather from the distance map
+      * @return number of carved voxels, always a multiple of eight. The
+      * remaining voxels must be carved by the scalar kernel */
+    std::size_t CarveRowAVX2(const carve_row_t& r, const std::size_t k_begin,
+                             const std::size_t k_end, float* row);
+} // namespace rendering
+} // namespace ret
+
+#endif
@@ -0,0 +1,103 @@
+// Copyright (c) 2015-2016, Kai Wolf
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "rendering/voxel_carving_kernel_simd.hpp"
+
+#if defined(__SSE4_1__) || (defined(_MSC_VER) && defined(_M_X64))
+#include <smmintrin.h>
+#endif
+
+namespace ret {
+
+namespace rendering {
+
+#if defined(__SSE4_1__) || (defined(_MSC_VER) && defined(_M_X64))
+    std::size_t CarveRowSSE41(const carve_row_t& r, const std::size_t k_begin,
+                              const std::size_t k_end, float* row) {
+
+        const auto n = (k_end - k_begin) & ~static_cast<std::size_t>(3);
+
+        const auto hx     = _mm_set1_ps(r.h[0]);
+        const auto hy     = _mm_set1_ps(r.h[1]);
+        const auto hz     = _mm_set1_ps(r.h[2]);
+        const auto step_x = _mm_set1_ps(r.step[0]);
+        const auto step_y = _mm_set1_ps(r.step[1]);
+        const auto step_z = _mm_set1_ps(r.step[2]);
+        const auto one    = _mm_set1_ps(1.0f);
+        const auto zero   = _mm_setzero_ps();
+        const auto width  = _mm_set1_ps(static_cast<float>(r.width));
+        const auto height = _mm_set1_ps(static_cast<float>(r.height));
+        const auto stride = _mm_set1_epi32(r.width);
+        const auto max_x  = _mm_set1_epi32(r.width - 1);
+        const auto max_y  = _mm_set1_epi32(r.height - 1);
+        const auto lanes  = _mm_set1_epi32(4);
+
+        auto k = _mm_add_epi32(_mm_set1_epi32(static_cast<int>(k_begin)),
+                               _mm_setr_epi32(0, 1, 2, 3));
+
+        alignas(16) int idx[4];
+        alignas(16) int inside[4];
+        alignas(16) float dist[4];
+        for (std::size_t done = 0; done < n; done += 4, row += 4) {
+
+            // h + k * step, dividing only once. Same operations as the
+            // scalar kernel, which keeps the results bit-identical
+            const auto kf = _mm_cvtepi32_ps(k);
+            const auto rcp =
+                _mm_div_ps(one, _mm_add_ps(hz, _mm_mul_ps(kf, step_z)));
+            const auto im_x =
+                _mm_mul_ps(_mm_add_ps(hx, _mm_mul_ps(kf, step_x)), rcp);
+            const auto im_y =
+                _mm_mul_ps(_mm_add_ps(hy, _mm_mul_ps(kf, step_y)), rcp);
+
+            const auto in = _mm_and_ps(
+                _mm_and_ps(_mm_cmpgt_ps(im_x, zero), _mm_cmpgt_ps(im_y, zero)),
+                _mm_and_ps(_mm_cmplt_ps(im_x, width),
+                           _mm_cmplt_ps(im_y, height)));
+
+            // round to nearest like cvRound and clamp to the image border
+            const auto x = _mm_min_epi32(_mm_cvtps_epi32(im_x), max_x);
+            const auto y = _mm_min_epi32(_mm_cvtps_epi32(im_y), max_y);
+            _mm_store_si128(reinterpret_cast<__m128i*>(idx),
+                            _mm_add_epi32(_mm_mullo_epi32(y, stride), x));
+            _mm_store_si128(reinterpret_cast<__m128i*>(inside),
+                            _mm_castps_si128(in));
+
+            // there is no gather before AVX2, hence look up one by one
+            for (auto lane = 0; lane < 4; ++lane) {
+                dist[lane] =
+                    inside[lane] != 0 ? r.signed_dist[idx[lane]] : -1.0f;
+            }
+            _mm_storeu_ps(row,
+                          _mm_min_ps(_mm_load_ps(dist), _mm_loadu_ps(row)));
+
+            k = _mm_add_epi32(k, lanes);
+        }
+
+        return n;
+    }
+#else
+    std::size_t CarveRowSSE41(const carve_row_t&, const std::size_t,
+                              const std::size_t, float*) {
+        return 0;
+    }
+#endif
+} // namespace rendering
+} // namespace ret
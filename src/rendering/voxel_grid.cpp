@@ -0,0 +1,282 @@
+// Copyright (c) 2015-2016, Kai Wolf
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "rendering/voxel_grid.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+
+#include <boost/filesystem.hpp>
+#include <boost/interprocess/exceptions.hpp>
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+#include <vtkCallbackCommand.h>
+#include <vtkCommand.h>
+#include <vtkDataArray.h>
+#include <vtkFloatArray.h>
+#include <vtkPointData.h>
+#include <vtkShortArray.h>
+#include <vtkStructuredPoints.h>
+#include <vtkType.h>
+
+namespace bip = boost::interprocess;
+namespace fs  = boost::filesystem;
+namespace ret {
+
+namespace rendering {
+
+    namespace {
+
+        const char GRID_MAGIC[8]         = {'R', 'E', 'T', 'V',
+                                           'O', 'X', 'E', 'L'};
+        const std::uint32_t GRID_VERSION = 1;
+        // keeps the size of a grid file far below the range of std::uint64_t
+        const std::uint64_t MAX_VOXEL_DIM = 1u << 16;
+
+        // the voxels follow the header at a cache line boundary
+        struct grid_file_header {
+            char magic[8];
+            std::uint32_t version;
+            std::uint32_t type;
+            std::uint64_t voxel_dim;
+            start_params params;
+            char reserved[16];
+        };
+        static_assert(sizeof(grid_file_header) == 64,
+                      "voxel grid header must not contain padding");
+
+        grid_file_header CreateHeader(const std::size_t voxel_dim,
+                                      const voxel_type type,
+                                      const start_params& params) {
+            grid_file_header header;
+            std::memset(&header, 0, sizeof(header));
+            std::memcpy(header.magic, GRID_MAGIC, sizeof(header.magic));
+            header.version   = GRID_VERSION;
+            header.type      = static_cast<std::uint32_t>(type);
+            header.voxel_dim = voxel_dim;
+            header.params    = params;
+            return header;
+        }
+
+        // the returned handle shares the ownership of the whole mapping,
+        // but points to the first voxel behind the header
+        VoxelGrid MapGridFile(const std::string& filename) {
+
+            std::shared_ptr<bip::mapped_region> region;
+            try {
+                bip::file_mapping mapping(filename.c_str(), bip::read_write);
+                region = std::make_shared<bip::mapped_region>(
+                    mapping, bip::read_write);
+            } catch (const bip::interprocess_exception&) {
+                return VoxelGrid();
+            }
+            const auto base = static_cast<char*>(region->get_address());
+
+            grid_file_header header;
+            std::memcpy(&header, base, sizeof(header));
+            if (!std::equal(GRID_MAGIC, GRID_MAGIC + 8, header.magic) ||
+                header.version != GRID_VERSION ||
+                header.type > static_cast<std::uint32_t>(voxel_type::Q15) ||
+                header.voxel_dim == 0 || header.voxel_dim > MAX_VOXEL_DIM) {
+                return VoxelGrid();
+            }
+
+            // the bounded dimension cannot overflow the number of bytes
+            const auto type = static_cast<voxel_type>(header.type);
+            const auto num_bytes = header.voxel_dim * header.voxel_dim *
+                                   header.voxel_dim * GetVoxelSize(type);
+            if (num_bytes > region->get_size() - sizeof(header)) {
+                return VoxelGrid();
+            }
+
+            std::shared_ptr<void> data(region, base + sizeof(header));
+            return VoxelGrid(std::move(data), header.voxel_dim, type,
+                             header.params);
+        }
+
+        std::shared_ptr<void> AllocateVoxels(const std::size_t num_bytes) {
+            return std::shared_ptr<void>(new char[num_bytes],
+                                         std::default_delete<char[]>());
+        }
+
+        // releases the voxels shared with a vtk array once it is deleted
+        void ReleaseVoxels(vtkObject*, unsigned long, void* client_data,
+                           void*) {
+            delete static_cast<std::shared_ptr<const void>*>(client_data);
+        }
+
+        template <typename vtk_array_type, typename T>
+        vtkSmartPointer<vtkDataArray> WrapVoxels(const VoxelGrid& grid) {
+
+            auto array = vtkSmartPointer<vtk_array_type>::New();
+            auto owner = new std::shared_ptr<const void>(grid.getSharedData());
+            auto callback = vtkSmartPointer<vtkCallbackCommand>::New();
+            callback->SetCallback(ReleaseVoxels);
+            callback->SetClientData(owner);
+            array->AddObserver(vtkCommand::DeleteEvent, callback);
+
+            // save = 1, the voxels are never freed by vtk itself
+            const auto size = static_cast<vtkIdType>(grid.getNumVoxels());
+            array->SetArray(const_cast<T*>(grid.getVoxels<T>()), size, 1);
+            return array;
+        }
+    } // namespace
+
+    VoxelGrid::VoxelGrid()
+        : data_(), voxel_dim_(0), type_(voxel_type::Float), params_() {}
+
+    VoxelGrid::VoxelGrid(const std::size_t voxel_dim, const voxel_type type,
+                         const start_params& params)
+        : data_(AllocateVoxels(voxel_dim * voxel_dim * voxel_dim *
+                               GetVoxelSize(type))),
+          voxel_dim_(voxel_dim),
+          type_(type),
+          params_(params) {}
+
+    VoxelGrid::VoxelGrid(std::shared_ptr<void> data,
+                         const std::size_t voxel_dim, const voxel_type type,
+                         const start_params& params)
+        : data_(std::move(data)),
+          voxel_dim_(voxel_dim),
+          type_(type),
+          params_(params) {
+
+        assert(data_ != nullptr);
+    }
+
+    VoxelGrid VoxelGrid::clone() const {
+
+        if (empty()) {
+            return VoxelGrid();
+        }
+        VoxelGrid copy(voxel_dim_, type_, params_);
+        std::memcpy(copy.getData(), getData(), getSizeInBytes());
+        return copy;
+    }
+
+    bool VoxelGrid::empty() const { return data_ == nullptr; }
+
+    std::size_t VoxelGrid::getVoxelDim() const { return voxel_dim_; }
+
+    std::size_t VoxelGrid::getNumVoxels() const {
+        return voxel_dim_ * voxel_dim_ * voxel_dim_;
+    }
+
+    voxel_type VoxelGrid::getVoxelType() const { return type_; }
+
+    const start_params& VoxelGrid::getStartParams() const { return params_; }
+
+    std::size_t VoxelGrid::getSizeInBytes() const {
+        return empty() ? 0 : getNumVoxels() * GetVoxelSize(type_);
+    }
+
+    long VoxelGrid::getUseCount() const { return data_.use_count(); }
+
+    void* VoxelGrid::getData() { return data_.get(); }
+
+    const void* VoxelGrid::getData() const { return data_.get(); }
+
+    std::shared_ptr<const void> VoxelGrid::getSharedData() const {
+        return data_;
+    }
+
+    vtkSmartPointer<vtkDataArray> CreateVtkArray(const VoxelGrid& grid) {
+
+        if (grid.empty()) {
+            return nullptr;
+        }
+        switch (grid.getVoxelType()) {
+            case voxel_type::Float:
+                return WrapVoxels<vtkFloatArray, float>(grid);
+            case voxel_type::Q15:
+                return WrapVoxels<vtkShortArray, q15>(grid);
+            default:
+                return nullptr;
+        }
+    }
+
+    vtkSmartPointer<vtkStructuredPoints> CreateStructuredPoints(
+        const VoxelGrid& grid) {
+
+        const auto& params = grid.getStartParams();
+        const auto vdim    = static_cast<int>(grid.getVoxelDim());
+        auto spoints       = vtkSmartPointer<vtkStructuredPoints>::New();
+        spoints->SetDimensions(vdim, vdim, vdim);
+        spoints->SetSpacing(params.voxel_width, params.voxel_height,
+                            params.voxel_depth);
+        spoints->SetOrigin(params.start_x, params.start_y, params.start_z);
+        spoints->GetPointData()->SetScalars(CreateVtkArray(grid));
+        return spoints;
+    }
+
+    bool SaveVoxelGrid(const VoxelGrid& grid, const std::string& filename) {
+
+        if (grid.empty()) {
+            return false;
+        }
+        const auto header = CreateHeader(
+            grid.getVoxelDim(), grid.getVoxelType(), grid.getStartParams());
+        std::ofstream file(filename, std::ios::binary | std::ios::trunc);
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        file.write(static_cast<const char*>(grid.getData()),
+                   static_cast<std::streamsize>(grid.getSizeInBytes()));
+        return static_cast<bool>(file);
+    }
+
+    VoxelGrid CreateMappedVoxelGrid(const std::string& filename,
+                                    const std::size_t voxel_dim,
+                                    const voxel_type type,
+                                    const start_params& params) {
+
+        if (voxel_dim == 0 || voxel_dim > MAX_VOXEL_DIM) {
+            return VoxelGrid();
+        }
+
+        const auto header = CreateHeader(voxel_dim, type, params);
+        {
+            std::ofstream file(filename, std::ios::binary | std::ios::trunc);
+            if (!file.write(reinterpret_cast<const char*>(&header),
+                            sizeof(header))) {
+                return VoxelGrid();
+            }
+        }
+
+        // resizing creates a sparse file, hence no voxel is written here
+        boost::system::error_code ec;
+        fs::resize_file(filename, sizeof(header) + voxel_dim * voxel_dim *
+                                                       voxel_dim *
+                                                       GetVoxelSize(type),
+                        ec);
+        return ec ? VoxelGrid() : MapGridFile(filename);
+    }
+
+    VoxelGrid MapVoxelGrid(const std::string& filename) {
+
+        boost::system::error_code ec;
+        const auto file_size = fs::file_size(filename, ec);
+        if (ec || file_size < sizeof(grid_file_header)) {
+            return VoxelGrid();
+        }
+        return MapGridFile(filename);
+    }
+} // namespace rendering
+} // namespace ret
@@ -0,0 +1,183 @@
+// Copyright (c) 2015-2016, Kai Wolf
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#ifndef RENDERING_VOXEL_GRID_HPP
+#define RENDERING_VOXEL_GRID_HPP
+
+#include <cassert>
+#include <cstddef>
+#include <memory>
+#include <string>
+
+#include <vtkSmartPointer.h>
+
+#include "rendering/voxel_type.hpp"
+
+class vtkDataArray;
+class vtkStructuredPoints;
+
+namespace ret {
+
+namespace rendering {
+
+    /** @brief Start parameter used to calculate the offset when carving
+      * the visual hull */
+    template <typename T>
+    struct start_params_t {
+        T start_x, start_y, start_z;
+        T voxel_width, voxel_height, voxel_depth;
+    };
+    typedef start_params_t<float> start_params;
+
+    /** @brief Reference counted handle to a dense voxel grid. Copying a
+      * handle is cheap, since all copies share the same voxels, which are
+      * released together with the last handle. Hence a voxel grid can be
+      * passed to marching cubes, vtk or file writers and outlive its
+      * producer without being copied. Voxel (i, j, k) is stored at
+      * k + j * voxel_dim + i * voxel_dim^2 */
+    class VoxelGrid {
+      public:
+        /** @brief Creates an empty handle */
+        VoxelGrid();
+
+        /** @brief Allocates an uninitialized voxel grid
+          * @param voxel_dim Dimension of the voxel grid
+          * @param type element type of the voxels
+          * @param params world position of voxel (0, 0, 0) and voxel
+          * size */
+        VoxelGrid(const std::size_t voxel_dim, const voxel_type type,
+                  const start_params& params);
+
+        /** @brief Adopts existing voxels, e.g. of a memory mapped file.
+          * The deleter of data is invoked once the last handle is gone
+          * @param data voxel_dim^3 voxels of the given type
+          * @param voxel_dim Dimension of the voxel grid
+          * @param type element type of the voxels
+          * @param params world position of voxel (0, 0, 0) and voxel
+          * size */
+        VoxelGrid(std::shared_ptr<void> data, const std::size_t voxel_dim,
+                  const voxel_type type, const start_params& params);
+
+        /** @brief Creates a deep copy, which does not share the voxels
+          * with this handle
+          * @return new voxel grid */
+        VoxelGrid clone() const;
+
+        /** @brief Returns true, if the handle holds no voxel grid */
+        bool empty() const;
+
+        std::size_t getVoxelDim() const;
+        std::size_t getNumVoxels() const;
+        voxel_type getVoxelType() const;
+        const start_params& getStartParams() const;
+
+        /** @brief Returns the number of bytes used by the voxels */
+        std::size_t getSizeInBytes() const;
+
+        /** @brief Returns the number of handles sharing the voxels */
+        long getUseCount() const;
+
+        /** @brief Returns a pointer to the first voxel or nullptr, if the
+          * handle is empty. Changes are visible through all handles */
+        void* getData();
+        const void* getData() const;
+
+        /** @brief Returns the voxels as their element type
+          * @return pointer to the first voxel or nullptr, if the handle is
+          * empty */
+        template <typename T>
+        T* getVoxels();
+        template <typename T>
+        const T* getVoxels() const;
+
+        /** @brief Shares the ownership of the voxels without the grid
+          * layout, e.g. to keep them alive within a foreign container
+          * @return owning pointer to the first voxel */
+        std::shared_ptr<const void> getSharedData() const;
+
+      private:
+        std::shared_ptr<void> data_;
+        std::size_t voxel_dim_;
+        voxel_type type_;
+        start_params params_;
+    };
+
+    template <typename T>
+    T* VoxelGrid::getVoxels() {
+        assert(empty() || sizeof(T) == GetVoxelSize(type_));
+        return static_cast<T*>(getData());
+    }
+
+    template <typename T>
+    const T* VoxelGrid::getVoxels() const {
+        assert(empty() || sizeof(T) == GetVoxelSize(type_));
+        return static_cast<const T*>(getData());
+    }
+
+    /** @brief Wraps the voxels into a vtk array without copying them. The
+      * array shares the ownership of the voxels, hence it stays valid
+      * after all other handles are gone. Vtk must not modify the voxels
+      * @param grid voxel grid of float or Q15 voxels
+      * @return vtkFloatArray or vtkShortArray, nullptr if the grid is
+      * empty or stores half precision voxels, which vtk does not
+      * support */
+    vtkSmartPointer<vtkDataArray> CreateVtkArray(const VoxelGrid& grid);
+
+    /** @brief Creates structured points with the origin, spacing and
+      * voxels of the grid, see @ref CreateVtkArray
+      * @param grid voxel grid of float or Q15 voxels
+      * @return structured points sharing the voxels */
+    vtkSmartPointer<vtkStructuredPoints> CreateStructuredPoints(
+        const VoxelGrid& grid);
+
+    /** @brief Writes the voxels and start parameters of a grid into a
+      * voxel grid file, which can be mapped by @ref MapVoxelGrid
+      * @param grid voxel grid of any element type
+      * @param filename path of the voxel grid file
+      * @return false, if the grid is empty or the file could not be
+      * written */
+    bool SaveVoxelGrid(const VoxelGrid& grid, const std::string& filename);
+
+    /** @brief Creates a voxel grid file and maps it into memory. The voxels
+      * are uninitialized and written back to the file by the operating
+      * system, hence the grid may exceed the physical memory and survives
+      * a crash of the process
+      * @param filename path of the voxel grid file, which is overwritten
+      * @param voxel_dim Dimension of the voxel grid
+      * @param type element type of the voxels
+      * @param params world position of voxel (0, 0, 0) and voxel size
+      * @return voxel grid or an empty handle, if the file could not be
+      * created or voxel_dim is 0 or larger than 65536 */
+    VoxelGrid CreateMappedVoxelGrid(const std::string& filename,
+                                    const std::size_t voxel_dim,
+                                    const voxel_type type,
+                                    const start_params& params);
+
+    /** @brief Maps an existing voxel grid file into memory for reading and
+      * writing. Changes of the voxels are written back to the file and the
+      * mapping is released together with the last handle
+      * @param filename path of the voxel grid file
+      * @return voxel grid or an empty handle, if the file is missing or no
+      * valid voxel grid file */
+    VoxelGrid MapVoxelGrid(const std::string& filename);
+} // namespace rendering
+} // namespace ret
+
+#endif
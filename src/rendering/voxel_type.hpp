@@ -0,0 +1,102 @@
+// Copyright (c) 2015-2016, Kai Wolf
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#ifndef RENDERING_VOXEL_TYPE_HPP
+#define RENDERING_VOXEL_TYPE_HPP
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+
+#include "common/types/half.hpp"
+
+namespace ret {
+
+namespace rendering {
+
+    /** @brief Element type of a voxel grid. Half precision and Q15 store
+      * each voxel in two bytes instead of four, which halves the memory
+      * traffic of carving and surface extraction. A voxel holds the
+      * signed distance to the silhouette edge in pixels of the distance
+      * map, not in voxels. Q15 represents the distances within
+      * [-Q15_RANGE, Q15_RANGE] pixels in steps of Q15_RANGE / 32767,
+      * larger distances are saturated */
+    enum class voxel_type { Float, Half, Q15 };
+
+    /** @brief Distance in distance map pixels represented by the
+      * largest Q15 value */
+    constexpr float Q15_RANGE = 1024.0f;
+
+    /** @brief Fixed point voxel of type @ref voxel_type::Q15 */
+    typedef std::int16_t q15;
+
+    /** @brief Returns the number of bytes used by a single voxel */
+    inline std::size_t GetVoxelSize(const voxel_type type) {
+        return type == voxel_type::Float ? sizeof(float) : sizeof(q15);
+    }
+
+    /** @brief Returns a human readable name of the voxel type */
+    inline const char* GetVoxelTypeName(const voxel_type type) {
+        switch (type) {
+            case voxel_type::Half:
+                return "half";
+            case voxel_type::Q15:
+                return "q15";
+            default:
+                return "float";
+        }
+    }
+
+    /** @brief Converts a voxel to the distance it represents */
+    inline float VoxelToFloat(const float value) { return value; }
+
+    inline float VoxelToFloat(const half value) { return HalfToFloat(value); }
+
+    inline float VoxelToFloat(const q15 value) {
+        return static_cast<float>(value) * (Q15_RANGE / 32767.0f);
+    }
+
+    /** @brief Converts a distance to the nearest voxel value, saturating
+      * at the bounds of the voxel type. The conversion is monotonic, hence
+      * rounding commutes with taking the minimum during carving */
+    template <typename T>
+    T FloatToVoxel(const float value);
+
+    template <>
+    inline float FloatToVoxel<float>(const float value) {
+        return value;
+    }
+
+    template <>
+    inline half FloatToVoxel<half>(const float value) {
+        return FloatToHalf(std::min(std::max(value, -HALF_MAX), HALF_MAX));
+    }
+
+    template <>
+    inline q15 FloatToVoxel<q15>(const float value) {
+        const auto scaled = value * (32767.0f / Q15_RANGE);
+        return static_cast<q15>(
+            std::lrint(std::min(std::max(scaled, -32767.0f), 32767.0f)));
+    }
+} // namespace rendering
+} // namespace ret
+
+#endif
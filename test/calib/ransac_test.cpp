@@ -18,9 +18,151 @@
 // OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
 // SOFTWARE.
 
+#include <cmath>
+#include <cstddef>
+#include <random>
+#include <vector>
+
 #include <gtest/gtest.h>
 #include <opencv2/core/core.hpp>
 
 #include "calibration/ransac.hpp"
 
 using namespace ret::calib;
+
+namespace {
+// observations of a lambertian surface lit from light, a fraction of them
+// replaced by random intensities
+std::vector<contour_point> CreateObservations(const cv::Vec3f& light,
+                                              const std::size_t num,
+                                              const double outliers) {
+    std::mt19937 gen(17);
+    std::normal_distribution<float> normal;
+    std::uniform_real_distribution<double> uniform(0.0, 1.0);
+    std::uniform_int_distribution<int> intensity(0, 255);
+    std::vector<contour_point> observations;
+    while (observations.size() < num) {
+        cv::Vec3f n(normal(gen), normal(gen), normal(gen));
+        n /= cv::norm(n);
+        const auto shading = light.dot(n);
+        if (shading <= 0.1f) {
+            continue;
+        }
+        const auto value = uniform(gen) < outliers
+                               ? intensity(gen)
+                               : cvRound(255.0f * shading);
+        observations.emplace_back(n, static_cast<unsigned char>(value));
+    }
+    return observations;
+}
+} // namespace
+
+TEST(RansacTest, ModelFromThreePoints) {
+
+    const Ransac ransac;
+    const auto model = ransac.getModel(
+        contour_point(cv::Vec3f(1.0f, 0.0f, 0.0f), 30),
+        contour_point(cv::Vec3f(0.0f, 1.0f, 0.0f), 40),
+        contour_point(cv::Vec3f(0.0f, 0.0f, 1.0f), 0));
+    ASSERT_FLOAT_EQ(model.x, 0.6f);
+    ASSERT_FLOAT_EQ(model.y, 0.8f);
+    ASSERT_FLOAT_EQ(model.z, 0.0f);
+}
+
+TEST(RansacTest, SingularModelIsZero) {
+
+    const Ransac ransac;
+    const contour_point cp(cv::Vec3f(1.0f, 0.0f, 0.0f), 100);
+    const auto model = ransac.getModel(cp, cp, cp);
+    ASSERT_FLOAT_EQ(model.x, 0.0f);
+    ASSERT_FLOAT_EQ(model.y, 0.0f);
+    ASSERT_FLOAT_EQ(model.z, 0.0f);
+}
+
+TEST(RansacTest, LeastSquaresModel) {
+
+    const cv::Vec3f light(0.0f, 0.6f, 0.8f);
+    const Ransac ransac;
+    const auto model = ransac.getModel(CreateObservations(light, 500, 0.0));
+    ASSERT_NEAR(model.x, light[0], 5e-3);
+    ASSERT_NEAR(model.y, light[1], 5e-3);
+    ASSERT_NEAR(model.z, light[2], 5e-3);
+}
+
+TEST(RansacTest, BestModelIgnoresOutliers) {
+
+    auto light = cv::Vec3f(0.3f, -0.5f, 0.8f);
+    light /= cv::norm(light);
+
+    LightDirectionModel model;
+    Ransac ransac(5);
+    ransac.setObservationSet(CreateObservations(light, 1000, 0.3))
+        .setModel(model)
+        .setIterations(500)
+        .setRequiredInliers(3)
+        .setThreshold(0.01f);
+    ASSERT_TRUE(ransac.getBestModel(model));
+    ASSERT_NEAR(model.x, light[0], 1e-2);
+    ASSERT_NEAR(model.y, light[1], 1e-2);
+    ASSERT_NEAR(model.z, light[2], 1e-2);
+}
+
+TEST(RansacTest, DuplicateObservations) {
+
+    const cv::Vec3f light(0.0f, 0.0f, 1.0f);
+    auto observations = CreateObservations(light, 200, 0.0);
+    const auto copy   = observations;
+    observations.insert(observations.end(), copy.begin(), copy.end());
+
+    LightDirectionModel model;
+    Ransac ransac(9);
+    ransac.setObservationSet(observations)
+        .setModel(model)
+        .setIterations(100)
+        .setRequiredInliers(3)
+        .setThreshold(0.01f);
+    ASSERT_TRUE(ransac.getBestModel(model));
+    ASSERT_NEAR(model.z, 1.0f, 1e-2);
+}
+
+TEST(RansacTest, SameSeedGivesSameModel) {
+
+    const cv::Vec3f light(0.6f, 0.0f, 0.8f);
+    const auto observations = CreateObservations(light, 300, 0.5);
+    LightDirectionModel models[2];
+    for (auto& model : models) {
+        Ransac ransac(3);
+        ransac.setObservationSet(observations)
+            .setModel(model)
+            .setIterations(20)
+            .setRequiredInliers(3)
+            .setThreshold(0.01f);
+        ASSERT_TRUE(ransac.getBestModel(model));
+    }
+    ASSERT_EQ(models[0].x, models[1].x);
+    ASSERT_EQ(models[0].y, models[1].y);
+    ASSERT_EQ(models[0].z, models[1].z);
+}
+
+TEST(RansacTest, DegenerateSamplesAreRejected) {
+
+    // coplanar normals determine no light direction
+    std::vector<contour_point> observations;
+    for (auto idx = 0; idx < 50; ++idx) {
+        const auto angle = 0.1f * static_cast<float>(idx);
+        observations.emplace_back(
+            cv::Vec3f(std::cos(angle), std::sin(angle), 0.0f), 100);
+    }
+
+    LightDirectionModel model(0.0f, 0.0f, 1.0f);
+    Ransac ransac(11);
+    ransac.setObservationSet(observations)
+        .setModel(model)
+        .setIterations(100)
+        .setRequiredInliers(3)
+        .setThreshold(1.0f);
+    ASSERT_FALSE(ransac.getBestModel(model));
+    ASSERT_FLOAT_EQ(model.x, 0.0f);
+    ASSERT_FLOAT_EQ(model.y, 0.0f);
+    ASSERT_FLOAT_EQ(model.z, 1.0f);
+}
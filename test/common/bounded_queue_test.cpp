@@ -0,0 +1,95 @@
+// Copyright (c) 2015-2016, Kai Wolf
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include <cstddef>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "common/bounded_queue.hpp"
+
+using ret::BoundedQueue;
+
+TEST(BoundedQueueTest, PopsInPushOrder) {
+
+    BoundedQueue<int> queue(3);
+    ASSERT_EQ(queue.getCapacity(), 3u);
+    ASSERT_TRUE(queue.push(1));
+    ASSERT_TRUE(queue.push(2));
+    ASSERT_EQ(queue.size(), 2u);
+
+    int value = 0;
+    ASSERT_TRUE(queue.pop(value));
+    ASSERT_EQ(value, 1);
+    ASSERT_TRUE(queue.pop(value));
+    ASSERT_EQ(value, 2);
+    ASSERT_EQ(queue.size(), 0u);
+}
+
+TEST(BoundedQueueTest, ClosedQueueIsDrainedBeforePopFails) {
+
+    BoundedQueue<int> queue(2);
+    ASSERT_TRUE(queue.push(7));
+    queue.close();
+    ASSERT_FALSE(queue.push(8));
+
+    int value = 0;
+    ASSERT_TRUE(queue.pop(value));
+    ASSERT_EQ(value, 7);
+    ASSERT_FALSE(queue.pop(value));
+}
+
+TEST(BoundedQueueTest, ProducerNeverExceedsCapacity) {
+
+    const std::size_t capacity = 2;
+    const int num_values       = 1000;
+    BoundedQueue<int> queue(capacity);
+    std::thread producer([&]() {
+        for (auto idx = 0; idx < num_values; ++idx) {
+            queue.push(idx);
+        }
+        queue.close();
+    });
+
+    std::vector<int> values;
+    int value = 0;
+    while (queue.pop(value)) {
+        ASSERT_LE(queue.size(), capacity);
+        values.push_back(value);
+    }
+    producer.join();
+
+    ASSERT_EQ(values.size(), static_cast<std::size_t>(num_values));
+    for (auto idx = 0; idx < num_values; ++idx) {
+        ASSERT_EQ(values[idx], idx);
+    }
+}
+
+TEST(BoundedQueueTest, CloseWakesBlockedProducer) {
+
+    BoundedQueue<int> queue(1);
+    ASSERT_TRUE(queue.push(1));
+    bool pushed = true;
+    std::thread producer([&]() { pushed = queue.push(2); });
+    queue.close();
+    producer.join();
+    ASSERT_FALSE(pushed);
+}
@@ -21,7 +21,106 @@
 #include <iostream>
 
 #include <gtest/gtest.h>
+#include <opencv2/calib3d/calib3d.hpp>
 
 #include "common/camera.hpp"
+#include "common/camera_extrinsics.hpp"
+#include "common/camera_intrinsics.hpp"
 
 using ret::Camera;
+
+namespace {
+const cv::Mat K = (cv::Mat_<float>(3, 3) << 800, 0, 320, 0, 800, 240, 0, 0,
+                   1);
+const cv::Mat R = (cv::Mat_<float>(3, 3) << 0, 0, -1, 0, 1, 0, 1, 0, 0);
+const cv::Mat t = (cv::Mat_<float>(3, 1) << 1, 2, 10);
+
+cv::Mat CreateProjectionMatrix() {
+    cv::Mat Rt;
+    cv::hconcat(R, t, Rt);
+    return K * Rt;
+}
+
+// camera rotated by 90 degrees around the y axis, whose principal point is
+// the image center. The translation vector holds the homogeneous camera
+// center -R^T * t, scaled by 2
+Camera CreateCamera() {
+    Camera cam(cv::Mat(480, 640, CV_8UC3, cv::Scalar::all(0)));
+    cam.setCalibrationMatrix(K);
+    cam.setProjectionMatrix(CreateProjectionMatrix());
+    cam.setRotationMatrix(R);
+    cam.setTranslationVector(cv::Mat((cv::Mat_<float>(4, 1) << -20, -4, 2, 2)));
+    return cam;
+}
+} // namespace
+
+TEST(CameraTest, CenterIsDerivedFromProjectionMatrix) {
+    const auto cam = CreateCamera();
+    // C = -R^T * t
+    ASSERT_NEAR(cam.getCenter().x, -10.0, 1e-4);
+    ASSERT_NEAR(cam.getCenter().y, -2.0, 1e-4);
+    ASSERT_NEAR(cam.getCenter().z, 1.0, 1e-4);
+}
+
+TEST(CameraTest, DirectionIsRayThroughImageCenter) {
+    auto cam = CreateCamera();
+    // -R^T * K^-1 * (w / 2, h / 2, 1) = -R^T * (0, 0, 1)
+    ASSERT_FLOAT_EQ(cam.getDirection()[0], -1.0f);
+    ASSERT_NEAR(cam.getDirection()[1], 0.0f, 1e-6);
+    ASSERT_NEAR(cam.getDirection()[2], 0.0f, 1e-6);
+
+    // updated by the rotation matrix, copies keep their own direction
+    const auto copy = cam;
+    cam.setRotationMatrix(cv::Mat::eye(3, 3, CV_32F));
+    ASSERT_NEAR(cam.getDirection()[2], -1.0f, 1e-6);
+    ASSERT_FLOAT_EQ(copy.getDirection()[0], -1.0f);
+}
+
+TEST(CameraTest, PoseHoldsRotationAndTranslation) {
+    const auto cam   = CreateCamera();
+    const auto& Pose = cam.getPose();
+    ASSERT_FLOAT_EQ(Pose(0, 2), -1.0f);
+    ASSERT_FLOAT_EQ(Pose(2, 0), 1.0f);
+    ASSERT_FLOAT_EQ(Pose(0, 3), 1.0f);
+    ASSERT_FLOAT_EQ(Pose(1, 3), 2.0f);
+    ASSERT_FLOAT_EQ(Pose(2, 3), 10.0f);
+}
+
+TEST(CameraTest, PoseOfDecomposedProjectionMatrix) {
+    cv::Mat K2, R2, C;
+    cv::decomposeProjectionMatrix(CreateProjectionMatrix(), K2, R2, C);
+    Camera cam(cv::Mat(480, 640, CV_8UC3, cv::Scalar::all(0)));
+    cam.setCalibrationMatrix(K2);
+    cam.setRotationMatrix(R2);
+    cam.setTranslationVector(C);
+
+    const auto& Pose = cam.getPose();
+    for (auto r = 0; r < 3; ++r) {
+        for (auto c = 0; c < 3; ++c) {
+            ASSERT_NEAR(Pose(r, c), R.at<float>(r, c), 1e-5);
+        }
+        ASSERT_NEAR(Pose(r, 3), t.at<float>(r), 1e-4);
+    }
+}
+
+TEST(CameraTest, BaseClassSettersUpdateDerivedValues) {
+    auto cam = CreateCamera();
+    ret::CameraExtrinsics& extr = cam;
+    extr.setRotationMatrix(cv::Mat::eye(3, 3, CV_32F));
+    ASSERT_NEAR(cam.getDirection()[2], -1.0f, 1e-6);
+    ASSERT_FLOAT_EQ(cam.getPose()(0, 3), 10.0f);
+
+    extr.setTranslationVector(cv::Mat(cv::Mat::ones(4, 1, CV_32F)));
+    ASSERT_FLOAT_EQ(cam.getPose()(2, 3), -1.0f);
+
+    // a principal point left of the image center turns the direction
+    ret::CameraIntrinsics& intr = cam;
+    intr.setCalibrationMatrix(cv::Mat(
+        (cv::Mat_<float>(3, 3) << 1, 0, 0, 0, 1, 240, 0, 0, 1)));
+    ASSERT_LT(cam.getDirection()[0], -0.99f);
+}
+
+TEST(CameraTest, DefaultCameraHasNoDirection) {
+    const Camera cam;
+    ASSERT_TRUE(cam.getDirection() == cv::Vec3f());
+}
@@ -49,3 +49,20 @@ TEST(DataSetTest, GetSetDataSetCameras) {
     ds.setCameras(cams);
     ASSERT_EQ(ds.size(), 3);
 }
+
+TEST(DataSetTest, AccessCamerasWithoutCopy) {
+    DataSet ds;
+    ds.addCamera(Camera(cv::Mat(4, 4, CV_8UC3)));
+    ds.addCamera(Camera(cv::Mat(4, 4, CV_8UC3)));
+    const DataSet& cds = ds;
+
+    ASSERT_EQ(&cds.getCameras()[1], &ds.getCamera(1));
+    ASSERT_EQ(&cds.getCamera(1), &ds.getCamera(1));
+    ASSERT_EQ(cds.data(), &ds.getCamera(0));
+    ASSERT_EQ(cds.end() - cds.begin(), 2);
+
+    // getters share the matrices of the camera
+    const auto& P = cds.getCamera(0).getProjectionMatrix();
+    ASSERT_EQ(P.data, ds.getCamera(0).getProjectionMatrix().data);
+    ASSERT_EQ(&cds.getCamera(0).getMask(), &ds.getCamera(0).getMask());
+}
@@ -0,0 +1,58 @@
+// Copyright (c) 2015-2016, Kai Wolf
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include <cmath>
+#include <limits>
+
+#include <gtest/gtest.h>
+
+#include "common/types/half.hpp"
+
+using ret::half;
+using ret::FloatToHalf;
+using ret::HalfToFloat;
+
+TEST(HalfTest, RepresentableValuesAreExact) {
+
+    const float values[] = {0.0f, -0.0f, 1.0f, -2.5f, 0.099975586f,
+                            1024.0f, ret::HALF_MAX, 5.9604645e-8f};
+    for (const auto value : values) {
+        ASSERT_EQ(value, HalfToFloat(FloatToHalf(value)));
+    }
+    ASSERT_EQ(FloatToHalf(1.0f).bits, 0x3c00);
+    ASSERT_EQ(FloatToHalf(-2.0f).bits, 0xc000);
+}
+
+TEST(HalfTest, RoundsToNearestEven) {
+
+    // 1 + 2^-11 lies halfway between 1 and the next half value
+    ASSERT_EQ(FloatToHalf(1.0f + std::ldexp(1.0f, -11)).bits, 0x3c00);
+    ASSERT_EQ(FloatToHalf(1.0f + 3.0f * std::ldexp(1.0f, -11)).bits, 0x3c02);
+    ASSERT_EQ(FloatToHalf(1.0f + std::ldexp(1.0f, -10)).bits, 0x3c01);
+}
+
+TEST(HalfTest, OverflowIsInfinite) {
+
+    const auto inf = std::numeric_limits<float>::infinity();
+    ASSERT_EQ(HalfToFloat(FloatToHalf(65520.0f)), inf);
+    ASSERT_EQ(HalfToFloat(FloatToHalf(-1e10f)), -inf);
+    ASSERT_TRUE(std::isnan(HalfToFloat(
+        FloatToHalf(std::numeric_limits<float>::quiet_NaN()))));
+}
@@ -0,0 +1,119 @@
+// Copyright (c) 2015-2016, Kai Wolf
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include <atomic>
+#include <cstddef>
+#include <mutex>
+#include <set>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "common/parallel.hpp"
+
+using namespace ret;
+
+TEST(ParallelTest, ProcessesEveryIndexOnce) {
+
+    const std::size_t num = 1000;
+    std::vector<int> visits(num, 0);
+    ParallelFor(0, num, 7, [&](const std::size_t begin,
+                               const std::size_t end) {
+        for (auto idx = begin; idx < end; ++idx) {
+            ++visits[idx];
+        }
+    });
+    for (const auto count : visits) {
+        ASSERT_EQ(count, 1);
+    }
+}
+
+TEST(ParallelTest, ReusesPoolThreads) {
+
+    std::mutex mutex;
+    std::set<std::thread::id> threads;
+    for (auto call = 0; call < 100; ++call) {
+        ParallelFor(0, 64, 0, [&](const std::size_t, const std::size_t) {
+            std::lock_guard<std::mutex> lock(mutex);
+            threads.insert(std::this_thread::get_id());
+        });
+    }
+    ASSERT_LE(threads.size(), ThreadPool::Instance().getNumWorkers() + 1);
+}
+
+TEST(ParallelTest, NestedCallsFinish) {
+
+    std::atomic<std::size_t> sum(0);
+    ParallelFor(0, 16, 16, [&](const std::size_t begin,
+                               const std::size_t end) {
+        for (auto outer = begin; outer < end; ++outer) {
+            ParallelFor(0, 16, 16, [&](const std::size_t b,
+                                       const std::size_t e) {
+                sum += e - b;
+            });
+        }
+    });
+    ASSERT_EQ(sum.load(), 16u * 16u);
+}
+
+TEST(ParallelTest, RethrowsExceptionsAfterAllChunks) {
+
+    std::atomic<std::size_t> num_chunks(0);
+    ASSERT_THROW(ParallelFor(0, 8, 8,
+                             [&](const std::size_t begin, const std::size_t) {
+                                 ++num_chunks;
+                                 if (begin == 3) {
+                                     throw std::runtime_error("chunk");
+                                 }
+                             }),
+                 std::runtime_error);
+    ASSERT_EQ(num_chunks.load(), 8u);
+}
+
+TEST(ParallelTest, PoolWithoutWorkersRunsOnCaller) {
+
+    ThreadPool pool(0);
+    const auto caller = std::this_thread::get_id();
+    auto on_caller    = true;
+    pool.run(4, [&](const std::size_t) {
+        on_caller = on_caller && std::this_thread::get_id() == caller;
+    });
+    ASSERT_TRUE(on_caller);
+}
+
+TEST(ParallelTest, PoolRunsEveryTaskOnce) {
+
+    ThreadPool pool(3);
+    std::vector<std::atomic<int>> visits(100);
+    for (auto& count : visits) {
+        count = 0;
+    }
+    for (auto call = 0; call < 50; ++call) {
+        pool.run(visits.size(), [&](const std::size_t t) {
+            pool.run(2, [&](const std::size_t) {});
+            ++visits[t];
+        });
+    }
+    for (const auto& count : visits) {
+        ASSERT_EQ(count.load(), 50);
+    }
+}
@@ -0,0 +1,131 @@
+// Copyright (c) 2015-2016, Kai Wolf
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include <gtest/gtest.h>
+#include <opencv2/core/core.hpp>
+
+#include "filtering/dist_map_cache.hpp"
+#include "filtering/segmentation.hpp"
+
+using namespace ret::filtering;
+
+namespace {
+cv::Mat CreateMask(const int x) {
+
+    cv::Mat Mask(240, 320, CV_8U, cv::Scalar::all(255));
+    cv::Mat Black(20, 20, CV_8U, cv::Scalar::all(0));
+    cv::Mat SubRegion = Mask(cv::Rect(x, 100, Black.cols, Black.rows));
+    Black.copyTo(SubRegion);
+    return Mask;
+}
+
+bool Equal(const cv::Mat &A, const cv::Mat &B) {
+    return A.size() == B.size() && A.type() == B.type() &&
+           cv::countNonZero(A != B) == 0;
+}
+}
+
+TEST(DistMapCacheTest, CachedMapEqualsCreatedMap) {
+
+    DistMapCache cache;
+    const auto Mask = CreateMask(100);
+    ASSERT_TRUE(Equal(cache.get(Mask), CreateDistMap(Mask)));
+    ASSERT_EQ(cache.getMisses(), 1u);
+    ASSERT_EQ(cache.getHits(), 0u);
+    ASSERT_EQ(cache.getSize(), 1u);
+    ASSERT_EQ(cache.getMemoryUsage(), 320u * 240u * (1u + sizeof(float)));
+}
+
+TEST(DistMapCacheTest, EqualMasksHitTheCache) {
+
+    DistMapCache cache;
+    const auto First = cache.get(CreateMask(100));
+    const auto Second = cache.get(CreateMask(100));
+    ASSERT_EQ(First.data, Second.data);
+    ASSERT_EQ(cache.getMisses(), 1u);
+    ASSERT_EQ(cache.getHits(), 1u);
+
+    cache.clear();
+    ASSERT_EQ(cache.getSize(), 0u);
+    cache.get(CreateMask(100));
+    ASSERT_EQ(cache.getMisses(), 2u);
+}
+
+TEST(DistMapCacheTest, ChangedMaskMissesTheCache) {
+
+    DistMapCache cache;
+    auto Mask = CreateMask(100);
+    cache.get(Mask);
+
+    // modifying the mask in place must not return the previous map
+    Mask.at<uchar>(10, 10) = 0;
+    ASSERT_TRUE(Equal(cache.get(Mask), CreateDistMap(Mask)));
+    ASSERT_EQ(cache.getMisses(), 2u);
+    ASSERT_EQ(cache.getSize(), 2u);
+
+    ASSERT_TRUE(Equal(cache.get(CreateMask(100)),
+                      CreateDistMap(CreateMask(100))));
+    ASSERT_EQ(cache.getHits(), 1u);
+}
+
+TEST(DistMapCacheTest, LeastRecentlyUsedMapIsEvicted) {
+
+    // room for the masks and distance maps of two cameras
+    const std::size_t entry_size = 320u * 240u * (1u + sizeof(float));
+    DistMapCache cache(2 * entry_size);
+    ASSERT_EQ(cache.getCapacity(), 2 * entry_size);
+
+    const auto First = cache.get(CreateMask(100));
+    cache.get(CreateMask(120));
+    cache.get(CreateMask(100));
+    cache.get(CreateMask(140));
+    ASSERT_EQ(cache.getSize(), 2u);
+    ASSERT_EQ(cache.getMemoryUsage(), 2 * entry_size);
+    ASSERT_EQ(cache.getMisses(), 3u);
+
+    // the recently used first mask is kept, the second one was evicted
+    ASSERT_EQ(cache.get(CreateMask(100)).data, First.data);
+    ASSERT_EQ(cache.getHits(), 2u);
+    cache.get(CreateMask(120));
+    ASSERT_EQ(cache.getMisses(), 4u);
+    ASSERT_LE(cache.getMemoryUsage(), cache.getCapacity());
+}
+
+TEST(DistMapCacheTest, MapLargerThanCapacityIsKeptUntilNextMiss) {
+
+    DistMapCache cache(1);
+    cache.get(CreateMask(100));
+    ASSERT_EQ(cache.getSize(), 1u);
+    cache.get(CreateMask(100));
+    ASSERT_EQ(cache.getHits(), 1u);
+    cache.get(CreateMask(120));
+    ASSERT_EQ(cache.getSize(), 1u);
+}
+
+TEST(DistMapCacheTest, HashDependsOnSizeAndContent) {
+
+    const auto Mask = CreateMask(100);
+    ASSERT_EQ(HashMat(Mask), HashMat(Mask.clone()));
+    ASSERT_NE(HashMat(Mask), HashMat(CreateMask(101)));
+    ASSERT_NE(HashMat(Mask(cv::Rect(0, 0, 320, 120))),
+              HashMat(Mask(cv::Rect(0, 0, 160, 240))));
+    ASSERT_EQ(HashMat(Mask(cv::Rect(100, 100, 20, 20))),
+              HashMat(cv::Mat(20, 20, CV_8U, cv::Scalar::all(0))));
+}
@@ -0,0 +1,114 @@
+// Copyright (c) 2015-2016, Kai Wolf
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include <cstddef>
+
+#include <gtest/gtest.h>
+#include <opencv2/core/core.hpp>
+
+#include "common/camera.hpp"
+#include "common/dataset.hpp"
+#include "filtering/dist_map_cache.hpp"
+#include "filtering/preprocessing.hpp"
+#include "filtering/segmentation.hpp"
+
+using namespace ret;
+using namespace ret::filtering;
+
+namespace {
+const cv::Scalar THRESH(0, 0, 30);
+
+DataSet CreateDataSet(const std::size_t num_cams) {
+
+    DataSet ds;
+    for (std::size_t idx = 0; idx < num_cams; ++idx) {
+        cv::Mat Image(240, 320, CV_8UC3, cv::Scalar::all(255));
+        cv::Mat Region =
+            Image(cv::Rect(20 + 10 * static_cast<int>(idx), 50, 40, 40));
+        Region.setTo(0);
+        ds.addCamera(Camera(Image));
+    }
+    return ds;
+}
+
+bool Equal(const cv::Mat &A, const cv::Mat &B) {
+    return A.size() == B.size() && A.type() == B.type() &&
+           cv::countNonZero(A != B) == 0;
+}
+}
+
+TEST(PreprocessingTest, ParallelPreprocessingEqualsSerialFiltering) {
+
+    auto ds = CreateDataSet(7);
+    Preprocess(ds, THRESH, 3);
+    for (std::size_t idx = 0; idx < ds.size(); ++idx) {
+        const auto &cam = ds.getCamera(idx);
+        const auto Mask = Binarize(cam.getImage(), THRESH);
+        ASSERT_TRUE(Equal(cam.getMask(), Mask));
+        ASSERT_TRUE(Equal(cam.getDistMap(), CreateDistMap(Mask)));
+    }
+}
+
+TEST(PreprocessingTest, DistMapsAreOptional) {
+
+    auto ds = CreateDataSet(2);
+    Preprocess(ds, THRESH, 2, false);
+    ASSERT_FALSE(ds.getCamera(1).getMask().empty());
+    ASSERT_TRUE(ds.getCamera(1).getDistMap().empty());
+    ASSERT_TRUE(Equal(GetDistMap(ds.getCamera(1)),
+                      CreateDistMap(ds.getCamera(1).getMask())));
+}
+
+TEST(PreprocessingTest, PreprocessingUsesCache) {
+
+    DistMapCache cache;
+    auto ds = CreateDataSet(4);
+    Preprocess(ds, THRESH, 2, true, &cache);
+    Preprocess(ds, THRESH, 2, true, &cache);
+    ASSERT_EQ(cache.getMisses(), 4u);
+    ASSERT_EQ(cache.getHits(), 4u);
+}
+
+TEST(PreprocessingTest, SettingMaskDiscardsDistMap) {
+
+    auto ds = CreateDataSet(1);
+    Preprocess(ds, THRESH, 1);
+    auto &cam = ds.getCamera(0);
+    const auto DistMap = cam.getDistMap();
+    ASSERT_EQ(GetDistMap(cam).data, DistMap.data);
+
+    cam.setMask(cv::Mat(240, 320, CV_8U, cv::Scalar::all(0)));
+    ASSERT_TRUE(cam.getDistMap().empty());
+    ASSERT_NE(GetDistMap(cam).data, DistMap.data);
+}
+
+TEST(PreprocessingTest, EditingMaskInPlaceDiscardsDistMap) {
+
+    auto ds = CreateDataSet(1);
+    Preprocess(ds, THRESH, 1);
+    auto &cam = ds.getCamera(0);
+    const auto DistMap = cam.getDistMap();
+
+    // the matrix shares its data with the mask of the camera
+    cv::Mat Mask = cam.getMask();
+    Mask(cv::Rect(100, 100, 40, 40)).setTo(0);
+    ASSERT_NE(GetDistMap(cam).data, DistMap.data);
+    ASSERT_TRUE(Equal(GetDistMap(cam), CreateDistMap(cam.getMask())));
+}
@@ -0,0 +1,137 @@
+// Copyright (c) 2015-2016, Kai Wolf
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include <gtest/gtest.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <utility>
+#include <boost/filesystem.hpp>
+
+#include "common/camera.hpp"
+#include "common/dataset.hpp"
+#include "io/assets_path.hpp"
+#include "io/dataset_container.hpp"
+#include "io/dataset_reader.hpp"
+
+using ret::DataSet;
+using ret::io::DataSetContainerReader;
+using ret::io::DataSetReader;
+using ret::io::WriteDataSetContainer;
+
+namespace fs = boost::filesystem;
+
+namespace {
+// overwrites a field of the first camera record of a container
+void PatchRecord(const std::string& filename, const std::size_t field_offset,
+                 const std::int32_t value) {
+    std::fstream file(filename,
+                      std::ios::binary | std::ios::in | std::ios::out);
+    file.seekp(static_cast<std::streamoff>(sizeof(ret::io::ContainerHeader) +
+                                           field_offset));
+    file.write(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+bool EqualMats(const cv::Mat& A, const cv::Mat& B) {
+    return A.size() == B.size() && A.type() == B.type() &&
+           cv::norm(A, B, cv::NORM_INF) == 0.0;
+}
+}
+
+TEST(DataSetContainerTest, RoundTrip) {
+
+    const std::size_t numImages = 4;
+    DataSetReader dsr(std::string(ASSETS_PATH) + "/squirrel");
+    auto ds = dsr.load(numImages);
+    ds->getCamera(1).setMask(cv::Mat(ds->getCamera(1).getImageSize(), CV_8U,
+                                     cv::Scalar(255)));
+
+    const auto path = fs::temp_directory_path() / fs::unique_path();
+    ASSERT_TRUE(WriteDataSetContainer(*ds, path.string()));
+
+    DataSetContainerReader reader(path.string());
+    auto packed = reader.load();
+    ASSERT_TRUE(packed != nullptr);
+    ASSERT_EQ(packed->size(), numImages);
+
+    for (std::size_t i = 0; i < numImages; ++i) {
+        const auto& cam    = packed->getCamera(i);
+        const auto& source = ds->getCamera(i);
+        ASSERT_FALSE(cam.isImageDecoded());
+        ASSERT_TRUE(cam.getImageSize() == source.getImageSize());
+        ASSERT_TRUE(EqualMats(cam.getImage(), source.getImage()));
+        ASSERT_TRUE(EqualMats(cam.getMask(), source.getMask()));
+        ASSERT_TRUE(EqualMats(cam.getCalibrationMatrix(),
+                              source.getCalibrationMatrix()));
+        ASSERT_TRUE(EqualMats(cam.getDistortionCoeffs(),
+                              source.getDistortionCoeffs()));
+        ASSERT_TRUE(EqualMats(cam.getProjectionMatrix(),
+                              source.getProjectionMatrix()));
+        ASSERT_TRUE(EqualMats(cam.getRotationMatrix(),
+                              source.getRotationMatrix()));
+        ASSERT_TRUE(EqualMats(cam.getTranslationVector(),
+                              source.getTranslationVector()));
+    }
+
+    // images stay readable after the reader is gone
+    auto cam = packed->getCamera(3);
+    packed.reset();
+    ASSERT_TRUE(EqualMats(cam.getImage(), ds->getCamera(3).getImage()));
+
+    fs::remove(path);
+}
+
+TEST(DataSetContainerTest, RejectsInvalidFiles) {
+
+    ASSERT_TRUE(DataSetContainerReader("missing.retds").load() == nullptr);
+
+    const auto path = fs::temp_directory_path() / fs::unique_path();
+    {
+        std::ofstream file(path.string(), std::ios::binary);
+        file << "no data set container, just some text";
+    }
+    ASSERT_TRUE(DataSetContainerReader(path.string()).load() == nullptr);
+    fs::remove(path);
+}
+
+TEST(DataSetContainerTest, RejectsInvalidRecords) {
+
+    DataSetReader dsr(std::string(ASSETS_PATH) + "/squirrel");
+    auto ds = dsr.load(1);
+    const auto path = fs::temp_directory_path() / fs::unique_path();
+
+    typedef ret::io::ContainerCameraRecord record;
+    const std::pair<std::size_t, std::int32_t> patches[] = {
+        {offsetof(record, image_type), 12345},
+        {offsetof(record, image_type), CV_32FC3},
+        {offsetof(record, mask_type), CV_32F},
+        {offsetof(record, width), -1},
+        {offsetof(record, width), 1 << 30},
+        {offsetof(record, height), 1 << 20}};
+    for (const auto& patch : patches) {
+        ASSERT_TRUE(WriteDataSetContainer(*ds, path.string()));
+        ASSERT_TRUE(DataSetContainerReader(path.string()).load() != nullptr);
+        PatchRecord(path.string(), patch.first, patch.second);
+        ASSERT_TRUE(DataSetContainerReader(path.string()).load() == nullptr);
+    }
+    fs::remove(path);
+}
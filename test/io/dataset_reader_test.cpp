@@ -20,12 +20,15 @@
 
 #include <gtest/gtest.h>
 
+#include "common/camera.hpp"
 #include "common/dataset.hpp"
 #include "io/dataset_reader.hpp"
 #include "io/assets_path.hpp"
 
 using ret::DataSet;
 using ret::io::DataSetReader;
+using ret::io::ReadImageSize;
+using ret::io::image_loading;
 
 TEST(DataSetReaderTest, ReadDirectory) {
 
@@ -43,3 +46,65 @@ TEST(DataSetReaderTest, ReadDirectory) {
         ASSERT_TRUE(cam.getRotationMatrix().size() == cv::Size(3, 3));
     }
 }
+
+namespace {
+bool EqualImages(const cv::Mat& A, const cv::Mat& B) {
+    return A.size() == B.size() && A.type() == B.type() &&
+           cv::norm(A, B, cv::NORM_INF) == 0.0;
+}
+}
+
+TEST(DataSetReaderTest, ReadImageSizeFromHeader) {
+
+    const auto path = std::string(ASSETS_PATH) + "/squirrel/";
+    ASSERT_TRUE(ReadImageSize(path + "image_00.png") == cv::Size(1280, 960));
+    ASSERT_EQ(ReadImageSize(path + "K.xml").area(), 0);
+    ASSERT_EQ(ReadImageSize(path + "missing.png").area(), 0);
+}
+
+TEST(DataSetReaderTest, ParallelLoadEqualsSerialLoad) {
+
+    const std::string assetsPath(ASSETS_PATH);
+    const std::size_t numImages = 8;
+    DataSetReader dsr(assetsPath + "/squirrel");
+    auto serial = dsr.load(numImages);
+    dsr.setNumThreads(4);
+    auto parallel = dsr.load(numImages);
+    ASSERT_EQ(parallel->size(), numImages);
+
+    for (std::size_t i = 0; i < numImages; ++i) {
+        const auto& cam = parallel->getCamera(i);
+        ASSERT_TRUE(EqualImages(cam.getImage(),
+                                serial->getCamera(i).getImage()));
+        ASSERT_TRUE(EqualImages(cam.getProjectionMatrix(),
+                                serial->getCamera(i).getProjectionMatrix()));
+    }
+}
+
+TEST(DataSetReaderTest, LazyLoadDecodesOnFirstAccess) {
+
+    const std::string assetsPath(ASSETS_PATH);
+    const std::size_t numImages = 4;
+    DataSetReader dsr(assetsPath + "/squirrel");
+    auto eager = dsr.load(numImages);
+    dsr.setImageLoading(image_loading::Lazy);
+    auto lazy = dsr.load(numImages);
+
+    auto& cam = lazy->getCamera(2);
+    ASSERT_FALSE(cam.isImageDecoded());
+    ASSERT_TRUE(cam.getImageSize() == eager->getCamera(2).getImage().size());
+    ASSERT_TRUE(cam.getMask().size() == cam.getImageSize());
+
+    const auto Image = cam.getImage();
+    ASSERT_TRUE(cam.isImageDecoded());
+    ASSERT_TRUE(EqualImages(Image, eager->getCamera(2).getImage()));
+
+    // copies share the decoded image
+    const ret::Camera copy = cam;
+    ASSERT_EQ(copy.getImage().data, Image.data);
+
+    ASSERT_TRUE(cam.evictImage());
+    ASSERT_FALSE(copy.isImageDecoded());
+    ASSERT_TRUE(EqualImages(cam.getImage(), Image));
+    ASSERT_FALSE(eager->getCamera(2).evictImage());
+}
@@ -0,0 +1,198 @@
+// Copyright (c) 2015-2016, Kai Wolf
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <boost/filesystem.hpp>
+#include <vtkCellArray.h>
+#include <vtkPLYReader.h>
+#include <vtkPointData.h>
+#include <vtkPoints.h>
+#include <vtkPolyData.h>
+#include <vtkSmartPointer.h>
+#include <vtkUnsignedCharArray.h>
+
+#include "common/types/triangle.hpp"
+#include "common/types/vec3f.hpp"
+#include "io/mesh_writer.hpp"
+
+using namespace ret;
+using namespace ret::io;
+
+namespace fs = boost::filesystem;
+
+namespace {
+std::string ReadFile(const fs::path& path) {
+    std::ifstream file(path.string(), std::ios::binary);
+    std::stringstream content;
+    content << file.rdbuf();
+    return content.str();
+}
+
+// two triangles of a quad sharing the edge (0, 2)
+const std::vector<vec3f> VERTICES = {vec3f(0.0f, 0.0f, 0.0f),
+                                     vec3f(1.0f, 0.0f, 0.0f),
+                                     vec3f(1.0f, 1.0f, 0.0f),
+                                     vec3f(0.0f, 1.0f, -0.25f)};
+const std::vector<std::uint32_t> INDICES = {0, 1, 2, 0, 2, 3};
+}
+
+class MeshWriterTest : public testing::Test {
+  public:
+    virtual void SetUp() {
+        path = fs::temp_directory_path() / fs::unique_path();
+    }
+    virtual void TearDown() { fs::remove(path); }
+
+    fs::path path;
+};
+
+TEST_F(MeshWriterTest, WriteIndexedOBJ) {
+
+    const std::vector<vec3f> normals(4, vec3f(0.0f, 0.0f, 1.0f));
+    ASSERT_TRUE(WriteOBJ(path.string(), VERTICES, normals, INDICES));
+    ASSERT_EQ(ReadFile(path),
+              "v 0 0 0\nv 1 0 0\nv 1 1 0\nv 0 1 -0.25\n"
+              "vn 0 0 1\nvn 0 0 1\nvn 0 0 1\nvn 0 0 1\n"
+              "f 1//1 2//2 3//3\nf 1//1 3//3 4//4\n");
+
+    ASSERT_TRUE(WriteOBJ(path.string(), VERTICES, std::vector<vec3f>(),
+                         INDICES));
+    ASSERT_EQ(ReadFile(path), "v 0 0 0\nv 1 0 0\nv 1 1 0\nv 0 1 -0.25\n"
+                              "f 1 2 3\nf 1 3 4\n");
+}
+
+TEST_F(MeshWriterTest, ReversesWinding) {
+
+    const std::vector<vec3f> normals(4, vec3f(0.0f, 0.0f, 1.0f));
+    ASSERT_TRUE(WriteOBJ(path.string(), VERTICES, normals, INDICES, true));
+    ASSERT_EQ(ReadFile(path),
+              "v 0 0 0\nv 1 0 0\nv 1 1 0\nv 0 1 -0.25\n"
+              "vn 0 0 1\nvn 0 0 1\nvn 0 0 1\nvn 0 0 1\n"
+              "f 3//3 2//2 1//1\nf 4//4 3//3 1//1\n");
+
+    std::vector<triangle> triangles(1);
+    triangles[0].comp = {VERTICES[0], VERTICES[1], VERTICES[2]};
+    const std::vector<vec3f> face_normals = {vec3f(0.0f, 0.0f, -1.0f)};
+    ASSERT_TRUE(WriteOBJ(path.string(), triangles, face_normals, true));
+    ASSERT_EQ(ReadFile(path), "v 0 0 0\nv 1 0 0\nv 1 1 0\n"
+                              "vn 0 0 -1\n"
+                              "f 3//1 2//1 1//1\n");
+}
+
+TEST_F(MeshWriterTest, FormatsFloats) {
+
+    const std::vector<vec3f> vertices = {vec3f(0.5f, -1234.5f, 1e-7f),
+                                         vec3f(-0.000001f, 3.0f, 2e9f)};
+    ASSERT_TRUE(WriteOBJ(path.string(), vertices, std::vector<vec3f>(),
+                         std::vector<std::uint32_t>()));
+    ASSERT_EQ(ReadFile(path), "v 0.5 -1234.5 0\nv -0.000001 3 2e+09\n");
+}
+
+TEST_F(MeshWriterTest, TriangleSoupIsWelded) {
+
+    std::vector<triangle> triangles(2);
+    triangles[0].comp = {VERTICES[0], VERTICES[1], VERTICES[2]};
+    triangles[1].comp = {VERTICES[0], VERTICES[2], VERTICES[3]};
+
+    const std::vector<vec3f> face_normals = {vec3f(0.0f, 0.0f, 1.0f),
+                                             vec3f(0.0f, 1.0f, 0.0f)};
+    ASSERT_TRUE(WriteOBJ(path.string(), triangles, face_normals));
+    ASSERT_EQ(ReadFile(path),
+              "v 0 0 0\nv 1 0 0\nv 1 1 0\nv 0 1 -0.25\n"
+              "vn 0 0 1\nvn 0 1 0\n"
+              "f 1//1 2//1 3//1\nf 1//2 3//2 4//2\n");
+
+    ASSERT_TRUE(WritePLY(path.string(), triangles));
+    auto reader = vtkSmartPointer<vtkPLYReader>::New();
+    reader->SetFileName(path.string().c_str());
+    reader->Update();
+    ASSERT_EQ(reader->GetOutput()->GetNumberOfPoints(), 4);
+    ASSERT_EQ(reader->GetOutput()->GetNumberOfPolys(), 2);
+}
+
+TEST_F(MeshWriterTest, WriteIndexedPLY) {
+
+    const std::vector<vec3f> normals(4, vec3f(0.0f, 0.0f, 1.0f));
+    ASSERT_TRUE(WritePLY(path.string(), VERTICES, normals, INDICES));
+
+    // header, 4 vertices with normals and 2 faces of 3 indices
+    const auto content    = ReadFile(path);
+    const auto header_end = content.find("end_header\n");
+    ASSERT_NE(header_end, std::string::npos);
+    ASSERT_EQ(content.size(), header_end + 11 + 4 * 24 + 2 * 13);
+
+    auto reader = vtkSmartPointer<vtkPLYReader>::New();
+    reader->SetFileName(path.string().c_str());
+    reader->Update();
+    auto mesh = reader->GetOutput();
+    ASSERT_EQ(mesh->GetNumberOfPoints(), 4);
+    ASSERT_EQ(mesh->GetNumberOfPolys(), 2);
+    double v[3];
+    mesh->GetPoint(3, v);
+    ASSERT_FLOAT_EQ(static_cast<float>(v[2]), -0.25f);
+    ASSERT_TRUE(mesh->GetPointData()->GetNormals() != nullptr);
+}
+
+TEST_F(MeshWriterTest, WritePolyData) {
+
+    auto points = vtkSmartPointer<vtkPoints>::New();
+    for (const auto& v : VERTICES) {
+        points->InsertNextPoint(v.x, v.y, v.z);
+    }
+    auto polys = vtkSmartPointer<vtkCellArray>::New();
+    const vtkIdType quad[] = {0, 1, 2, 3};
+    polys->InsertNextCell(4, quad);
+    auto colors = vtkSmartPointer<vtkUnsignedCharArray>::New();
+    colors->SetNumberOfComponents(3);
+    colors->SetName("Colors");
+    for (auto c = 0; c < 4; ++c) {
+        colors->InsertNextTuple3(c, 10, 20);
+    }
+    auto mesh = vtkSmartPointer<vtkPolyData>::New();
+    mesh->SetPoints(points);
+    mesh->SetPolys(polys);
+    mesh->GetPointData()->AddArray(colors);
+
+    // the quad is triangulated as fan
+    ASSERT_TRUE(WriteOBJ(path.string(), mesh));
+    ASSERT_EQ(ReadFile(path), "v 0 0 0\nv 1 0 0\nv 1 1 0\nv 0 1 -0.25\n"
+                              "f 1 2 3\nf 1 3 4\n");
+
+    ASSERT_TRUE(WritePLY(path.string(), mesh));
+    ASSERT_NE(ReadFile(path).find("property uchar red"), std::string::npos);
+    auto reader = vtkSmartPointer<vtkPLYReader>::New();
+    reader->SetFileName(path.string().c_str());
+    reader->Update();
+    ASSERT_EQ(reader->GetOutput()->GetNumberOfPoints(), 4);
+    ASSERT_EQ(reader->GetOutput()->GetNumberOfPolys(), 2);
+}
+
+TEST_F(MeshWriterTest, ReportsWriteErrors) {
+
+    const auto missing = (path / "mesh.ply").string();
+    ASSERT_FALSE(WritePLY(missing, VERTICES, std::vector<vec3f>(), INDICES));
+    ASSERT_FALSE(WriteOBJ(missing, VERTICES, std::vector<vec3f>(), INDICES));
+}
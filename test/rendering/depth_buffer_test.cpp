@@ -0,0 +1,169 @@
+// Copyright (c) 2015-2016, Kai Wolf
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <random>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include <vtkPolyData.h>
+#include <vtkSmartPointer.h>
+
+#include "common/dataset.hpp"
+#include "filtering/preprocessing.hpp"
+#include "io/assets_path.hpp"
+#include "io/dataset_reader.hpp"
+#include "rendering/bounding_box.hpp"
+#include "rendering/depth_buffer.hpp"
+#include "rendering/voxel_carving.hpp"
+
+using namespace ret::rendering;
+using namespace ret::io;
+using namespace ret::filtering;
+
+TEST(DepthBufferTest, RasterizeSingleTriangle) {
+
+    DepthBuffer buffer(cv::Size(100, 80));
+    const std::vector<screen_vertex> vertices = {
+        {10.0f, 10.0f, 0.5f}, {90.0f, 10.0f, 0.5f}, {10.0f, 70.0f, 0.5f}};
+    buffer.render(vertices, {0, 1, 2}, 1);
+
+    const auto& InvDepth = buffer.getInvDepthMap();
+    ASSERT_FLOAT_EQ(InvDepth.at<float>(20, 20), 0.5f);
+    ASSERT_FLOAT_EQ(InvDepth.at<float>(5, 5), 0.0f);
+    ASSERT_FLOAT_EQ(InvDepth.at<float>(75, 95), 0.0f);
+    ASSERT_TRUE(buffer.isVisible({20.0f, 20.0f, 0.5f}, 0.0f));
+    ASSERT_FALSE(buffer.isVisible({20.0f, 20.0f, 0.25f}, 0.01f));
+    ASSERT_FALSE(buffer.isVisible({120.0f, 20.0f, 0.5f}, 0.01f));
+    ASSERT_FALSE(buffer.isVisible({20.0f, 20.0f, -0.5f}, 0.01f));
+
+    buffer.clear();
+    ASSERT_EQ(cv::countNonZero(buffer.getInvDepthMap()), 0);
+}
+
+TEST(DepthBufferTest, NearestTriangleWins) {
+
+    DepthBuffer buffer(cv::Size(64, 64));
+    // far triangle first, the near one in reverse winding
+    const std::vector<screen_vertex> vertices = {
+        {0.0f, 0.0f, 0.1f},  {64.0f, 0.0f, 0.1f},  {0.0f, 64.0f, 0.1f},
+        {0.0f, 0.0f, 0.2f},  {0.0f, 32.0f, 0.2f},  {32.0f, 0.0f, 0.2f}};
+    buffer.render(vertices, {0, 1, 2, 3, 4, 5}, 1);
+
+    ASSERT_FLOAT_EQ(buffer.getInvDepthMap().at<float>(5, 5), 0.2f);
+    ASSERT_FLOAT_EQ(buffer.getInvDepthMap().at<float>(40, 10), 0.1f);
+    ASSERT_FALSE(buffer.isVisible({5.5f, 5.5f, 0.1f}, 0.01f));
+    ASSERT_TRUE(buffer.isVisible({10.5f, 40.5f, 0.1f}, 0.01f));
+}
+
+TEST(DepthBufferTest, ClampsHugeAndSkipsNonFiniteTriangles) {
+
+    DepthBuffer buffer(cv::Size(64, 64));
+    const auto nan = std::numeric_limits<float>::quiet_NaN();
+    const auto inf = std::numeric_limits<float>::infinity();
+    // a triangle far beyond the range of int covering the whole image,
+    // followed by nearer ones with a NaN and an infinite corner
+    const std::vector<screen_vertex> vertices = {
+        {-1e10f, -1e10f, 0.1f}, {1e10f, -1e10f, 0.1f}, {0.0f, 1e10f, 0.1f},
+        {0.0f, 0.0f, 0.5f},     {nan, 0.0f, 0.5f},     {0.0f, 64.0f, 0.5f},
+        {0.0f, 0.0f, 0.5f},     {64.0f, 0.0f, 0.5f},   {0.0f, inf, 0.5f}};
+    buffer.render(vertices, {0, 1, 2, 3, 4, 5, 6, 7, 8}, 1);
+
+    double min_inv_depth, max_inv_depth;
+    cv::minMaxLoc(buffer.getInvDepthMap(), &min_inv_depth, &max_inv_depth);
+    ASSERT_NEAR(min_inv_depth, 0.1, 1e-3);
+    ASSERT_NEAR(max_inv_depth, 0.1, 1e-3);
+    ASSERT_FALSE(buffer.isVisible({nan, 20.0f, 0.5f}, 0.01f));
+    ASSERT_FALSE(buffer.isVisible({20.0f, inf, 0.5f}, 0.01f));
+}
+
+TEST(DepthBufferTest, ParallelEqualsSerial) {
+
+    const cv::Size size(300, 200);
+    std::mt19937 gen(7);
+    std::uniform_real_distribution<float> x(-20.0f, 320.0f);
+    std::uniform_real_distribution<float> y(-20.0f, 220.0f);
+    std::uniform_real_distribution<float> inv_depth(0.01f, 1.0f);
+    std::vector<screen_vertex> vertices(3000);
+    for (auto& v : vertices) {
+        v = {x(gen), y(gen), inv_depth(gen)};
+    }
+    std::vector<std::uint32_t> indices(vertices.size());
+    for (std::size_t i = 0; i < indices.size(); ++i) {
+        indices[i] = static_cast<std::uint32_t>(i);
+    }
+
+    DepthBuffer serial(size);
+    serial.render(vertices, indices, 1);
+    for (std::size_t num_threads : {2, 3, 8}) {
+        DepthBuffer parallel(size);
+        parallel.render(vertices, indices, num_threads);
+        ASSERT_EQ(cv::countNonZero(serial.getInvDepthMap() !=
+                                   parallel.getInvDepthMap()),
+                  0);
+    }
+}
+
+class MeshVisibilityTest : public testing::Test {
+
+  public:
+    virtual void SetUp() {
+        DataSetReader dsr(std::string(ASSETS_PATH) + "/squirrel");
+        ds = dsr.load(NUM_IMGS);
+        Preprocess(*ds, cv::Scalar(0, 0, 30), 0, false);
+        BoundingBox bbox =
+            BoundingBox(ds->getCamera(0), ds->getCamera((NUM_IMGS / 4) - 1));
+        VoxelCarving vc(bbox.getBounds(), VOXEL_DIM);
+        vc.carveAll(ds->getCameras());
+        mesh = vc.createVisualHull();
+    }
+
+    std::shared_ptr<ret::DataSet> ds;
+    vtkSmartPointer<vtkPolyData> mesh;
+    const std::size_t VOXEL_DIM = 64;
+    const std::size_t NUM_IMGS  = 36;
+};
+
+TEST_F(MeshVisibilityTest, OccludesBackFacingVertices) {
+
+    const MeshVisibility visibility(mesh, ds->getCameras(), 1);
+    ASSERT_EQ(visibility.getNumCameras(), NUM_IMGS);
+    ASSERT_EQ(visibility.getNumVertices(),
+              static_cast<std::size_t>(mesh->GetNumberOfPoints()));
+    for (std::size_t c = 0; c < NUM_IMGS; ++c) {
+        const auto num_visible = visibility.getNumVisible(c);
+        ASSERT_GT(num_visible, 0u);
+        ASSERT_LT(num_visible, visibility.getNumVertices());
+    }
+}
+
+TEST_F(MeshVisibilityTest, ParallelEqualsSerial) {
+
+    const MeshVisibility serial(mesh, ds->getCameras(), 1);
+    const MeshVisibility parallel(mesh, ds->getCameras(), 4);
+    for (std::size_t c = 0; c < NUM_IMGS; ++c) {
+        for (std::size_t i = 0; i < serial.getNumVertices(); ++i) {
+            ASSERT_EQ(serial.isVisible(c, i), parallel.isVisible(c, i));
+        }
+    }
+}
@@ -0,0 +1,119 @@
+// Copyright (c) 2015-2016, Kai Wolf
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include <algorithm>
+#include <cstddef>
+#include <numeric>
+#include <random>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include <opencv2/core/core.hpp>
+
+#include "rendering/direction_lookup.hpp"
+
+using namespace ret::rendering;
+
+namespace {
+cv::Vec3d RandomDirection(std::mt19937& gen) {
+    std::normal_distribution<double> dist;
+    const cv::Vec3d v(dist(gen), dist(gen), dist(gen));
+    return v / cv::norm(v);
+}
+
+std::vector<cv::Vec3f> RandomDirections(const std::size_t num) {
+    std::mt19937 gen(3);
+    std::vector<cv::Vec3f> directions(num);
+    for (auto& dir : directions) {
+        dir = RandomDirection(gen);
+    }
+    return directions;
+}
+
+// indices of all directions, best first, ties by index
+std::vector<std::size_t> RankAll(const std::vector<cv::Vec3f>& directions,
+                                 const cv::Vec3d& normal) {
+    std::vector<std::size_t> ranked(directions.size());
+    std::iota(ranked.begin(), ranked.end(), 0);
+    std::stable_sort(ranked.begin(), ranked.end(),
+                     [&](const std::size_t a, const std::size_t b) {
+                         return normal.dot(cv::Vec3d(directions[a])) >
+                                normal.dot(cv::Vec3d(directions[b]));
+                     });
+    return ranked;
+}
+} // namespace
+
+TEST(DirectionLookupTest, BinsCoverSphere) {
+
+    const DirectionLookup lookup(RandomDirections(10), 1, -1.0, 4);
+    ASSERT_EQ(lookup.getNumBins(), 6u * 4u * 4u);
+    ASSERT_EQ(lookup.getNumCameras(), 10u);
+    ASSERT_LT(lookup.getBin(cv::Vec3d(1.0, 0.0, 0.0)), lookup.getNumBins());
+    ASSERT_NE(lookup.getBin(cv::Vec3d(1.0, 0.0, 0.0)),
+              lookup.getBin(cv::Vec3d(-1.0, 0.0, 0.0)));
+    ASSERT_LT(lookup.getBin(cv::Vec3d(1.0, -1.0, 1.0)), lookup.getNumBins());
+}
+
+TEST(DirectionLookupTest, FindBestEqualsLinearScan) {
+
+    const auto directions = RandomDirections(144);
+    std::mt19937 gen(11);
+    for (std::size_t k : {1, 4}) {
+        const DirectionLookup lookup(directions, k);
+        std::vector<std::size_t> best(k);
+        for (auto i = 0; i < 5000; ++i) {
+            const auto normal = RandomDirection(gen);
+            const auto ranked = RankAll(directions, normal);
+            ASSERT_EQ(lookup.findBest(normal, best.data(), k), k);
+            ASSERT_TRUE(std::equal(best.begin(), best.end(), ranked.begin()));
+            ASSERT_LT(lookup.getCandidates(normal).size(), directions.size());
+        }
+    }
+}
+
+TEST(DirectionLookupTest, CandidatesContainAllAboveMinDot) {
+
+    const auto directions = RandomDirections(144);
+    const DirectionLookup lookup(directions, directions.size(), 0.5);
+    std::mt19937 gen(13);
+    for (auto i = 0; i < 5000; ++i) {
+        const auto normal     = RandomDirection(gen);
+        const auto candidates = lookup.getCandidates(normal);
+        for (std::size_t c = 0; c < directions.size(); ++c) {
+            if (normal.dot(cv::Vec3d(directions[c])) >= 0.5) {
+                ASSERT_NE(std::find(candidates.begin(), candidates.end(), c),
+                          candidates.end());
+            }
+        }
+    }
+}
+
+TEST(DirectionLookupTest, FewerCamerasThanK) {
+
+    const auto directions = RandomDirections(3);
+    const DirectionLookup lookup(directions, 5);
+    std::size_t best[5];
+    const cv::Vec3d normal(0.0, 0.0, 1.0);
+    ASSERT_EQ(lookup.getCandidates(normal).size(), 3u);
+    ASSERT_EQ(lookup.findBest(normal, best, 5), 3u);
+    const auto ranked = RankAll(directions, normal);
+    ASSERT_TRUE(std::equal(best, best + 3, ranked.begin()));
+}
@@ -0,0 +1,233 @@
+// Copyright (c) 2015-2016, Kai Wolf
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include <cmath>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "common/types/triangle.hpp"
+#include "rendering/mc/marching_cubes.hpp"
+
+using ret::rendering::mc::MarchingCubes;
+using ret::rendering::mc::int_type;
+
+namespace {
+
+// Samples a sphere of radius r, positive inside, in the marching cubes
+// layout x + z * dim_x + y * dim_x * dim_z
+std::vector<float> CreateSphere(const int_type dim_x, const int_type dim_y,
+                                const int_type dim_z, const float r) {
+
+    std::vector<float> grid(dim_x * dim_y * dim_z);
+    for (int_type y = 0; y < dim_y; ++y) {
+        for (int_type z = 0; z < dim_z; ++z) {
+            for (int_type x = 0; x < dim_x; ++x) {
+                const auto dx = x - 0.5f * (dim_x - 1);
+                const auto dy = y - 0.5f * (dim_y - 1);
+                const auto dz = z - 0.5f * (dim_z - 1);
+                grid[x + z * dim_x + y * dim_x * dim_z] =
+                    r - std::sqrt(dx * dx + dy * dy + dz * dz);
+            }
+        }
+    }
+    return grid;
+}
+
+// Samples the plane pos[axis] = level, positive beyond it, in the marching
+// cubes layout x + z * dim_x + y * dim_x * dim_z
+std::vector<float> CreatePlane(const int_type* dim, const int axis,
+                               const float level) {
+
+    std::vector<float> grid(dim[0] * dim[1] * dim[2]);
+    for (int_type y = 0; y < dim[1]; ++y) {
+        for (int_type z = 0; z < dim[2]; ++z) {
+            for (int_type x = 0; x < dim[0]; ++x) {
+                const int_type pos[] = {x, y, z};
+                grid[x + z * dim[0] + y * dim[0] * dim[2]] =
+                    static_cast<float>(pos[axis]) - level;
+            }
+        }
+    }
+    return grid;
+}
+
+double SurfaceArea(const MarchingCubes::triangle_vector_type& triangles) {
+
+    double area = 0.0;
+    for (const auto& tri : triangles) {
+        const auto& a = tri.comp.v1;
+        const auto& b = tri.comp.v2;
+        const auto& c = tri.comp.v3;
+        const ret::vec3f u(b.x - a.x, b.y - a.y, b.z - a.z);
+        const ret::vec3f v(c.x - a.x, c.y - a.y, c.z - a.z);
+        const auto n = u.cross(v);
+        area += 0.5 * std::sqrt(n.x * n.x + n.y * n.y + n.z * n.z);
+    }
+    return area;
+}
+}
+
+TEST(MarchingCubesTest, ParallelExtractionEqualsSerialExtraction) {
+
+    const int_type dims[] = {31, 32, 33};
+    for (const auto dim_y : dims) {
+        const auto grid = CreateSphere(32, dim_y, 33, 14.0f);
+        MarchingCubes serial(0.0f, 0.0f, 0.0f, 1.0f, 1.0f, 1.0f, 0.0f, 32,
+                             dim_y, 33);
+        serial.execute(grid.data());
+        ASSERT_EQ(serial.getNumThreads(), 1u);
+        ASSERT_GT(serial.getTriangles().size(), 0u);
+
+        for (const std::size_t num_threads : {2, 3, 8, 64}) {
+            MarchingCubes parallel(0.0f, 0.0f, 0.0f, 1.0f, 1.0f, 1.0f, 0.0f,
+                                   32, dim_y, 33);
+            parallel.setNumThreads(num_threads);
+            parallel.execute(grid.data());
+            ASSERT_TRUE(serial.getTriangles() == parallel.getTriangles());
+        }
+    }
+}
+
+TEST(MarchingCubesTest, LastSlicesAreTriangulated) {
+
+    // a plane within the last layer of cubes along each axis
+    const int_type dim[]     = {6, 8, 6};
+    const float voxel_size[] = {0.5f, 2.0f, 0.25f};
+    for (auto axis = 0; axis < 3; ++axis) {
+        std::vector<float> grid(dim[0] * dim[1] * dim[2]);
+        for (int_type y = 0; y < dim[1]; ++y) {
+            for (int_type z = 0; z < dim[2]; ++z) {
+                for (int_type x = 0; x < dim[0]; ++x) {
+                    const int_type pos[] = {x, y, z};
+                    grid[x + z * dim[0] + y * dim[0] * dim[2]] =
+                        static_cast<float>(pos[axis]) - (dim[axis] - 1.5f);
+                }
+            }
+        }
+
+        MarchingCubes mc(1.0f, 2.0f, 3.0f, voxel_size[0], voxel_size[1],
+                         voxel_size[2], 0.0f, dim[0], dim[1], dim[2]);
+        mc.setNumThreads(2);
+        mc.execute(grid.data());
+
+        auto expected = 1.0;
+        for (auto other = 0; other < 3; ++other) {
+            if (other != axis) {
+                expected *= (dim[other] - 1) * voxel_size[other];
+            }
+        }
+        ASSERT_NEAR(SurfaceArea(mc.getTriangles()), expected, 1e-4);
+    }
+}
+
+TEST(MarchingCubesTest, IndexedMeshEqualsTriangles) {
+
+    const auto grid = CreateSphere(32, 31, 33, 14.0f);
+    MarchingCubes mc(0.0f, 0.0f, 0.0f, 1.0f, 1.0f, 1.0f, 0.0f, 32, 31, 33);
+    mc.execute(grid.data());
+    mc.executeIndexed(grid.data());
+
+    const auto& triangles = mc.getTriangles();
+    const auto& vertices  = mc.getVertices();
+    const auto& indices   = mc.getIndices();
+    ASSERT_EQ(indices.size(), 3 * triangles.size());
+    ASSERT_EQ(mc.getNormals().size(), vertices.size());
+    // each vertex of a closed surface is shared by about six triangles
+    ASSERT_LT(4 * vertices.size(), indices.size());
+
+    for (std::size_t idx = 0; idx < triangles.size(); ++idx) {
+        const ret::vec3f* corners[] = {&triangles[idx].comp.v1,
+                                       &triangles[idx].comp.v2,
+                                       &triangles[idx].comp.v3};
+        for (std::size_t corner = 0; corner < 3; ++corner) {
+            const auto& v = vertices[indices[3 * idx + corner]];
+            ASSERT_NEAR(v.x, corners[corner]->x, 1e-4);
+            ASSERT_NEAR(v.y, corners[corner]->y, 1e-4);
+            ASSERT_NEAR(v.z, corners[corner]->z, 1e-4);
+        }
+    }
+}
+
+TEST(MarchingCubesTest, ParallelIndexedExtractionEqualsSerialExtraction) {
+
+    const auto grid = CreateSphere(32, 32, 33, 14.0f);
+    MarchingCubes serial(0.0f, 0.0f, 0.0f, 1.0f, 1.0f, 1.0f, 0.0f, 32, 32,
+                         33);
+    serial.executeIndexed(grid.data());
+
+    for (const std::size_t num_threads : {2, 3, 8}) {
+        MarchingCubes parallel(0.0f, 0.0f, 0.0f, 1.0f, 1.0f, 1.0f, 0.0f, 32,
+                               32, 33);
+        parallel.setNumThreads(num_threads);
+        parallel.executeIndexed(grid.data());
+        ASSERT_TRUE(serial.getVertices() == parallel.getVertices());
+        ASSERT_TRUE(serial.getNormals() == parallel.getNormals());
+        ASSERT_TRUE(serial.getIndices() == parallel.getIndices());
+    }
+}
+
+TEST(MarchingCubesTest, IndexedNormalsPointTowardsLowerValues) {
+
+    const auto grid = CreateSphere(32, 32, 32, 14.0f);
+    MarchingCubes mc(0.0f, 0.0f, 0.0f, 1.0f, 1.0f, 1.0f, 0.0f, 32, 32, 32);
+    mc.executeIndexed(grid.data());
+
+    const auto& vertices = mc.getVertices();
+    const auto& normals  = mc.getNormals();
+    for (std::size_t idx = 0; idx < vertices.size(); ++idx) {
+        const auto& v = vertices[idx];
+        const auto& n = normals[idx];
+        const auto radial =
+            (n.x * (v.x - 15.5f) + n.y * (v.y - 15.5f) + n.z * (v.z - 15.5f)) /
+            14.0f;
+        ASSERT_GT(radial, 0.9f);
+    }
+}
+
+TEST(MarchingCubesTest, LastColumnAlongXIsTriangulated) {
+
+    // the plane lies within the last layer of cubes along x, an even
+    // number of cubes along z is processed in pairs of z-slices only
+    const int_type dim[] = {6, 8, 7};
+    const auto grid      = CreatePlane(dim, 0, dim[0] - 1.5f);
+    MarchingCubes mc(1.0f, 2.0f, 3.0f, 0.5f, 2.0f, 0.25f, 0.0f, dim[0],
+                     dim[1], dim[2]);
+    mc.execute(grid.data());
+    ASSERT_NEAR(SurfaceArea(mc.getTriangles()),
+                (dim[1] - 1) * 2.0 * (dim[2] - 1) * 0.25, 1e-4);
+}
+
+TEST(MarchingCubesTest, LastSliceAlongZUsesVoxelDepth) {
+
+    // an odd number of cubes along z leaves a single remaining z-slice
+    const int_type dim[] = {6, 8, 6};
+    const auto grid      = CreatePlane(dim, 1, 3.5f);
+    MarchingCubes mc(1.0f, 2.0f, 3.0f, 0.5f, 2.0f, 0.25f, 0.0f, dim[0],
+                     dim[1], dim[2]);
+    mc.execute(grid.data());
+    ASSERT_NEAR(SurfaceArea(mc.getTriangles()),
+                (dim[0] - 1) * 0.5 * (dim[2] - 1) * 0.25, 1e-4);
+    for (const auto& tri : mc.getTriangles()) {
+        for (const auto& v : {tri.comp.v1, tri.comp.v2, tri.comp.v3}) {
+            ASSERT_LE(v.z, 3.0f + (dim[2] - 1) * 0.25f + 1e-5f);
+        }
+    }
+}
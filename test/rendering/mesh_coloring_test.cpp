@@ -0,0 +1,144 @@
+// Copyright (c) 2015-2016, Kai Wolf
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+
+#include <gtest/gtest.h>
+#include <vtkPointData.h>
+#include <vtkPolyData.h>
+#include <vtkSmartPointer.h>
+#include <vtkUnsignedCharArray.h>
+
+#include "common/dataset.hpp"
+#include "filtering/preprocessing.hpp"
+#include "io/assets_path.hpp"
+#include "io/dataset_reader.hpp"
+#include "rendering/bounding_box.hpp"
+#include "rendering/depth_buffer.hpp"
+#include "rendering/mesh_coloring.hpp"
+#include "rendering/projection_table.hpp"
+#include "rendering/voxel_carving.hpp"
+#include "rendering/vtk_utils.hpp"
+
+using namespace ret::rendering;
+using namespace ret::io;
+using namespace ret::filtering;
+
+class MeshColoringTest : public testing::Test {
+
+  public:
+    virtual void SetUp() {
+        DataSetReader dsr(std::string(ASSETS_PATH) + "/squirrel");
+        ds = dsr.load(NUM_IMGS);
+        Preprocess(*ds, cv::Scalar(0, 0, 30), 0, false);
+        BoundingBox bbox =
+            BoundingBox(ds->getCamera(0), ds->getCamera((NUM_IMGS / 4) - 1));
+        VoxelCarving vc(bbox.getBounds(), VOXEL_DIM);
+        vc.carveAll(ds->getCameras());
+        mesh = vc.createVisualHull();
+    }
+
+    vtkSmartPointer<vtkPolyData> colorize(const std::size_t num_threads) {
+        auto copy = vtkSmartPointer<vtkPolyData>::New();
+        copy->DeepCopy(mesh);
+        Colorize(copy, ds->getCameras(), num_threads);
+        return copy;
+    }
+
+    std::shared_ptr<ret::DataSet> ds;
+    vtkSmartPointer<vtkPolyData> mesh;
+    const std::size_t VOXEL_DIM = 64;
+    const std::size_t NUM_IMGS  = 36;
+};
+
+TEST_F(MeshColoringTest, ColorsEveryVertex) {
+
+    const auto colored = colorize(1);
+    const auto colors  = vtkUnsignedCharArray::SafeDownCast(
+        colored->GetPointData()->GetScalars());
+    ASSERT_NE(colors, nullptr);
+    ASSERT_STREQ(colors->GetName(), "Colors");
+    ASSERT_EQ(colors->GetNumberOfComponents(), 3);
+    ASSERT_EQ(colors->GetNumberOfTuples(), mesh->GetNumberOfPoints());
+}
+
+TEST_F(MeshColoringTest, ParallelEqualsSerial) {
+
+    const auto serial = vtkUnsignedCharArray::SafeDownCast(
+        colorize(1)->GetPointData()->GetScalars());
+    for (auto num_threads : {2, 3, 8}) {
+        const auto parallel = vtkUnsignedCharArray::SafeDownCast(
+            colorize(static_cast<std::size_t>(num_threads))
+                ->GetPointData()
+                ->GetScalars());
+        ASSERT_EQ(parallel->GetNumberOfTuples(),
+                  serial->GetNumberOfTuples());
+        for (vtkIdType i = 0; i < 3 * serial->GetNumberOfTuples(); ++i) {
+            ASSERT_EQ(parallel->GetValue(i), serial->GetValue(i));
+        }
+    }
+}
+
+TEST_F(MeshColoringTest, FirstCameraIsAlwaysBlended) {
+
+    const auto& cams   = ds->getCameras();
+    const auto colored = colorize(1);
+    const auto colors  = vtkUnsignedCharArray::SafeDownCast(
+        colored->GetPointData()->GetScalars());
+    const auto normals = mesh->GetPointData()->GetNormals();
+    const ProjectionTable table(cams);
+    const MeshVisibility visibility(mesh, cams, 1);
+
+    // weights as in the colorization without occlusion: the dot product
+    // of the first camera is used below 0.5 as well
+    std::size_t num_below = 0;
+    for (vtkIdType idx = 0; idx < mesh->GetNumberOfPoints(); ++idx) {
+        const auto i          = static_cast<std::size_t>(idx);
+        const auto vertex     = ret::GetVertex(mesh, i);
+        const auto normal     = ret::GetNormal(normals, i);
+        double sum[3]         = {0.0, 0.0, 0.0};
+        std::size_t num_views = 0;
+        for (std::size_t c = 0; c < cams.size(); ++c) {
+            const auto dot = normal.dot(table.getDirection(c));
+            if ((c != 0 && dot < 0.5) || !visibility.isVisible(c, i)) {
+                continue;
+            }
+            const auto pix = table.project<cv::Point2f, cv::Point3d>(c, vertex);
+            const cv::Vec3b col =
+                cams[c].getImage().at<cv::Vec3b>(pix.y, pix.x) *
+                std::max(dot, 0.0);
+            for (auto ch = 0; ch < 3; ++ch) {
+                sum[ch] += col[2 - ch];
+            }
+            ++num_views;
+            num_below += c == 0 && dot < 0.5 ? 1 : 0;
+        }
+        if (num_views == 0) {
+            continue;
+        }
+        for (auto ch = 0; ch < 3; ++ch) {
+            ASSERT_EQ(colors->GetValue(3 * idx + ch),
+                      static_cast<unsigned char>(sum[ch] / num_views));
+        }
+    }
+    ASSERT_GT(num_below, 0u);
+}
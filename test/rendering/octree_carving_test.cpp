@@ -0,0 +1,108 @@
+// Copyright (c) 2015-2016, Kai Wolf
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include <cstddef>
+#include <memory>
+
+#include <gtest/gtest.h>
+#include <vtkPolyData.h>
+#include <vtkSmartPointer.h>
+
+#include "common/dataset.hpp"
+#include "common/utils.hpp"
+#include "filtering/segmentation.hpp"
+#include "io/assets_path.hpp"
+#include "io/dataset_reader.hpp"
+#include "rendering/bounding_box.hpp"
+#include "rendering/octree_carving.hpp"
+#include "rendering/sparse_voxel_grid.hpp"
+#include "rendering/voxel_carving.hpp"
+
+using namespace ret::rendering;
+using namespace ret::io;
+using namespace ret::filtering;
+
+class OctreeCarvingTest : public testing::Test {
+
+  public:
+    virtual void SetUp() {
+        DataSetReader dsr(std::string(ASSETS_PATH) + "/squirrel");
+        ds = dsr.load(NUM_IMGS);
+        for (std::size_t i = 0; i < NUM_IMGS; ++i) {
+            ds->getCamera(i).setMask(Binarize(
+                ds->getCamera(i).getImage(), cv::Scalar(0, 0, 30)));
+        }
+        BoundingBox bbox =
+            BoundingBox(ds->getCamera(0), ds->getCamera((NUM_IMGS / 4) - 1));
+        bounds = bbox.getBounds();
+        oc = ret::make_unique<OctreeCarving>(bounds, VOXEL_DIM);
+    }
+
+    std::shared_ptr<ret::DataSet> ds;
+    bb_bounds bounds;
+    std::unique_ptr<OctreeCarving> oc;
+    const std::size_t VOXEL_DIM = 128;
+    const std::size_t NUM_IMGS = 36;
+};
+
+TEST_F(OctreeCarvingTest, SignsEqualDenseCarving) {
+
+    VoxelCarving vc(bounds, VOXEL_DIM);
+    vc.carveAll(ds->getCameras());
+    oc->carve(ds->getCameras());
+
+    const auto& grid   = oc->getVoxelGrid();
+    const auto B       = SparseVoxelGrid::BRICK_SIZE;
+    const float* dense = vc.getVoxelGrid();
+    for (std::size_t i = 0; i < VOXEL_DIM; ++i) {
+        for (std::size_t j = 0; j < VOXEL_DIM; ++j) {
+            for (std::size_t k = 0; k < VOXEL_DIM; ++k) {
+                const auto expected =
+                    dense[k + j * VOXEL_DIM + i * VOXEL_DIM * VOXEL_DIM];
+                const auto actual = grid.at(i, j, k);
+                ASSERT_EQ(expected > 0.0f, actual > 0.0f);
+                ASSERT_EQ(expected < 0.0f, actual < 0.0f);
+                if (grid.isAllocated(grid.getBrickIdx(i / B, j / B, k / B))) {
+                    ASSERT_EQ(expected, actual);
+                }
+            }
+        }
+    }
+}
+
+TEST_F(OctreeCarvingTest, OnlyBoundaryBricksAreAllocated) {
+
+    oc->carve(ds->getCameras());
+
+    const auto& grid      = oc->getVoxelGrid();
+    const auto brick_dim  = grid.getBrickDim();
+    const auto num_bricks = brick_dim * brick_dim * brick_dim;
+    ASSERT_GT(grid.getNumAllocated(), 0u);
+    ASSERT_LT(grid.getNumAllocated(), num_bricks / 2);
+}
+
+TEST_F(OctreeCarvingTest, CreateVisualHull) {
+
+    oc->setNumThreads(4);
+    oc->carve(ds->getCameras());
+    auto mesh = oc->createVisualHull();
+    ASSERT_GT(mesh->GetNumberOfPoints(), 0);
+    ASSERT_GT(mesh->GetNumberOfPolys(), 0);
+}
@@ -0,0 +1,112 @@
+// Copyright (c) 2015-2016, Kai Wolf
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include <cstdint>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include <opencv2/core/core.hpp>
+
+#include "common/camera.hpp"
+#include "common/dataset.hpp"
+#include "io/assets_path.hpp"
+#include "io/dataset_reader.hpp"
+#include "rendering/cv_utils.hpp"
+#include "rendering/projection_table.hpp"
+
+using namespace ret;
+using namespace ret::io;
+using namespace ret::rendering;
+
+class ProjectionTableTest : public testing::Test {
+  public:
+    virtual void SetUp() {
+        DataSetReader dsr(std::string(ASSETS_PATH) + "/squirrel");
+        dsr.setImageLoading(image_loading::Lazy);
+        ds = dsr.load(NUM_IMGS);
+    }
+
+    std::shared_ptr<DataSet> ds;
+    const std::size_t NUM_IMGS = 12;
+};
+
+TEST_F(ProjectionTableTest, EmptyTable) {
+
+    const ProjectionTable table;
+    ASSERT_EQ(table.size(), 0u);
+    table.projectAll(cv::Point3f(1.0f, 2.0f, 3.0f), nullptr, nullptr);
+}
+
+TEST_F(ProjectionTableTest, RowsAreAligned) {
+
+    const ProjectionTable table(*ds);
+    ASSERT_EQ(table.size(), NUM_IMGS);
+    ASSERT_EQ(table.getStride() % 8, 0u);
+    ASSERT_GE(table.getStride(), NUM_IMGS);
+    for (auto r = 0; r < ProjectionTable::NUM_ROWS; ++r) {
+        const auto row = table.getRow(static_cast<ProjectionTable::row>(r));
+        ASSERT_EQ(reinterpret_cast<std::uintptr_t>(row) % 32, 0u);
+    }
+}
+
+TEST_F(ProjectionTableTest, ProjectEqualsProjectionMatrix) {
+
+    const auto& cams = ds->getCameras();
+    const ProjectionTable table(cams);
+    const std::vector<cv::Point3d> points = {cv::Point3d(0.0, 0.0, 0.0),
+                                             cv::Point3d(10.5, -3.25, 20.0),
+                                             cv::Point3d(-7.0, 12.0, 5.5)};
+    std::vector<float> x(table.size()), y(table.size());
+    for (const auto& pt : points) {
+        table.projectAll(cv::Point3f(pt), x.data(), y.data());
+        for (std::size_t c = 0; c < cams.size(); ++c) {
+            const auto expected =
+                project<cv::Point2f, cv::Point3d>(cams[c], pt);
+            const auto actual =
+                table.project<cv::Point2f, cv::Point3d>(c, pt);
+            ASSERT_EQ(expected.x, actual.x);
+            ASSERT_EQ(expected.y, actual.y);
+
+            const auto expected_f = project<cv::Point2f, cv::Point3f>(
+                cams[c], cv::Point3f(pt));
+            ASSERT_FLOAT_EQ(expected_f.x, x[c]);
+            ASSERT_FLOAT_EQ(expected_f.y, y[c]);
+        }
+    }
+}
+
+TEST_F(ProjectionTableTest, CentersAndDirections) {
+
+    const auto& cams = ds->getCameras();
+    const ProjectionTable table(cams);
+    const cv::Vec3d normal(0.0, 0.6, 0.8);
+    std::vector<double> dots(table.size());
+    table.dotDirections(normal, dots.data());
+    for (std::size_t c = 0; c < cams.size(); ++c) {
+        const auto center = cams[c].getCenter();
+        ASSERT_NEAR(table.getCenter(c).x, center.x, 1e-4 * cv::norm(center));
+        ASSERT_NEAR(table.getCenter(c).y, center.y, 1e-4 * cv::norm(center));
+        ASSERT_NEAR(table.getCenter(c).z, center.z, 1e-4 * cv::norm(center));
+
+        const cv::Vec3d dir = cams[c].getDirection();
+        ASSERT_TRUE(table.getDirection(c) == dir);
+        ASSERT_DOUBLE_EQ(dots[c], normal.dot(dir));
+    }
+}
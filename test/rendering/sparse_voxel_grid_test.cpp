@@ -0,0 +1,88 @@
+// Copyright (c) 2015-2016, Kai Wolf
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include <cstddef>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "rendering/sparse_voxel_grid.hpp"
+
+using namespace ret::rendering;
+
+TEST(SparseVoxelGridTest, UniformBricksAreNotAllocated) {
+
+    SparseVoxelGrid grid(20, 1.0f);
+    ASSERT_EQ(grid.getVoxelDim(), 20u);
+    ASSERT_EQ(grid.getBrickDim(), 3u);
+    ASSERT_EQ(grid.getNumAllocated(), 0u);
+    ASSERT_TRUE(grid.getBrick(grid.getBrickIdx(2, 1, 0)) == nullptr);
+    ASSERT_FLOAT_EQ(grid.at(19, 10, 0), 1.0f);
+
+    grid.setUniform(grid.getBrickIdx(2, 1, 0), -1.0f);
+    ASSERT_FLOAT_EQ(grid.at(19, 10, 0), -1.0f);
+    ASSERT_FLOAT_EQ(grid.at(15, 10, 0), 1.0f);
+}
+
+TEST(SparseVoxelGridTest, AllocatedBricksStoreEachVoxel) {
+
+    const auto B = SparseVoxelGrid::BRICK_SIZE;
+    SparseVoxelGrid grid(4 * B, 2.0f);
+    const auto brick = grid.getBrickIdx(1, 2, 3);
+    float* storage   = grid.allocate(brick);
+    ASSERT_TRUE(grid.isAllocated(brick));
+    ASSERT_EQ(grid.getNumAllocated(), 1u);
+    ASSERT_EQ(grid.getBrick(brick), storage);
+    ASSERT_EQ(grid.allocate(brick), storage);
+    ASSERT_FLOAT_EQ(grid.at(B + 1, 2 * B + 2, 3 * B + 3), 2.0f);
+
+    storage[3 + 2 * B + 1 * B * B] = 5.0f;
+    ASSERT_FLOAT_EQ(grid.at(B + 1, 2 * B + 2, 3 * B + 3), 5.0f);
+    ASSERT_FLOAT_EQ(grid.at(B + 1, 2 * B + 2, 3 * B + 4), 2.0f);
+
+    grid.setUniform(brick, -3.0f);
+    ASSERT_FALSE(grid.isAllocated(brick));
+    ASSERT_EQ(grid.getNumAllocated(), 0u);
+    ASSERT_FLOAT_EQ(grid.at(B + 1, 2 * B + 2, 3 * B + 3), -3.0f);
+}
+
+TEST(SparseVoxelGridTest, CopyBlockSpansSeveralBricks) {
+
+    const auto B = SparseVoxelGrid::BRICK_SIZE;
+    SparseVoxelGrid grid(3 * B, 1.0f);
+    grid.setUniform(grid.getBrickIdx(1, 1, 2), -1.0f);
+    float* storage = grid.allocate(grid.getBrickIdx(1, 1, 1));
+    for (std::size_t idx = 0; idx < SparseVoxelGrid::BRICK_VOXELS; ++idx) {
+        storage[idx] = static_cast<float>(idx);
+    }
+
+    const std::size_t i0 = B - 1, j0 = B, k0 = B + 2;
+    const std::size_t dim_i = 3, dim_j = 2, dim_k = B + 1;
+    std::vector<float> block(dim_i * dim_j * dim_k);
+    grid.copyBlock(i0, j0, k0, dim_i, dim_j, dim_k, block.data());
+    for (std::size_t i = 0; i < dim_i; ++i) {
+        for (std::size_t j = 0; j < dim_j; ++j) {
+            for (std::size_t k = 0; k < dim_k; ++k) {
+                ASSERT_EQ(block[k + j * dim_k + i * dim_k * dim_j],
+                          grid.at(i0 + i, j0 + j, k0 + k));
+            }
+        }
+    }
+}
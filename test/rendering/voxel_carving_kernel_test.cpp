@@ -0,0 +1,151 @@
+// Copyright (c) 2015-2016, Kai Wolf
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include <cfloat>
+#include <cmath>
+#include <cstddef>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include <opencv2/core/core.hpp>
+
+#include "rendering/cv_utils.hpp"
+#include "rendering/voxel_carving.hpp"
+#include "rendering/voxel_carving_kernel.hpp"
+
+using namespace ret::rendering;
+
+class VoxelCarvingKernelTest : public testing::Test {
+
+  public:
+    virtual void SetUp() {
+        cv::Mat Mask(240, 320, CV_8U);
+        cv::Mat DistImage(240, 320, CV_32F);
+        cv::randu(Mask, cv::Scalar(0), cv::Scalar(2));
+        cv::randu(DistImage, cv::Scalar(0.0f), cv::Scalar(100.0f));
+        Mask *= 255;
+
+        cv::Mat P = (cv::Mat_<float>(3, 4) << 400.0f, 10.0f, 160.0f, 50.0f,
+                     -5.0f, 410.0f, 120.0f, 30.0f, 0.01f, 0.02f, 1.0f, 3.0f);
+        view = CreateCarveView(P, Mask, DistImage);
+
+        params.start_x      = -1.2f;
+        params.start_y      = -1.1f;
+        params.start_z      = 0.5f;
+        params.voxel_width  = 0.0191f;
+        params.voxel_height = 0.0187f;
+        params.voxel_depth  = 0.013f;
+    }
+
+    carve_view view;
+    start_params params;
+    const std::size_t VOXEL_DIM = 131;
+};
+
+TEST_F(VoxelCarvingKernelTest, SignedDistMapIsNegativeOutside) {
+
+    cv::Mat Mask(2, 2, CV_8U, cv::Scalar::all(0));
+    cv::Mat DistImage(2, 2, CV_32F, cv::Scalar::all(3.0f));
+    Mask.at<uchar>(1, 0) = 255;
+    auto v = CreateCarveView(cv::Mat(3, 4, CV_32F, cv::Scalar::all(0)), Mask,
+                             DistImage);
+
+    ASSERT_EQ(4u, v.signed_dist.size());
+    ASSERT_FLOAT_EQ(3.0f, v.signed_dist[0]);
+    ASSERT_FLOAT_EQ(-3.0f, v.signed_dist[2]);
+}
+
+TEST_F(VoxelCarvingKernelTest, VoxelsOutsideOfImageAreCarved) {
+
+    // a degenerate projection never yields valid image coordinates
+    cv::Mat P(3, 4, CV_32F, cv::Scalar::all(0));
+    auto v = CreateCarveView(P, cv::Mat(240, 320, CV_8U, cv::Scalar::all(0)),
+                             cv::Mat(240, 320, CV_32F, cv::Scalar::all(1)));
+
+    std::vector<float> row(VOXEL_DIM, FLT_MAX);
+    CarveRow(v, params, 0, 0, 0, VOXEL_DIM, row.data());
+    for (const auto voxel : row) {
+        ASSERT_FLOAT_EQ(-1.0f, voxel);
+    }
+}
+
+TEST_F(VoxelCarvingKernelTest, SIMDKernelsEqualScalarKernel) {
+
+    const auto max_isa = static_cast<int>(GetCarveISA());
+    for (auto isa = 1; isa <= max_isa; ++isa) {
+        for (std::size_t i = 0; i < VOXEL_DIM; i += 7) {
+            for (std::size_t j = 0; j < VOXEL_DIM; ++j) {
+                // odd start to exercise the scalar remainder as well
+                for (std::size_t k_begin : {0, 3}) {
+                    std::vector<float> expected(VOXEL_DIM, FLT_MAX);
+                    std::vector<float> actual(VOXEL_DIM, FLT_MAX);
+                    CarveRow(carve_isa::Scalar, view, params, i, j, k_begin,
+                             VOXEL_DIM, expected.data());
+                    CarveRow(static_cast<carve_isa>(isa), view, params, i, j,
+                             k_begin, VOXEL_DIM, actual.data());
+                    ASSERT_EQ(expected, actual)
+                        << GetCarveISAName(static_cast<carve_isa>(isa));
+                }
+            }
+        }
+    }
+}
+
+TEST_F(VoxelCarvingKernelTest, IncrementalProjectionMatchesFullProjection) {
+
+    // first camera of the squirrel dataset and a grid around the object
+    cv::Mat P = (cv::Mat_<float>(3, 4) << 1.65893958e+03f, 5.84985229e+02f,
+                 -3.71738586e+01f, 3.82956055e+04f, 1.05572014e+02f,
+                 1.16911835e+02f, -1.70495264e+03f, 4.05876055e+04f,
+                 3.64293680e-02f, 9.76540625e-01f, -2.12229416e-01f,
+                 5.69148216e+01f);
+    auto v = CreateCarveView(P, cv::Mat(960, 1280, CV_8U, cv::Scalar::all(0)),
+                             cv::Mat(960, 1280, CV_32F, cv::Scalar::all(0)));
+
+    start_params grid;
+    grid.start_x      = -25.0f;
+    grid.start_y      = -25.0f;
+    grid.start_z      = 0.0f;
+    grid.voxel_width  = 50.0f / 256.0f;
+    grid.voxel_height = 50.0f / 256.0f;
+    grid.voxel_depth  = 40.0f / 256.0f;
+
+    // only voxels within the image matter for carving
+    const float tolerance = 1e-3f; // pixel
+    for (std::size_t i = 0; i < 256; i += 5) {
+        for (std::size_t j = 0; j < 256; j += 3) {
+            for (std::size_t k = 0; k < 256; ++k) {
+                const cv::Point3f voxel(
+                    grid.start_x + static_cast<float>(k) * grid.voxel_width,
+                    grid.start_y + static_cast<float>(j) * grid.voxel_height,
+                    grid.start_z + static_cast<float>(i) * grid.voxel_depth);
+                const auto expected =
+                    ret::project<cv::Point2f, cv::Point3f>(P, voxel);
+                if (expected.x < 0 || expected.y < 0 ||
+                    expected.x > 1280 || expected.y > 960) {
+                    continue;
+                }
+                const auto actual = ProjectVoxel(v, grid, i, j, k);
+                ASSERT_NEAR(expected.x, actual.x, tolerance);
+                ASSERT_NEAR(expected.y, actual.y, tolerance);
+            }
+        }
+    }
+}
@@ -18,42 +18,424 @@
 // OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
 // SOFTWARE.
 
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
 #include <memory>
+#include <stdexcept>
 #include <utility>
 #include <tuple>
+#include <vector>
 
+#include <boost/filesystem.hpp>
 #include <gtest/gtest.h>
+#include <vtkPointData.h>
+#include <vtkPolyData.h>
+#include <vtkSmartPointer.h>
 
+#include "rendering/carving_pipeline.hpp"
 #include "rendering/voxel_carving.hpp"
+#include "rendering/surface_extraction.hpp"
+#include "rendering/voxel_type.hpp"
 #include "rendering/bounding_box.hpp"
 #include "common/utils.hpp"
 #include "common/dataset.hpp"
 #include "io/dataset_reader.hpp"
 #include "io/assets_path.hpp"
+#include "filtering/dist_map_cache.hpp"
 #include "filtering/segmentation.hpp"
 
 using namespace ret::rendering;
 using namespace ret::io;
 using namespace ret::filtering;
 
+namespace {
+
+// Returns the enclosed volume and the surface area of a triangle mesh
+std::pair<double, double> MeasureMesh(
+    const std::vector<ret::triangle>& triangles) {
+
+    double volume = 0.0, area = 0.0;
+    for (const auto& tri : triangles) {
+        const auto& a = tri.comp.v1;
+        const auto& b = tri.comp.v2;
+        const auto& c = tri.comp.v3;
+        volume += a.x * (b.y * c.z - b.z * c.y) -
+                  a.y * (b.x * c.z - b.z * c.x) +
+                  a.z * (b.x * c.y - b.y * c.x);
+        const ret::vec3f u(b.x - a.x, b.y - a.y, b.z - a.z);
+        const ret::vec3f v(c.x - a.x, c.y - a.y, c.z - a.z);
+        const auto n = u.cross(v);
+        area += std::sqrt(n.x * n.x + n.y * n.y + n.z * n.z);
+    }
+    return std::make_pair(volume / 6.0, area / 2.0);
+}
+
+template <typename T>
+std::pair<double, double> MeasureVoxelMesh(const void* data,
+                                           const std::size_t dim) {
+
+    const start_params params = {0.0f, 0.0f, 0.0f, 1.0f, 1.0f, 1.0f};
+    std::vector<ret::triangle> triangles;
+    ExtractSurface(static_cast<const T*>(data), dim, dim, dim, params, 0.0f,
+                   triangles);
+    return MeasureMesh(triangles);
+}
+}
+
 class VoxelCarvingTest : public testing::Test {
 
   public:
     virtual void SetUp() {
         DataSetReader dsr(std::string(ASSETS_PATH) + "/squirrel");
-        auto ds = dsr.load(NUM_IMGS);
+        ds = dsr.load(NUM_IMGS);
         for (std::size_t i = 0; i < NUM_IMGS; ++i) {
             ds->getCamera(i).setMask(Binarize(
                 ds->getCamera(i).getImage(), cv::Scalar(0, 0, 30)));
         }
         BoundingBox bbox =
             BoundingBox(ds->getCamera(0), ds->getCamera((NUM_IMGS / 4) - 1));
-        vc = ret::make_unique<VoxelCarving>(bbox.getBounds(), VOXEL_DIM);
+        bounds = bbox.getBounds();
+        vc = ret::make_unique<VoxelCarving>(bounds, VOXEL_DIM);
     }
 
+    std::shared_ptr<ret::DataSet> ds;
+    bb_bounds bounds;
     std::unique_ptr<VoxelCarving> vc;
     const std::size_t VOXEL_DIM = 128;
     const std::size_t NUM_IMGS = 36;
 };
 
 TEST_F(VoxelCarvingTest, Carve) {}
+
+TEST_F(VoxelCarvingTest, ParallelCarvingEqualsSerialCarving) {
+
+    auto serial = ret::make_unique<VoxelCarving>(bounds, VOXEL_DIM);
+    serial->setNumThreads(1);
+    vc->setNumThreads(4);
+    for (const auto& cam : ds->getCameras()) {
+        serial->carve(cam);
+        vc->carve(cam);
+    }
+
+    const auto num_voxels = VOXEL_DIM * VOXEL_DIM * VOXEL_DIM;
+    ASSERT_EQ(vc->getVoxelDim(), VOXEL_DIM);
+    ASSERT_TRUE(std::equal(serial->getVoxelGrid(),
+                           serial->getVoxelGrid() + num_voxels,
+                           vc->getVoxelGrid()));
+}
+
+TEST_F(VoxelCarvingTest, CarveAllEqualsCarvingEachCamera) {
+
+    auto single = ret::make_unique<VoxelCarving>(bounds, VOXEL_DIM);
+    for (const auto& cam : ds->getCameras()) {
+        single->carve(cam);
+    }
+    vc->carveAll(ds->getCameras());
+
+    const auto num_voxels = VOXEL_DIM * VOXEL_DIM * VOXEL_DIM;
+    ASSERT_TRUE(std::equal(single->getVoxelGrid(),
+                           single->getVoxelGrid() + num_voxels,
+                           vc->getVoxelGrid()));
+}
+
+TEST_F(VoxelCarvingTest, BatchedCarveAllEqualsCarveAll) {
+
+    // a limit below the size of a single view carves one camera per batch
+    auto batched = ret::make_unique<VoxelCarving>(bounds, VOXEL_DIM);
+    batched->setViewMemoryLimit(1);
+    ASSERT_EQ(batched->getViewMemoryLimit(), 1u);
+    batched->carveAll(ds->getCameras());
+    vc->carveAll(ds->getCameras());
+
+    const auto num_voxels = VOXEL_DIM * VOXEL_DIM * VOXEL_DIM;
+    ASSERT_TRUE(std::equal(batched->getVoxelGrid(),
+                           batched->getVoxelGrid() + num_voxels,
+                           vc->getVoxelGrid()));
+}
+
+TEST_F(VoxelCarvingTest, NarrowBandEqualsClampedDenseCarving) {
+
+    const float band = 10.0f;
+    auto narrow = ret::make_unique<VoxelCarving>(bounds, VOXEL_DIM, band);
+    ASSERT_FLOAT_EQ(narrow->getNarrowBand(), band);
+    ASSERT_TRUE(narrow->getVoxelGrid() == nullptr);
+    for (const auto& cam : ds->getCameras()) {
+        narrow->carve(cam);
+    }
+    vc->carveAll(ds->getCameras());
+
+    const auto num_voxels = VOXEL_DIM * VOXEL_DIM * VOXEL_DIM;
+    std::vector<float> block(num_voxels);
+    narrow->copyBlock(0, 0, 0, VOXEL_DIM, VOXEL_DIM, VOXEL_DIM, block.data());
+    for (std::size_t idx = 0; idx < num_voxels; ++idx) {
+        const auto clamped =
+            std::min(std::max(vc->getVoxelGrid()[idx], -band), band);
+        ASSERT_EQ(clamped, block[idx]);
+    }
+
+    const auto grid       = narrow->getSparseVoxelGrid();
+    const auto brick_dim  = grid->getBrickDim();
+    const auto num_bricks = brick_dim * brick_dim * brick_dim;
+    ASSERT_LT(grid->getNumAllocated(), num_bricks / 2);
+    ASSERT_LT(narrow->getMemoryUsage(), vc->getMemoryUsage());
+}
+
+TEST_F(VoxelCarvingTest, NarrowBandCarveAllEqualsCarvingEachCamera) {
+
+    const float band = 10.0f;
+    auto single = ret::make_unique<VoxelCarving>(bounds, VOXEL_DIM, band);
+    auto fused  = ret::make_unique<VoxelCarving>(bounds, VOXEL_DIM, band);
+    for (const auto& cam : ds->getCameras()) {
+        single->carve(cam);
+    }
+    fused->carveAll(ds->getCameras());
+
+    const auto num_voxels = VOXEL_DIM * VOXEL_DIM * VOXEL_DIM;
+    std::vector<float> expected(num_voxels), actual(num_voxels);
+    single->copyBlock(0, 0, 0, VOXEL_DIM, VOXEL_DIM, VOXEL_DIM,
+                      expected.data());
+    fused->copyBlock(0, 0, 0, VOXEL_DIM, VOXEL_DIM, VOXEL_DIM, actual.data());
+    ASSERT_TRUE(expected == actual);
+}
+
+TEST_F(VoxelCarvingTest, NarrowBandCreateVisualHull) {
+
+    auto narrow = ret::make_unique<VoxelCarving>(bounds, VOXEL_DIM, 10.0f);
+    narrow->carveAll(ds->getCameras());
+    auto mesh = narrow->createVisualHull();
+    ASSERT_GT(mesh->GetNumberOfPoints(), 0);
+    ASSERT_GT(mesh->GetNumberOfPolys(), 0);
+}
+
+TEST_F(VoxelCarvingTest, TypedGridsEqualRoundedDenseCarving) {
+
+    vc->carveAll(ds->getCameras());
+    const auto num_voxels = VOXEL_DIM * VOXEL_DIM * VOXEL_DIM;
+    std::vector<float> block(num_voxels);
+
+    auto half_vc =
+        ret::make_unique<VoxelCarving>(bounds, VOXEL_DIM, voxel_type::Half);
+    auto q15_vc =
+        ret::make_unique<VoxelCarving>(bounds, VOXEL_DIM, voxel_type::Q15);
+    ASSERT_TRUE(half_vc->getVoxelType() == voxel_type::Half);
+    ASSERT_TRUE(half_vc->getVoxelGrid() == nullptr);
+    ASSERT_EQ(2 * half_vc->getMemoryUsage(), vc->getMemoryUsage());
+    ASSERT_EQ(2 * q15_vc->getMemoryUsage(), vc->getMemoryUsage());
+    for (const auto& cam : ds->getCameras()) {
+        half_vc->carve(cam);
+    }
+    q15_vc->carveAll(ds->getCameras());
+
+    half_vc->copyBlock(0, 0, 0, VOXEL_DIM, VOXEL_DIM, VOXEL_DIM,
+                       block.data());
+    for (std::size_t idx = 0; idx < num_voxels; ++idx) {
+        const auto value = vc->getVoxelGrid()[idx];
+        ASSERT_EQ(VoxelToFloat(FloatToVoxel<ret::half>(value)), block[idx]);
+    }
+    q15_vc->copyBlock(0, 0, 0, VOXEL_DIM, VOXEL_DIM, VOXEL_DIM, block.data());
+    for (std::size_t idx = 0; idx < num_voxels; ++idx) {
+        const auto value = vc->getVoxelGrid()[idx];
+        ASSERT_EQ(VoxelToFloat(FloatToVoxel<q15>(value)), block[idx]);
+    }
+}
+
+TEST_F(VoxelCarvingTest, TypedGridsPreserveMesh) {
+
+    vc->carveAll(ds->getCameras());
+    const auto expected = MeasureVoxelMesh<float>(vc->getVoxelData(),
+                                                  VOXEL_DIM);
+    ASSERT_GT(expected.first, 0.0);
+
+    auto half_vc =
+        ret::make_unique<VoxelCarving>(bounds, VOXEL_DIM, voxel_type::Half);
+    half_vc->carveAll(ds->getCameras());
+    const auto half_mesh =
+        MeasureVoxelMesh<ret::half>(half_vc->getVoxelData(), VOXEL_DIM);
+    ASSERT_NEAR(half_mesh.first / expected.first, 1.0, 1e-4);
+    ASSERT_NEAR(half_mesh.second / expected.second, 1.0, 1e-4);
+
+    auto q15_vc =
+        ret::make_unique<VoxelCarving>(bounds, VOXEL_DIM, voxel_type::Q15);
+    q15_vc->carveAll(ds->getCameras());
+    const auto q15_mesh =
+        MeasureVoxelMesh<q15>(q15_vc->getVoxelData(), VOXEL_DIM);
+    ASSERT_NEAR(q15_mesh.first / expected.first, 1.0, 1e-3);
+    ASSERT_NEAR(q15_mesh.second / expected.second, 1.0, 1e-3);
+}
+
+TEST_F(VoxelCarvingTest, TypedGridsCreateVisualHull) {
+
+    const voxel_type types[] = {voxel_type::Half, voxel_type::Q15};
+    for (const auto type : types) {
+        auto typed = ret::make_unique<VoxelCarving>(bounds, VOXEL_DIM, type);
+        typed->carveAll(ds->getCameras());
+        auto mesh = typed->createVisualHull();
+        ASSERT_GT(mesh->GetNumberOfPoints(), 0);
+        ASSERT_GT(mesh->GetNumberOfPolys(), 0);
+    }
+}
+
+TEST_F(VoxelCarvingTest, InTreeBackendMatchesVtkBackend) {
+
+    vc->carveAll(ds->getCameras());
+    ASSERT_TRUE(vc->getSurfaceBackend() == surface_backend::Vtk);
+    auto vtk_mesh = vc->createVisualHull();
+    vc->setSurfaceBackend(surface_backend::InTree);
+    auto mesh = vc->createVisualHull();
+
+    // both create a single point per intersected grid edge
+    ASSERT_GT(mesh->GetNumberOfPolys(), 0);
+    ASSERT_NEAR(mesh->GetNumberOfPoints(), vtk_mesh->GetNumberOfPoints(),
+                0.01 * vtk_mesh->GetNumberOfPoints());
+    ASSERT_TRUE(mesh->GetPointData()->GetNormals() != nullptr);
+
+    double mesh_bounds[6], vtk_bounds[6];
+    mesh->GetBounds(mesh_bounds);
+    vtk_mesh->GetBounds(vtk_bounds);
+    const auto voxel_size =
+        (vtk_bounds[1] - vtk_bounds[0]) / static_cast<double>(VOXEL_DIM);
+    for (auto idx = 0; idx < 6; ++idx) {
+        ASSERT_NEAR(mesh_bounds[idx], vtk_bounds[idx], voxel_size);
+    }
+}
+
+TEST_F(VoxelCarvingTest, SharedVoxelGridOutlivesCarving) {
+
+    vc->carve(ds->getCamera(0));
+    auto grid = vc->shareVoxelGrid();
+    ASSERT_EQ(grid.getData(), vc->getVoxelData());
+    ASSERT_EQ(grid.getVoxelDim(), VOXEL_DIM);
+
+    // carving after sharing is visible through the handle
+    for (const auto& cam : ds->getCameras()) {
+        vc->carve(cam);
+    }
+    std::vector<ret::vec3f> vertices, normals;
+    std::vector<std::uint32_t> indices;
+    ExtractIndexedSurface(grid, 0.0f, vertices, normals, indices);
+    const auto num_vertices = vertices.size();
+    vc.reset();
+
+    ASSERT_EQ(grid.getUseCount(), 1);
+    ExtractIndexedSurface(grid, 0.0f, vertices, normals, indices);
+    ASSERT_GT(num_vertices, 0u);
+    ASSERT_EQ(vertices.size(), num_vertices);
+
+    auto narrow = ret::make_unique<VoxelCarving>(bounds, VOXEL_DIM, 2.0f);
+    ASSERT_TRUE(narrow->shareVoxelGrid().empty());
+}
+
+TEST_F(VoxelCarvingTest, DistMapCacheIsReusedAcrossResolutions) {
+
+    auto cache = std::make_shared<DistMapCache>();
+    auto cached = ret::make_unique<VoxelCarving>(bounds, VOXEL_DIM);
+    cached->setDistMapCache(cache);
+    cached->carveAll(ds->getCameras());
+    vc->carveAll(ds->getCameras());
+
+    const auto num_voxels = VOXEL_DIM * VOXEL_DIM * VOXEL_DIM;
+    ASSERT_TRUE(std::equal(vc->getVoxelGrid(),
+                           vc->getVoxelGrid() + num_voxels,
+                           cached->getVoxelGrid()));
+    ASSERT_EQ(cache->getMisses(), NUM_IMGS);
+    ASSERT_EQ(cache->getHits(), 0u);
+
+    auto coarse = ret::make_unique<VoxelCarving>(bounds, VOXEL_DIM / 2);
+    coarse->setDistMapCache(cache);
+    for (const auto& cam : ds->getCameras()) {
+        coarse->carve(cam);
+    }
+    ASSERT_EQ(cache->getMisses(), NUM_IMGS);
+    ASSERT_EQ(cache->getHits(), NUM_IMGS);
+}
+
+TEST_F(VoxelCarvingTest, StreamingCarvingEqualsCarvingEachCamera) {
+
+    for (const auto& cam : ds->getCameras()) {
+        vc->carve(cam);
+    }
+
+    DataSetReader dsr(std::string(ASSETS_PATH) + "/squirrel");
+    auto streamed = ret::make_unique<VoxelCarving>(bounds, VOXEL_DIM);
+    ASSERT_EQ(CarveStreaming(dsr, NUM_IMGS, cv::Scalar(0, 0, 30), *streamed),
+              NUM_IMGS);
+
+    const auto num_voxels = VOXEL_DIM * VOXEL_DIM * VOXEL_DIM;
+    ASSERT_TRUE(std::equal(vc->getVoxelGrid(),
+                           vc->getVoxelGrid() + num_voxels,
+                           streamed->getVoxelGrid()));
+}
+
+TEST_F(VoxelCarvingTest, MappedGridEqualsInMemoryGrid) {
+
+    const auto path = (boost::filesystem::temp_directory_path() /
+                       boost::filesystem::unique_path()).string();
+    vc->carveAll(ds->getCameras());
+    {
+        VoxelCarving mapped(bounds, VOXEL_DIM, voxel_type::Float, path);
+        for (const auto& cam : ds->getCameras()) {
+            mapped.carve(cam);
+        }
+        ASSERT_TRUE(mapped.save(path));
+    }
+
+    // resume from the file without carving again
+    VoxelCarving resumed(path);
+    ASSERT_EQ(resumed.getVoxelDim(), VOXEL_DIM);
+    ASSERT_TRUE(resumed.getVoxelType() == voxel_type::Float);
+    const auto num_voxels = VOXEL_DIM * VOXEL_DIM * VOXEL_DIM;
+    ASSERT_TRUE(std::equal(vc->getVoxelGrid(),
+                           vc->getVoxelGrid() + num_voxels,
+                           resumed.getVoxelGrid()));
+    ASSERT_GT(resumed.createVisualHull(1.0)->GetNumberOfPolys(), 0);
+    boost::filesystem::remove(path);
+
+    ASSERT_THROW(VoxelCarving("missing.grid"), std::runtime_error);
+}
+
+TEST_F(VoxelCarvingTest, SavedGridIsLoadedAgain) {
+
+    const auto path = (boost::filesystem::temp_directory_path() /
+                       boost::filesystem::unique_path()).string();
+    auto q15_vc =
+        ret::make_unique<VoxelCarving>(bounds, VOXEL_DIM, voxel_type::Q15);
+    q15_vc->carveAll(ds->getCameras());
+    ASSERT_TRUE(q15_vc->save(path));
+
+    VoxelCarving loaded(path);
+    ASSERT_TRUE(loaded.getVoxelType() == voxel_type::Q15);
+    const auto num_bytes = q15_vc->getMemoryUsage();
+    ASSERT_EQ(loaded.getMemoryUsage(), num_bytes);
+    ASSERT_EQ(std::memcmp(loaded.getVoxelData(), q15_vc->getVoxelData(),
+                          num_bytes),
+              0);
+    boost::filesystem::remove(path);
+
+    auto narrow = ret::make_unique<VoxelCarving>(bounds, VOXEL_DIM, 2.0f);
+    ASSERT_FALSE(narrow->save(path));
+}
+
+TEST_F(VoxelCarvingTest, MarginKeepsObjectOffGridBorder) {
+
+    // the bounding box is enlarged by 10% in x and y direction, hence no
+    // voxel on the x and y faces of the grid lies inside the object
+    vc->carveAll(ds->getCameras());
+    const auto grid = vc->getVoxelGrid();
+    std::size_t num_inside = 0;
+    for (std::size_t i = 0; i < VOXEL_DIM; ++i) {
+        for (std::size_t j = 0; j < VOXEL_DIM; ++j) {
+            for (std::size_t k = 0; k < VOXEL_DIM; ++k) {
+                const auto value =
+                    grid[k + j * VOXEL_DIM + i * VOXEL_DIM * VOXEL_DIM];
+                num_inside += value > 0.0f ? 1 : 0;
+                if (j == 0 || j + 1 == VOXEL_DIM || k == 0 ||
+                    k + 1 == VOXEL_DIM) {
+                    ASSERT_LE(value, 0.0f);
+                }
+            }
+        }
+    }
+    ASSERT_GT(num_inside, 0u);
+}
@@ -0,0 +1,184 @@
+// Copyright (c) 2015-2016, Kai Wolf
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <memory>
+
+#include <boost/filesystem.hpp>
+#include <gtest/gtest.h>
+#include <vtkDataArray.h>
+#include <vtkPointData.h>
+#include <vtkSmartPointer.h>
+#include <vtkStructuredPoints.h>
+
+#include "rendering/voxel_grid.hpp"
+
+using namespace ret::rendering;
+
+namespace {
+const start_params PARAMS = {-1.0f, -2.0f, -3.0f, 0.5f, 0.5f, 0.5f};
+}
+
+TEST(VoxelGridTest, EmptyHandle) {
+
+    VoxelGrid grid;
+    ASSERT_TRUE(grid.empty());
+    ASSERT_TRUE(grid.getData() == nullptr);
+    ASSERT_EQ(grid.getSizeInBytes(), 0u);
+    ASSERT_EQ(grid.getUseCount(), 0);
+    ASSERT_TRUE(grid.clone().empty());
+    ASSERT_TRUE(CreateVtkArray(grid).GetPointer() == nullptr);
+}
+
+TEST(VoxelGridTest, CopiesShareVoxels) {
+
+    VoxelGrid grid(4, voxel_type::Float, PARAMS);
+    ASSERT_FALSE(grid.empty());
+    ASSERT_EQ(grid.getNumVoxels(), 64u);
+    ASSERT_EQ(grid.getSizeInBytes(), 64u * sizeof(float));
+    ASSERT_FLOAT_EQ(grid.getStartParams().start_y, -2.0f);
+    grid.getVoxels<float>()[5] = 1.0f;
+
+    VoxelGrid copy = grid;
+    ASSERT_EQ(grid.getUseCount(), 2);
+    ASSERT_EQ(copy.getData(), grid.getData());
+    copy.getVoxels<float>()[5] = 2.0f;
+    ASSERT_FLOAT_EQ(grid.getVoxels<float>()[5], 2.0f);
+
+    grid = VoxelGrid();
+    ASSERT_EQ(copy.getUseCount(), 1);
+    ASSERT_FLOAT_EQ(copy.getVoxels<float>()[5], 2.0f);
+}
+
+TEST(VoxelGridTest, CloneCopiesVoxels) {
+
+    VoxelGrid grid(3, voxel_type::Q15, PARAMS);
+    for (std::size_t idx = 0; idx < grid.getNumVoxels(); ++idx) {
+        grid.getVoxels<q15>()[idx] = static_cast<q15>(idx);
+    }
+
+    const VoxelGrid copy = grid.clone();
+    ASSERT_EQ(grid.getUseCount(), 1);
+    ASSERT_EQ(copy.getUseCount(), 1);
+    ASSERT_NE(copy.getData(), grid.getData());
+    ASSERT_TRUE(copy.getVoxelType() == voxel_type::Q15);
+    ASSERT_EQ(copy.getVoxels<q15>()[26], 26);
+}
+
+TEST(VoxelGridTest, AdoptedVoxelsAreReleasedByDeleter) {
+
+    auto released = false;
+    {
+        std::shared_ptr<void> data(new float[8], [&](void* ptr) {
+            delete[] static_cast<float*>(ptr);
+            released = true;
+        });
+        VoxelGrid grid(data, 2, voxel_type::Float, PARAMS);
+        data.reset();
+        ASSERT_EQ(grid.getUseCount(), 1);
+        ASSERT_FALSE(released);
+    }
+    ASSERT_TRUE(released);
+}
+
+TEST(VoxelGridTest, VtkArrayKeepsVoxelsAlive) {
+
+    vtkSmartPointer<vtkStructuredPoints> spoints;
+    const void* data = nullptr;
+    {
+        VoxelGrid grid(8, voxel_type::Float, PARAMS);
+        data    = grid.getData();
+        spoints = CreateStructuredPoints(grid);
+        ASSERT_EQ(grid.getUseCount(), 2);
+    }
+
+    auto scalars = spoints->GetPointData()->GetScalars();
+    ASSERT_EQ(scalars->GetVoidPointer(0), data);
+    ASSERT_EQ(scalars->GetNumberOfTuples(), 8 * 8 * 8);
+    ASSERT_TRUE(CreateVtkArray(VoxelGrid(8, voxel_type::Half, PARAMS))
+                    .GetPointer() == nullptr);
+}
+
+TEST(VoxelGridTest, SavedGridIsMappedAgain) {
+
+    const auto path = boost::filesystem::temp_directory_path() /
+                      boost::filesystem::unique_path();
+    ASSERT_FALSE(SaveVoxelGrid(VoxelGrid(), path.string()));
+
+    VoxelGrid grid(5, voxel_type::Q15, PARAMS);
+    for (std::size_t idx = 0; idx < grid.getNumVoxels(); ++idx) {
+        grid.getVoxels<q15>()[idx] = static_cast<q15>(idx);
+    }
+    ASSERT_TRUE(SaveVoxelGrid(grid, path.string()));
+
+    {
+        auto mapped = MapVoxelGrid(path.string());
+        ASSERT_FALSE(mapped.empty());
+        ASSERT_EQ(mapped.getVoxelDim(), 5u);
+        ASSERT_TRUE(mapped.getVoxelType() == voxel_type::Q15);
+        ASSERT_FLOAT_EQ(mapped.getStartParams().start_z, -3.0f);
+        ASSERT_EQ(mapped.getVoxels<q15>()[124], 124);
+        mapped.getVoxels<q15>()[7] = -7;
+    }
+
+    // changes of a mapped grid are written back to the file
+    ASSERT_EQ(MapVoxelGrid(path.string()).getVoxels<q15>()[7], -7);
+    boost::filesystem::remove(path);
+}
+
+TEST(VoxelGridTest, MappedGridRejectsInvalidFiles) {
+
+    ASSERT_TRUE(MapVoxelGrid("missing.grid").empty());
+
+    const auto path = boost::filesystem::temp_directory_path() /
+                      boost::filesystem::unique_path();
+    {
+        std::ofstream file(path.string(), std::ios::binary);
+        for (auto idx = 0; idx < 32; ++idx) {
+            file << "no voxel grid";
+        }
+    }
+    ASSERT_TRUE(MapVoxelGrid(path.string()).empty());
+
+    auto created =
+        CreateMappedVoxelGrid(path.string(), 16, voxel_type::Float, PARAMS);
+    ASSERT_FALSE(created.empty());
+    ASSERT_EQ(created.getSizeInBytes(), 16u * 16u * 16u * sizeof(float));
+    ASSERT_EQ(boost::filesystem::file_size(path),
+              64u + created.getSizeInBytes());
+    created = VoxelGrid();
+
+    // a dimension of 2^21 overflows the number of bytes to 0
+    {
+        std::fstream file(path.string(),
+                          std::ios::binary | std::ios::in | std::ios::out);
+        const std::uint64_t voxel_dim = 1u << 21;
+        file.seekp(16);
+        file.write(reinterpret_cast<const char*>(&voxel_dim),
+                   sizeof(voxel_dim));
+    }
+    ASSERT_TRUE(MapVoxelGrid(path.string()).empty());
+    ASSERT_TRUE(CreateMappedVoxelGrid(path.string(), 1u << 21,
+                                      voxel_type::Float, PARAMS)
+                    .empty());
+    boost::filesystem::remove(path);
+}
@@ -27,7 +27,7 @@
 #include "common/utils.hpp"
 #include "io/dataset_reader.hpp"
 #include "io/assets_path.hpp"
-#include "filtering/segmentation.hpp"
+#include "filtering/preprocessing.hpp"
 #include "rendering/bounding_box.hpp"
 #include "rendering/voxel_carving.hpp"
 #include "rendering/light_dir_estimation.hpp"
@@ -43,10 +43,7 @@ std::shared_ptr<DataSet> loadDataSet(const std::string &path,
 
     DataSetReader dsr(path);
     auto ds = dsr.load(num_imgs);
-    for (std::size_t i = 0; i < num_imgs; ++i) {
-        ds->getCamera(i).setMask(Binarize(
-            ds->getCamera(i).getImage(), cv::Scalar(0, 0, 30)));
-    }
+    Preprocess(*ds, cv::Scalar(0, 0, 30));
 
     return ds;
 }
@@ -59,9 +56,7 @@ int main() {
     BoundingBox bbox(ds->getCamera(0), ds->getCamera((NUM_IMGS / 4) - 1));
     auto bb_bounds = bbox.getBounds();
     auto vc = ret::make_unique<VoxelCarving>(bb_bounds, VOXEL_DIM);
-    for (const auto &cam : ds->getCameras()) {
-        vc->carve(cam);
-    }
+    vc->carveAll(ds->getCameras());
     auto mesh = vc->createVisualHull();
 
     LightDirEstimation light;
@@ -44,7 +44,7 @@
 #include "common/utils.hpp"
 #include "io/dataset_reader.hpp"
 #include "io/assets_path.hpp"
-#include "filtering/segmentation.hpp"
+#include "filtering/preprocessing.hpp"
 #include "rendering/bounding_box.hpp"
 #include "rendering/mesh_coloring.hpp"
 #include "rendering/mesh_refinement.hpp"
@@ -62,10 +62,7 @@ std::shared_ptr<DataSet> loadDataSet(const std::string &path,
 
     DataSetReader dsr(path);
     auto ds = dsr.load(num_imgs);
-    for (std::size_t i = 0; i < num_imgs; ++i) {
-        ds->getCamera(i).setMask(Binarize(
-            ds->getCamera(i).getImage(), cv::Scalar(0, 0, 30)));
-    }
+    Preprocess(*ds, cv::Scalar(0, 0, 30));
 
     return ds;
 }
@@ -83,7 +80,8 @@ void displayBoundingBox(const bb_bounds& bbox,
     renderer->AddActor(bb_actor);
 }
 
-void displayCamera(Camera& camera, vtkSmartPointer<vtkRenderer> renderer,
+void displayCamera(const Camera& camera,
+                   vtkSmartPointer<vtkRenderer> renderer,
                    double& cam_color) {
 
     auto cam_source = vtkSmartPointer<vtkConeSource>::New();
@@ -93,8 +91,7 @@ void displayCamera(Camera& camera, vtkSmartPointer<vtkRenderer> renderer,
     auto center = camera.getCenter();
     cam_source->SetCenter(center.x, center.y, center.z);
     auto lookat = camera.getDirection();
-    cam_source->SetDirection(lookat.at<float>(0, 0), lookat.at<float>(0, 1),
-                             lookat.at<float>(0, 2));
+    cam_source->SetDirection(lookat[0], lookat[1], lookat[2]);
     auto cam_mapper = vtkSmartPointer<vtkPolyDataMapper>::New();
     cam_mapper->SetInputConnection(cam_source->GetOutputPort());
     auto cam_actor = vtkSmartPointer<vtkActor>::New();
@@ -194,8 +191,8 @@ int main() {
     displayBoundingBox(bb_bounds, renderer);
 
     double cam_color = 1.0;
-    for (auto &camera : ds->getCameras()) {
-        vc->carve(camera);
+    vc->carveAll(ds->getCameras());
+    for (const auto &camera : *ds) {
         displayCamera(camera, renderer, cam_color);
     }
 